@@ -0,0 +1,74 @@
+/*
+ * BusTrace.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusTrace.h>
+
+namespace TEF {
+namespace FurComs {
+
+Trace_Ring::Trace_Ring() :
+		write_seq(0), slots() {
+
+	for(auto &slot : slots) {
+		slot.timestamp.store(0, std::memory_order_relaxed);
+		slot.info.store(0, std::memory_order_relaxed);
+	}
+}
+
+void Trace_Ring::record(uint32_t timestamp, uint8_t from_state, uint8_t to_state, uint8_t detail) {
+	uint32_t seq = write_seq.load(std::memory_order_relaxed);
+	slot_t &slot = slots[seq & (SIZE - 1)];
+
+	// Release stores: readers that see any part of the new entry also see
+	// the write_seq of the entry before, see read().
+	slot.timestamp.store(timestamp, std::memory_order_release);
+	slot.info.store(from_state | (to_state << 8) | (uint32_t(detail) << 16), std::memory_order_release);
+
+	write_seq.store(seq + 1, std::memory_order_release);
+}
+
+size_t Trace_Ring::read(uint32_t &cursor, trace_entry_t *out, size_t max, uint32_t *lost) const {
+	uint32_t head = write_seq.load(std::memory_order_acquire);
+	uint32_t skipped = 0;
+	size_t count = 0;
+
+	if(head - cursor > SIZE) {
+		skipped += head - SIZE - cursor;
+		cursor = head - SIZE;
+	}
+
+	while(count < max && cursor != head) {
+		const slot_t &slot = slots[cursor & (SIZE - 1)];
+
+		uint32_t timestamp = slot.timestamp.load(std::memory_order_acquire);
+		uint32_t info = slot.info.load(std::memory_order_acquire);
+
+		// Once the writer is at cursor + SIZE, this slot may have been reused.
+		uint32_t current = write_seq.load(std::memory_order_relaxed);
+		if(current - cursor >= SIZE) {
+			skipped += current - SIZE + 1 - cursor;
+			cursor = current - SIZE + 1;
+			head = current;
+			continue;
+		}
+
+		out[count].timestamp = timestamp;
+		out[count].from_state = info & 0xFF;
+		out[count].to_state = (info >> 8) & 0xFF;
+		out[count].detail = (info >> 16) & 0xFF;
+
+		count++;
+		cursor++;
+	}
+
+	if(lost != nullptr)
+		*lost += skipped;
+
+	return count;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,41 @@
+/*
+ * CRC.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/CRC.h>
+
+namespace TEF {
+namespace FurComs {
+
+namespace {
+
+// Single-expression constexpr functions and an unrolled initializer keep
+// this legal C++11.
+#define CRC_ENTRIES_4(i) crc_table_entry(i), crc_table_entry(i + 1), crc_table_entry(i + 2), crc_table_entry(i + 3)
+#define CRC_ENTRIES_16(i) CRC_ENTRIES_4(i), CRC_ENTRIES_4(i + 4), CRC_ENTRIES_4(i + 8), CRC_ENTRIES_4(i + 12)
+#define CRC_ENTRIES_64(i) CRC_ENTRIES_16(i), CRC_ENTRIES_16(i + 16), CRC_ENTRIES_16(i + 32), CRC_ENTRIES_16(i + 48)
+
+//! Generated at compile time, ends up as a plain array in flash.
+constexpr uint32_t crc_table[256] = {
+	CRC_ENTRIES_64(0), CRC_ENTRIES_64(64), CRC_ENTRIES_64(128), CRC_ENTRIES_64(192)
+};
+
+#undef CRC_ENTRIES_64
+#undef CRC_ENTRIES_16
+#undef CRC_ENTRIES_4
+
+}
+
+uint32_t crc_update(uint32_t crc, const void *data, size_t length) {
+	const uint8_t *pos = reinterpret_cast<const uint8_t*>(data);
+
+	while(length--)
+		crc = (crc << 8) ^ crc_table[(crc >> 24) ^ *(pos++)];
+
+	return crc;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,346 @@
+/*
+ * Fragments.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/Fragments.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+Fragment_Receiver::Fragment_Receiver(const char *topic) :
+		topic(topic), next(nullptr),
+		buffer(nullptr), buffer_size(0),
+		message_handler(nullptr), message_context(nullptr),
+		fragment_handler(nullptr), fragment_context(nullptr),
+		receiving(false), transfer_id(0), next_sequence(0), offset(0),
+		completed_count(0), dropped_count(0) {
+}
+
+void Fragment_Receiver::set_buffer(void *buffer, size_t size, rx_handler_t handler, void *context) {
+	this->buffer = reinterpret_cast<uint8_t*>(buffer);
+	buffer_size = (buffer == nullptr) ? 0 : size;
+	message_handler = handler;
+	message_context = context;
+}
+
+void Fragment_Receiver::set_fragment_handler(fragment_handler_t handler, void *context) {
+	fragment_handler = handler;
+	fragment_context = context;
+}
+
+void Fragment_Receiver::handle_fragment(const char *topic, uint8_t transfer_id, uint16_t sequence,
+		const void *data, size_t length) {
+	bool last = sequence & FURCOM_FRAGMENT_LAST;
+	sequence &= FURCOM_FRAGMENT_SEQUENCE_MAX;
+
+	uint32_t total = 0;
+	if(last) {
+		if(length < FURCOM_FRAGMENT_TOTAL_LENGTH) {
+			// Drops the message in progress, and the one a first fragment
+			// would have started.
+			dropped_count += (receiving ? 1 : 0) + (sequence == 0 ? 1 : 0);
+			receiving = false;
+			return;
+		}
+
+		auto total_ptr = reinterpret_cast<const uint8_t*>(data);
+		total = total_ptr[0] | (total_ptr[1] << 8) | (total_ptr[2] << 16) | (uint32_t(total_ptr[3]) << 24);
+
+		data = total_ptr + FURCOM_FRAGMENT_TOTAL_LENGTH;
+		length -= FURCOM_FRAGMENT_TOTAL_LENGTH;
+	}
+
+	if(sequence == 0) {
+		if(receiving)
+			dropped_count++;
+
+		receiving = true;
+		this->transfer_id = transfer_id;
+		next_sequence = 0;
+		offset = 0;
+	}
+	else if(!receiving)
+		return;
+	else if(transfer_id != this->transfer_id || sequence != next_sequence) {
+		// A fragment went missing, wait for the next message.
+		receiving = false;
+		dropped_count++;
+		return;
+	}
+
+	// A fragment was cut short on the way, i.e. by a receiver with
+	// shorter frames. The last fragment is not handed out, so that
+	// fragment handlers never see the message completed.
+	if(last && offset + length != total) {
+		receiving = false;
+		dropped_count++;
+		return;
+	}
+
+	if(fragment_handler != nullptr)
+		fragment_handler(fragment_context, topic, offset, data, length, last);
+
+	if(buffer != nullptr) {
+		// The buffer may have been installed mid-message, behind offset.
+		if(offset > buffer_size || length > buffer_size - offset) {
+			receiving = false;
+			dropped_count++;
+			return;
+		}
+
+		memcpy(buffer + offset, data, length);
+	}
+
+	offset += length;
+	next_sequence++;
+
+	if(!last)
+		return;
+
+	receiving = false;
+	completed_count++;
+
+	if(buffer != nullptr && message_handler != nullptr)
+		message_handler(message_context, topic, buffer, offset);
+}
+
+Fragment_Sender::Fragment_Sender(Protocol_Core &handler, const char *topic, tx_priority_t priority) :
+		handler(handler), topic(topic), priority(priority),
+		transfer_id(0), sequence(0), transfer_length(0), finished(true),
+		message(nullptr), message_length(0), message_position(0),
+		busy(false), failed(false), in_flight(0), pump_requests(0),
+		done_handler(nullptr), done_context(nullptr) {
+}
+
+bool Fragment_Sender::get_fragment_limits(size_t &max_length, size_t &max_encoded) {
+	Protocol_Core::packet_topic_t packet_topic;
+	handler.prepare_topic(topic, packet_topic);
+
+	bool with_crc = handler.get_crc();
+
+	// Every fragment leaves room for the message length of the last one.
+	size_t overhead = FURCOM_FRAGMENT_HEADER_LENGTH + FURCOM_FRAGMENT_TOTAL_LENGTH + packet_topic.length;
+	size_t encoded_overhead = 2*FURCOM_FRAGMENT_HEADER_LENGTH + 2*FURCOM_FRAGMENT_TOTAL_LENGTH
+			+ slip_encoded_length(packet_topic.data, packet_topic.length)
+			+ (with_crc ? 1 + 2*FURCOM_CRC_LENGTH : 0);
+
+	max_length = handler.get_max_packet_length(with_crc);
+	// Keeps fragments small enough to always fit into the queue eventually.
+	max_encoded = handler.get_tx_queue(priority).max_safe_reservation(true);
+
+	if(max_length <= overhead || max_encoded < encoded_overhead + 2)
+		return false;
+
+	max_length -= overhead;
+	max_encoded -= encoded_overhead;
+	return true;
+}
+
+size_t Fragment_Sender::fit_fragment(const uint8_t *data, size_t length,
+		size_t max_length, size_t max_encoded) {
+	size_t chunk = 0;
+	size_t encoded = 0;
+
+	while(chunk < length && chunk < max_length) {
+		encoded += (data[chunk] == FURCOM_END || data[chunk] == FURCOM_ESCAPE) ? 2 : 1;
+		if(encoded > max_encoded)
+			break;
+
+		chunk++;
+	}
+
+	return chunk;
+}
+
+bool Fragment_Sender::queue_fragment(const void *data, size_t length, bool last,
+		tx_done_handler_t handler, void *context) {
+	if(sequence > FURCOM_FRAGMENT_SEQUENCE_MAX)
+		return false;
+
+	uint16_t sequence_field = sequence | (last ? FURCOM_FRAGMENT_LAST : 0);
+	uint8_t header[FURCOM_FRAGMENT_HEADER_LENGTH] = {
+		FURCOM_MARKER_FRAGMENT, transfer_id, uint8_t(sequence_field), uint8_t(sequence_field >> 8)
+	};
+
+	uint32_t total = transfer_length + length;
+	uint8_t total_field[FURCOM_FRAGMENT_TOTAL_LENGTH] = {
+		uint8_t(total), uint8_t(total >> 8), uint8_t(total >> 16), uint8_t(total >> 24)
+	};
+
+	if(!this->handler.queue_packet(header, sizeof(header), topic,
+			total_field, last ? sizeof(total_field) : 0, data, length,
+			priority, handler, context))
+		return false;
+
+	sequence++;
+	transfer_length = total;
+	return true;
+}
+
+void Fragment_Sender::begin() {
+	transfer_id++;
+	sequence = 0;
+	transfer_length = 0;
+	finished = false;
+}
+
+size_t Fragment_Sender::write(const void *data, size_t length, bool last) {
+	auto data_ptr = reinterpret_cast<const uint8_t*>(data);
+	size_t written = 0;
+
+	size_t max_length, max_encoded;
+	if(!get_fragment_limits(max_length, max_encoded))
+		return 0;
+
+	while(!finished && (written < length || last)) {
+		size_t chunk = fit_fragment(data_ptr + written, length - written, max_length, max_encoded);
+
+		bool is_last = last && (written + chunk == length);
+		if(!queue_fragment(data_ptr + written, chunk, is_last, nullptr, nullptr))
+			break;
+
+		written += chunk;
+		if(is_last)
+			finished = true;
+	}
+
+	return written;
+}
+
+bool Fragment_Sender::write_wait(const void *data, size_t length, bool last, uint32_t timeout) {
+	auto data_ptr = reinterpret_cast<const uint8_t*>(data);
+
+	size_t max_length, max_encoded;
+	if(finished || !get_fragment_limits(max_length, max_encoded))
+		return false;
+
+	uint32_t start_tick = handler.get_tick();
+
+	while(true) {
+		size_t written = write(data_ptr, length, last);
+		if(written > 0) {
+			data_ptr += written;
+			length -= written;
+			start_tick = handler.get_tick();
+		}
+
+		if(length == 0 && (finished || !last))
+			return true;
+		if(sequence > FURCOM_FRAGMENT_SEQUENCE_MAX)
+			return false;
+
+		uint32_t elapsed = handler.get_tick() - start_tick;
+		if(elapsed >= timeout)
+			return false;
+
+		if(!handler.wait_tx_space(timeout - elapsed))
+			return false;
+	}
+}
+
+bool Fragment_Sender::send(const void *data, size_t length,
+		tx_done_handler_t handler, void *context) {
+	bool expected = false;
+	if(!busy.compare_exchange_strong(expected, true))
+		return false;
+
+	begin();
+
+	message = reinterpret_cast<const uint8_t*>(data);
+	message_length = length;
+	message_position = 0;
+	failed = false;
+	done_handler = handler;
+	done_context = context;
+
+	pump();
+
+	// Nothing was queued, so no completion can come in anymore.
+	if(sequence == 0) {
+		finished = true;
+		busy = false;
+		return false;
+	}
+
+	return true;
+}
+
+void Fragment_Sender::queue_message() {
+	if(failed || finished)
+		return;
+
+	size_t max_length, max_encoded;
+	if(!get_fragment_limits(max_length, max_encoded))
+		return;
+
+	while(!finished && in_flight < FURCOM_FRAGMENT_WINDOW) {
+		if(sequence > FURCOM_FRAGMENT_SEQUENCE_MAX) {
+			failed = true;
+			return;
+		}
+
+		size_t chunk = fit_fragment(message + message_position, message_length - message_position,
+				max_length, max_encoded);
+
+		bool last = (message_position + chunk == message_length);
+
+		// Counted beforehand, the completion may come in right away.
+		in_flight++;
+		if(!queue_fragment(message + message_position, chunk, last,
+				Fragment_Sender::handle_fragment_done, this)) {
+			in_flight--;
+			return;
+		}
+
+		message_position += chunk;
+		if(last)
+			finished = true;
+	}
+}
+
+void Fragment_Sender::pump() {
+	if(!busy)
+		return;
+
+	// Whoever is pumping already, possibly the thread this interrupted,
+	// picks up the request.
+	if(pump_requests.fetch_add(1) != 0)
+		return;
+
+	uint32_t requests = 1;
+	do {
+		queue_message();
+		requests = pump_requests.fetch_sub(requests) - requests;
+	} while(requests != 0);
+
+	check_done();
+}
+
+void Fragment_Sender::check_done() {
+	if(in_flight != 0 || !(finished || failed))
+		return;
+
+	bool expected = true;
+	if(!busy.compare_exchange_strong(expected, false))
+		return;
+
+	if(done_handler != nullptr)
+		done_handler(done_context, !failed);
+}
+
+void Fragment_Sender::handle_fragment_done(void *context, bool sent) {
+	auto sender = reinterpret_cast<Fragment_Sender*>(context);
+
+	if(!sent)
+		sender->failed = true;
+
+	sender->in_flight--;
+	sender->pump();
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,231 @@
+/*
+ * PacketDispatcher.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/PacketDispatcher.h>
+#include <FurComs/Fragments.h>
+#include <FurComs/StateTopics.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+Packet_Dispatcher::Packet_Dispatcher() :
+		subscriptions(), topic_ids(),
+		crc_error_count(0),
+		fragment_receivers(nullptr),
+		on_rx(nullptr), on_rx_id(nullptr) {
+
+	subscriptions.subscribe(FURCOM_TOPIC_ID_ANNOUNCE, Packet_Dispatcher::handle_topic_announce, this);
+}
+
+bool Packet_Dispatcher::check_crc(const char *frame, size_t length) {
+	if(length < FURCOM_CRC_OVERHEAD) {
+		crc_error_count++;
+		return false;
+	}
+
+	size_t body_length = length - FURCOM_CRC_OVERHEAD;
+	uint32_t received = crc_read_trailer(reinterpret_cast<const uint8_t*>(frame) + 1 + body_length);
+
+	if(compute_crc(frame + 1, body_length) != received) {
+		crc_error_count++;
+		return false;
+	}
+
+	return true;
+}
+
+void Packet_Dispatcher::dispatch_frame(char *frame, size_t length, bool crc_checked) {
+	if(length > 0 && uint8_t(frame[0]) == FURCOM_MARKER_ROUTED) {
+		if(length < FURCOM_ROUTED_HEADER_LENGTH)
+			return;
+
+		frame += FURCOM_ROUTED_HEADER_LENGTH;
+		length -= FURCOM_ROUTED_HEADER_LENGTH;
+	}
+
+	if(length > 0 && uint8_t(frame[0]) == FURCOM_MARKER_CRC) {
+		if(!crc_checked && !check_crc(frame, length))
+			return;
+		if(length < FURCOM_CRC_OVERHEAD)
+			return;
+
+		// The first trailer byte is then free for the terminator.
+		frame++;
+		length -= FURCOM_CRC_OVERHEAD;
+	}
+
+	if(length == 0 || uint8_t(frame[0]) != FURCOM_MARKER_BATCH) {
+		// A frame without separator is all topic, its terminator
+		// (added past the end) then serves as separator.
+		if(length > 0 && uint8_t(frame[0]) != FURCOM_MARKER_TOPIC_ID
+				&& uint8_t(frame[0]) != FURCOM_MARKER_FRAGMENT
+				&& memchr(frame, 0, length) == nullptr) {
+			frame[length] = 0;
+			length++;
+		}
+
+		dispatch_packet(frame, length);
+		return;
+	}
+
+	size_t pos = 1;
+	while(pos < length) {
+		size_t record_length = uint8_t(frame[pos++]);
+		if(record_length > length - pos)
+			break;
+
+		dispatch_packet(frame + pos, record_length);
+		pos += record_length;
+	}
+}
+
+void Packet_Dispatcher::dispatch_packet(const char *packet, size_t length) {
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_ROUTED) {
+		if(length < FURCOM_ROUTED_HEADER_LENGTH)
+			return;
+
+		packet += FURCOM_ROUTED_HEADER_LENGTH;
+		length -= FURCOM_ROUTED_HEADER_LENGTH;
+	}
+
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_CRC) {
+		if(!check_crc(packet, length))
+			return;
+
+		packet++;
+		length -= FURCOM_CRC_OVERHEAD;
+	}
+
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_FRAGMENT) {
+		dispatch_fragment(packet, length);
+		return;
+	}
+
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_TOPIC_ID) {
+		topic_id_t id;
+		size_t id_length = Topic_Dictionary::decode_id(
+				reinterpret_cast<const uint8_t*>(packet) + 1, length - 1, id);
+		if(id_length == 0)
+			return;
+
+		const char *data_ptr = packet + 1 + id_length;
+		size_t data_length = length - 1 - id_length;
+
+		if(on_rx_id != nullptr)
+			on_rx_id(id, data_ptr, data_length);
+
+		const char *topic = topic_ids.find_topic(id);
+		if(topic != nullptr)
+			dispatch_message(topic, data_ptr, data_length);
+		return;
+	}
+
+	const char *separator = reinterpret_cast<const char*>(memchr(packet, 0, length));
+	if(separator == nullptr)
+		return;
+
+	dispatch_message(packet, separator + 1, packet + length - (separator + 1));
+}
+
+void Packet_Dispatcher::dispatch_fragment(const char *packet, size_t length) {
+	if(length < FURCOM_FRAGMENT_HEADER_LENGTH || fragment_receivers == nullptr)
+		return;
+
+	uint8_t transfer_id = packet[1];
+	uint16_t sequence = uint8_t(packet[2]) | (uint8_t(packet[3]) << 8);
+
+	packet += FURCOM_FRAGMENT_HEADER_LENGTH;
+	length -= FURCOM_FRAGMENT_HEADER_LENGTH;
+
+	const char *topic;
+	const char *data_ptr;
+
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_TOPIC_ID) {
+		topic_id_t id;
+		size_t id_length = Topic_Dictionary::decode_id(
+				reinterpret_cast<const uint8_t*>(packet) + 1, length - 1, id);
+		if(id_length == 0)
+			return;
+
+		topic = topic_ids.find_topic(id);
+		if(topic == nullptr)
+			return;
+
+		data_ptr = packet + 1 + id_length;
+	}
+	else {
+		const char *separator = reinterpret_cast<const char*>(memchr(packet, 0, length));
+		if(separator == nullptr)
+			return;
+
+		topic = packet;
+		data_ptr = separator + 1;
+	}
+
+	for(auto receiver = fragment_receivers; receiver != nullptr; receiver = receiver->next) {
+		if(strcmp(receiver->topic, topic) == 0)
+			receiver->handle_fragment(topic, transfer_id, sequence, data_ptr, packet + length - data_ptr);
+	}
+}
+
+void Packet_Dispatcher::dispatch_message(const char *topic, const void *data, size_t length) {
+	subscriptions.dispatch(topic, data, length);
+	if(on_rx != nullptr)
+		on_rx(topic, data, length);
+}
+
+bool Packet_Dispatcher::subscribe(const char *pattern, rx_handler_t handler, void *context) {
+	return subscriptions.subscribe(pattern, handler, context);
+}
+bool Packet_Dispatcher::unsubscribe(const char *pattern, rx_handler_t handler, void *context) {
+	return subscriptions.unsubscribe(pattern, handler, context);
+}
+
+bool Packet_Dispatcher::add_topic_id(topic_id_t id, const char *topic) {
+	return topic_ids.add(id, topic, strlen(topic), false);
+}
+int Packet_Dispatcher::add_topic_ids(const topic_id_def_t *table, size_t count) {
+	return topic_ids.add_table(table, count);
+}
+
+void Packet_Dispatcher::add_fragment_receiver(Fragment_Receiver &receiver) {
+	receiver.next = fragment_receivers;
+	fragment_receivers = &receiver;
+}
+void Packet_Dispatcher::remove_fragment_receiver(Fragment_Receiver &receiver) {
+	for(auto link = &fragment_receivers; *link != nullptr; link = &(*link)->next) {
+		if(*link == &receiver) {
+			*link = receiver.next;
+			receiver.next = nullptr;
+			return;
+		}
+	}
+}
+
+bool Packet_Dispatcher::add_state_cache(State_Cache_Base &cache) {
+	return subscribe(cache.topic, State_Cache_Base::handle_message, &cache);
+}
+bool Packet_Dispatcher::remove_state_cache(State_Cache_Base &cache) {
+	return unsubscribe(cache.topic, State_Cache_Base::handle_message, &cache);
+}
+
+void Packet_Dispatcher::handle_topic_announce(void *context, const char *topic, const void *data, size_t length) {
+	auto dispatcher = reinterpret_cast<Packet_Dispatcher*>(context);
+	auto data_ptr = reinterpret_cast<const uint8_t*>(data);
+	(void)topic;
+
+	topic_id_t id;
+	size_t id_length = Topic_Dictionary::decode_id(data_ptr, length, id);
+	if(id_length == 0 || id_length == length)
+		return;
+
+	dispatcher->topic_ids.add(id, reinterpret_cast<const char*>(data_ptr + id_length), length - id_length, true);
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
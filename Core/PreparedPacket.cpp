@@ -0,0 +1,105 @@
+/*
+ * PreparedPacket.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/PreparedPacket.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+Prepared_Packet_Base::Prepared_Packet_Base(Protocol_Core &handler, const char *topic, tx_priority_t priority,
+		uint8_t *payload, size_t payload_length, uint8_t *encoded, size_t encoded_size) :
+		handler(handler), topic(topic), priority(priority),
+		payload(payload), payload_length(payload_length),
+		encoded(encoded), encoded_size(encoded_size),
+		prefix_length(0), encoded_length(0),
+		prefix_crc(false), prefix_topic_ids(false), prefix_crc_state(FURCOM_CRC_INIT),
+		dirty_from(0) {
+}
+
+bool Prepared_Packet_Base::build_prefix() {
+	Protocol_Core::packet_topic_t packet_topic;
+	handler.prepare_topic(topic, packet_topic);
+
+	prefix_crc = handler.get_crc();
+	prefix_topic_ids = handler.get_topic_ids();
+
+	if(packet_topic.length + payload_length > handler.get_max_packet_length(prefix_crc))
+		return false;
+	if(1 + 2*packet_topic.length + 2*payload_length > encoded_size)
+		return false;
+
+	size_t length = 0;
+	if(prefix_crc) {
+		encoded[length++] = FURCOM_MARKER_CRC;
+		prefix_crc_state = crc_update(FURCOM_CRC_INIT, packet_topic.data, packet_topic.length);
+	}
+
+	length += slip_encode(packet_topic.data, packet_topic.length, encoded + length);
+
+	prefix_length = length;
+	// The payload moved along with the end of the prefix.
+	dirty_from = 0;
+
+	return true;
+}
+
+void Prepared_Packet_Base::encode_payload() {
+	// Bytes before dirty_from are unchanged, and so is their encoding.
+	size_t start = prefix_length + slip_encoded_length(payload, dirty_from);
+
+	encoded_length = start + slip_encode(payload + dirty_from, payload_length - dirty_from, encoded + start);
+	dirty_from = payload_length;
+}
+
+bool Prepared_Packet_Base::set(size_t offset, const void *data, size_t length) {
+	if(offset > payload_length || length > payload_length - offset)
+		return false;
+
+	if(memcmp(payload + offset, data, length) == 0)
+		return true;
+
+	memcpy(payload + offset, data, length);
+	if(offset < dirty_from)
+		dirty_from = offset;
+
+	return true;
+}
+
+bool Prepared_Packet_Base::send(tx_done_handler_t done_handler, void *context) {
+	if(prefix_length == 0 || prefix_crc != handler.get_crc() || prefix_topic_ids != handler.get_topic_ids()) {
+		if(!build_prefix()) {
+			prefix_length = 0;
+			return false;
+		}
+	}
+
+	if(dirty_from < payload_length)
+		encode_payload();
+
+	size_t length = encoded_length;
+
+	uint8_t trailer[FURCOM_CRC_LENGTH];
+	if(prefix_crc) {
+		crc_write_trailer(crc_update(prefix_crc_state, payload, payload_length), trailer);
+		length += slip_encoded_length(trailer, FURCOM_CRC_LENGTH);
+	}
+
+	tx_reservation_t reservation;
+	if(!handler.get_tx_queue(priority).reserve(reservation, length, length, done_handler, context))
+		return false;
+
+	TX_Queue::add_encoded(reservation, encoded, encoded_length);
+	if(prefix_crc)
+		TX_Queue::add_data(reservation, trailer, FURCOM_CRC_LENGTH);
+
+	handler.commit_packet(reservation);
+	return true;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,1141 @@
+/*
+ * ProtocolCore.cpp
+ *
+ *  Created on: 9 Apr 2020
+ *      Author: xasin
+ */
+
+#include <FurComs/ProtocolCore.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+Protocol_Core::Protocol_Core(Transport &transport, const handler_storage_t &storage) :
+		transport(&transport),
+		state(IDLE),
+		rx_arbitration_counter(0),
+		arbitration_loss_position(0),
+		tx_queues(),
+		tx_legacy_reservation(), tx_active_queue(nullptr),
+		tx_aging_max(0), tx_aging_rounds(),
+		tx_batching(false), tx_batch_count(1), tx_batch_buffer(storage.tx_batch_buffer),
+		tx_raw_ptr(nullptr), tx_raw_length(0),
+		tx_frame_ptr(nullptr), tx_frame_length(0),
+		rx_buffer_num(-1), rx_dispatch_num(-1), rx_pool(),
+		max_frame_length(storage.frame_length),
+		baudrate(250000),
+		idle_reset_bits(FURCOM_IDLE_RESET_BITS), idle_tx_bits(FURCOM_IDLE_TX_BITS),
+		idle_reset_ticks(0), idle_tx_ticks(0), idle_tx_counts(0),
+		rx_timeout_active(false), line_stale(false), line_free(false),
+		line_stale_tick(0), line_free_count(0),
+		last_active_tick(0),
+		had_received_escape(false),
+		rx_dma_read_pos(0), rx_dma_active(false),
+		tx_topic_ids(false), tx_crc(false),
+		frame_handler(nullptr), frame_context(nullptr),
+		rx_dropping(false),
+		tx_services(nullptr),
+		rx_filter_enabled(false), rx_filtering(false), rx_filtered(false),
+		rx_filter_pos(nullptr), rx_filter_skip(0), rx_filter(),
+		stats(), state_enter_time(0), trace(nullptr) {
+
+	tx_arbitration._latency_a = 0xFF;
+	tx_arbitration._latency_b = 0xFF;
+	set_chip_id(0xFFF);
+
+	set_priority(-60, PRIO_URGENT);
+	set_priority(-30, PRIO_HIGH);
+	set_priority(100, PRIO_NORMAL);
+	tx_queues[PRIO_BULK].arbitration_priority = 0xFF;
+
+	for(int i = 0; i < PRIO_CLASS_NUM; i++)
+		tx_queues[i].set_storage(storage.tx_data + i*storage.tx_queue_size, storage.tx_queue_size);
+
+	rx_pool.set_storage(storage.rx_buffers, storage.rx_ready, storage.rx_buffer_count,
+			storage.rx_data, max_frame_length);
+}
+
+void Protocol_Core::start() {
+	rx_timeout_active = transport->has_rx_timeout();
+	update_idle_timing();
+
+	last_active_tick = get_tick();
+
+	// Nothing was received yet, so the receiver timeout will not fire.
+	// Start out as if it just had, the TX idle time still applies.
+	line_stale = rx_timeout_active;
+	line_free = false;
+	line_stale_tick = last_active_tick;
+	line_free_count = get_timer_count() + idle_tx_counts;
+
+	state_enter_time = get_trace_time();
+
+	transport->init();
+	if(rx_timeout_active)
+		transport->set_rx_timeout(idle_reset_bits);
+
+	update_rx_mode();
+}
+
+void Protocol_Core::update_idle_timing() {
+	auto convert = [this](uint32_t bits, uint32_t rate) {
+		return uint32_t((uint64_t(bits) * rate + baudrate - 1) / baudrate);
+	};
+
+	idle_reset_ticks = convert(idle_reset_bits, get_tick_rate());
+
+	// With a receiver timeout, only the time after it fired needs counting.
+	if(rx_timeout_active) {
+		idle_tx_ticks  = convert(idle_tx_bits - idle_reset_bits, get_tick_rate());
+		idle_tx_counts = convert(idle_tx_bits - idle_reset_bits, get_timer_rate());
+	}
+	else
+		idle_tx_ticks = convert(idle_tx_bits, get_tick_rate());
+}
+
+void Protocol_Core::mark_line_active() {
+	// Data after the reset idle time starts over, so that the next
+	// 0x00 counts as START. See handler_state_t.
+	if(rx_timeout_active) {
+		if(line_stale)
+			set_state(IDLE);
+
+		line_stale = false;
+		line_free = false;
+		return;
+	}
+
+	uint32_t tick = get_tick();
+	if(tick - last_active_tick > idle_reset_ticks)
+		set_state(IDLE);
+
+	last_active_tick = tick;
+}
+
+void Protocol_Core::process_rx() {
+	while((rx_dispatch_num = rx_pool.pop_ready()) >= 0) {
+		rx_buffer_t &buffer = rx_pool[rx_dispatch_num];
+
+		*buffer.data_end = 0;
+
+		char *frame = buffer.raw_data;
+		size_t length = buffer.data_end - frame;
+
+		if(frame_handler != nullptr)
+			frame_handler(frame_context, *this, frame, length);
+
+		// CRCs were checked by the ISR already.
+		dispatch_frame(frame, length, true);
+
+		// Stays out of the free list while loaned, see loan_rx().
+		rx_pool.release(rx_dispatch_num);
+	}
+}
+
+uint32_t Protocol_Core::process_tx() {
+	uint32_t service_delay = TX_WAIT_FOREVER;
+	for(tx_service_t *service = tx_services; service != nullptr; service = service->next) {
+		uint32_t delay = service->handler(service->context, get_tick());
+		if(delay < service_delay)
+			service_delay = delay;
+	}
+
+	if(get_tx_pending() == 0 || start_tx())
+		return service_delay;
+
+	uint32_t tx_delay = get_tx_delay();
+	return (tx_delay < service_delay) ? tx_delay : service_delay;
+}
+
+uint32_t Protocol_Core::get_tx_delay() {
+	// osThreadFlagsWait() and the like wait for a number of tick
+	// interrupts, so a full tick is added to never wake up too early.
+	if(rx_timeout_active) {
+		// TRANSPORT_RX_TIMEOUT will call notify_tx() once the line goes quiet.
+		if(!line_stale)
+			return TX_WAIT_FOREVER;
+
+		int32_t remaining = line_free_count - get_timer_count();
+		if(remaining <= 0)
+			return 1;
+
+		uint32_t timer_rate = get_timer_rate();
+		return uint32_t((uint64_t(remaining) * get_tick_rate() + timer_rate - 1) / timer_rate) + 1;
+	}
+
+	uint32_t elapsed = get_tick() - last_active_tick;
+	if(elapsed > idle_tx_ticks)
+		return 1;
+
+	return idle_tx_ticks - elapsed + 1;
+}
+
+void Protocol_Core::handle_isr() {
+	uint8_t rx_byte = 0;
+	uint32_t events = transport->poll_events(rx_byte);
+
+	if(events & TRANSPORT_RX_SPAN)
+		process_rx_dma();
+
+	if(events & TRANSPORT_RX_TIMEOUT) {
+		line_stale = true;
+		line_free = false;
+		line_stale_tick = get_tick();
+		line_free_count = get_timer_count() + idle_tx_counts;
+
+		if(get_tx_pending())
+			notify_tx();
+	}
+
+	if(events & TRANSPORT_RX)
+		rx_single(rx_byte);
+
+	if(events & TRANSPORT_TX_READY)
+		tx_single();
+
+	if(events & TRANSPORT_TX_DONE)
+		tx_dma_done();
+}
+
+int Protocol_Core::get_missmatch_pos(uint8_t a, uint8_t b) {
+	for(int i=8; i > 0; i--) {
+		if((0x80 & a) != (0x80 & b))
+			return i;
+		a <<= 1;
+		b <<= 1;
+	}
+
+	return 0;
+}
+
+void Protocol_Core::set_state(handler_state_t new_state, uint8_t detail) {
+	if(new_state == state)
+		return;
+
+	uint32_t now = get_trace_time();
+	stats.state_time[state] += uint32_t(now - state_enter_time);
+	state_enter_time = now;
+
+	if(trace != nullptr)
+		trace->record(now, state, new_state, detail);
+
+	state = new_state;
+}
+
+void Protocol_Core::raw_start_tx(const void *data_ptr, size_t length) {
+	tx_raw_ptr = reinterpret_cast<const uint8_t*>(data_ptr);
+	tx_raw_length = length;
+
+	transport->set_tx_irq(true);
+}
+
+int Protocol_Core::get_tx_pending() const {
+	int pending = 0;
+	for(auto &queue : tx_queues)
+		pending += queue.get_packet_count();
+
+	return pending;
+}
+
+uint8_t Protocol_Core::get_aged_priority(int prio_class) const {
+	uint8_t priority = tx_queues[prio_class].arbitration_priority;
+
+	// Stay behind the next more urgent class.
+	int limit = (prio_class == 0) ? 0 : tx_queues[prio_class - 1].arbitration_priority;
+
+	// Every step clears the lowest set bit above the always-set bit 0.
+	// Each level is then a bit-subset of all lower ones, so the wired-AND
+	// of the bus is the most aged level and all its nodes match it.
+	for(int i = 0; i < tx_aging_rounds[prio_class]; i++) {
+		uint8_t aged = priority & (priority - 2);
+		if(aged == priority || aged <= limit)
+			break;
+
+		priority = aged;
+	}
+
+	return priority;
+}
+
+bool Protocol_Core::select_tx_queue() {
+	for(auto &queue : tx_queues) {
+		if(queue.get_packet_count() == 0)
+			continue;
+
+		// Skip classes whose oldest frame is still being written.
+		// It is only claimed once arbitration is won, see load_frame(),
+		// so it may be rewritten meanwhile.
+		if(!queue.has_frame())
+			continue;
+
+		tx_active_queue = &queue;
+		tx_arbitration.priority = get_aged_priority(&queue - tx_queues);
+		return true;
+	}
+
+	tx_active_queue = nullptr;
+	return false;
+}
+
+void Protocol_Core::load_frame() {
+	tx_frame_length = 0;
+
+	// Should the frame be in the middle of a reopen(), or have been
+	// dropped, the won arbitration is closed with an empty frame.
+	if(!tx_active_queue->peek_frame(tx_frame_ptr, tx_frame_length)) {
+		tx_batch_buffer[0] = FURCOM_END;
+		tx_frame_ptr = tx_batch_buffer;
+		tx_frame_length = 1;
+		tx_batch_count = 0;
+		return;
+	}
+
+	tx_batch_count = 1;
+	if(tx_batching)
+		build_batch();
+}
+
+bool Protocol_Core::build_batch() {
+	static_assert(FURCOM_BATCH_RECORD_MAX < FURCOM_ESCAPE, "Batch record length bytes must not need escaping!");
+
+	uint8_t *out = tx_batch_buffer;
+	size_t decoded_total = 1;
+	int count = 0;
+
+	*(out++) = FURCOM_MARKER_BATCH;
+
+	const uint8_t *ptr = tx_frame_ptr;
+	size_t length = tx_frame_length;
+
+	do {
+		// Queued frames are complete, including their FURCOM_END.
+		size_t encoded = length - 1;
+		size_t decoded = slip_decoded_length(ptr, encoded);
+
+		if(decoded > FURCOM_BATCH_RECORD_MAX || ptr[0] == FURCOM_MARKER_BATCH
+				|| decoded_total + 1 + decoded > max_frame_length) {
+			// Frames behind the head were claimed by peek_next(), hand
+			// them back so they can still be reopened until sent.
+			if(count > 0)
+				tx_active_queue->unpeek_next();
+			break;
+		}
+
+		*(out++) = decoded;
+		memcpy(out, ptr, encoded);
+		out += encoded;
+
+		decoded_total += 1 + decoded;
+		count++;
+	} while(tx_active_queue->peek_next(ptr, length));
+
+	if(count < 2)
+		return false;
+
+	*(out++) = FURCOM_END;
+
+	tx_frame_ptr = tx_batch_buffer;
+	tx_frame_length = out - tx_batch_buffer;
+	tx_batch_count = count;
+
+	return true;
+}
+
+void Protocol_Core::start_frame_tx() {
+	if(!transport->has_dma_tx()) {
+		transport->set_tx_irq(true);
+		return;
+	}
+	// Let the arbitration bytes finish first, tx_single() will call back in.
+	if(tx_raw_length)
+		return;
+
+	transport->start_dma_tx(tx_frame_ptr, tx_frame_length);
+}
+
+void Protocol_Core::finish_frame() {
+	// Nothing to release after an empty frame, see load_frame().
+	if(tx_batch_count > 0) {
+		tx_active_queue->release_frame();
+
+		stats.frames_sent++;
+		tx_aging_rounds[tx_active_queue - tx_queues] = 0;
+	}
+
+	for(int i = 1; i < tx_batch_count; i++) {
+		const uint8_t *ptr;
+		size_t length;
+
+		tx_active_queue->peek_frame(ptr, length);
+		tx_active_queue->release_frame();
+	}
+	stats.packets_sent += tx_batch_count;
+
+	// Frames flush_tx() dropped meanwhile no longer count as pending,
+	// so they would otherwise hold their space until the next frame.
+	tx_active_queue->release_dropped();
+
+	tx_batch_count = 1;
+
+	notify_tx_space();
+
+	if(state == SENDING)
+		set_state(SENDING_COMPLETE);
+}
+
+void Protocol_Core::tx_dma_done() {
+	finish_frame();
+}
+
+void Protocol_Core::handle_stop_char() {
+	switch(state) {
+	case RECEIVING: {
+		set_state(IDLE);
+
+		if(rx_dropping) {
+			if(rx_filtered)
+				stats.rx_filtered++;
+			else
+				stats.rx_overruns++;
+			rx_dropping = false;
+		}
+		else {
+			rx_buffer_t &buffer = rx_pool[rx_buffer_num];
+			size_t length = buffer.data_end - buffer.raw_data;
+
+			// One byte past max_frame_length was kept to tell cut off
+			// frames apart, the terminator takes its place.
+			if(length > max_frame_length) {
+				stats.rx_truncated++;
+				length = max_frame_length;
+				buffer.data_end = buffer.raw_data + length;
+			}
+
+			stats.frames_received++;
+			stats.rx_decoded_bytes += length;
+
+			if(!check_rx_crc(buffer))
+				stats.rx_crc_errors++;
+			else {
+				rx_pool.push_ready(rx_buffer_num);
+				rx_buffer_num = -1;
+
+				notify_rx();
+			}
+		}
+
+		if(get_tx_pending())
+			transport->write_byte(0);
+	}
+	break;
+
+	case PARTICIPATING_ARBITRATION:
+	case WAITING_ARBITRATION:
+	case IDLE:
+		rx_arbitration_counter = 0;
+		arbitration_loss_position = 0;
+
+		if(select_tx_queue()) {
+			raw_start_tx(&tx_arbitration, 4);
+
+			stats.arbitration_attempts++;
+			set_state(PARTICIPATING_ARBITRATION);
+		}
+		else {
+			set_state(WAITING_ARBITRATION);
+		}
+	break;
+
+	case SENDING_COMPLETE:
+	case SENDING: {
+		// With DMA, the STOP may be received before TRANSPORT_TX_DONE
+		// released the frame, which must then not count as pending.
+		int in_flight = (state == SENDING) ? tx_batch_count : 0;
+
+		set_state(IDLE);
+		if(get_tx_pending() > in_flight)
+			transport->write_byte(0);
+	}
+	break;
+	}
+
+	update_rx_mode();
+}
+
+bool Protocol_Core::check_rx_crc(const rx_buffer_t &buffer) {
+	const char *frame = buffer.raw_data;
+	size_t length = buffer.data_end - frame;
+
+	// Routers keep the CRC of the original frame behind their header.
+	if(length >= FURCOM_ROUTED_HEADER_LENGTH && uint8_t(frame[0]) == FURCOM_MARKER_ROUTED) {
+		frame += FURCOM_ROUTED_HEADER_LENGTH;
+		length -= FURCOM_ROUTED_HEADER_LENGTH;
+	}
+
+	if(length == 0 || uint8_t(frame[0]) != FURCOM_MARKER_CRC)
+		return true;
+	if(length < FURCOM_CRC_OVERHEAD)
+		return false;
+
+	size_t body_length = length - FURCOM_CRC_OVERHEAD;
+	uint32_t received = crc_read_trailer(reinterpret_cast<const uint8_t*>(frame) + 1 + body_length);
+
+	return compute_rx_crc(frame + 1, body_length) == received;
+}
+
+void Protocol_Core::filter_rx(const rx_buffer_t &buffer) {
+	while(rx_filtering && rx_filter_pos < buffer.data_end) {
+		char c = *(rx_filter_pos++);
+
+		if(rx_filter_skip > 0) {
+			rx_filter_skip--;
+			continue;
+		}
+
+		// Look past routed and CRC headers, pass all other formats.
+		if(rx_filter.position == 0 && uint8_t(c) < ' ') {
+			if(uint8_t(c) == FURCOM_MARKER_ROUTED)
+				rx_filter_skip = FURCOM_ROUTED_HEADER_LENGTH - 1;
+			else if(uint8_t(c) != FURCOM_MARKER_CRC)
+				rx_filtering = false;
+			continue;
+		}
+
+		switch(subscriptions.filter_step(rx_filter, c)) {
+		case TOPIC_FILTER_PENDING:
+			break;
+		case TOPIC_FILTER_PASS:
+			rx_filtering = false;
+			break;
+		case TOPIC_FILTER_REJECT:
+			rx_filtering = false;
+			rx_filtered = true;
+			rx_dropping = true;
+			break;
+		}
+	}
+}
+
+void Protocol_Core::rx_single(uint8_t c) {
+	mark_line_active();
+
+	rx_byte(c);
+}
+
+void Protocol_Core::rx_span(const uint8_t *data, size_t length) {
+	// One tick read per span instead of one per byte.
+	mark_line_active();
+
+	while(length) {
+		if((state == RECEIVING) && (*data != FURCOM_END)) {
+			size_t consumed;
+			if(rx_dropping) {
+				auto stop = reinterpret_cast<const uint8_t*>(memchr(data, FURCOM_END, length));
+				consumed = (stop == nullptr) ? length : (stop - data);
+			}
+			else {
+				rx_buffer_t &buffer = rx_pool[rx_buffer_num];
+				consumed = slip_decode_span(data, length, buffer.data_end,
+						buffer.raw_data + max_frame_length + 1, had_received_escape);
+				filter_rx(buffer);
+			}
+
+			stats.rx_encoded_bytes += consumed;
+
+			data += consumed;
+			length -= consumed;
+			continue;
+		}
+
+		rx_byte(*(data++));
+		length--;
+	}
+}
+
+void Protocol_Core::process_rx_dma() {
+	size_t buffer_size;
+	const uint8_t *buffer = transport->rx_dma_buffer(buffer_size);
+	if(buffer == nullptr)
+		return;
+
+	size_t write_pos = transport->rx_dma_position();
+
+	if(write_pos < rx_dma_read_pos) {
+		rx_span(buffer + rx_dma_read_pos, buffer_size - rx_dma_read_pos);
+		rx_dma_read_pos = 0;
+	}
+	if(write_pos > rx_dma_read_pos)
+		rx_span(buffer + rx_dma_read_pos, write_pos - rx_dma_read_pos);
+
+	rx_dma_read_pos = write_pos;
+}
+
+void Protocol_Core::update_rx_mode() {
+	if(!transport->has_dma_rx())
+		return;
+
+	// Arbitration needs a reaction to every single byte, so DMA reception
+	// is only used while there is nothing to send.
+	bool want_dma = (get_tx_pending() == 0);
+	if(want_dma == rx_dma_active)
+		return;
+
+	rx_dma_active = want_dma;
+
+	if(want_dma) {
+		rx_dma_read_pos = transport->rx_dma_position();
+		transport->use_rx_dma(true);
+	}
+	else {
+		transport->use_rx_dma(false);
+		process_rx_dma();
+	}
+}
+
+void Protocol_Core::rx_byte(uint8_t c) {
+	if(c == 0x00) {
+		handle_stop_char();
+		return;
+	}
+
+	switch(state) {
+	case IDLE: break;
+	case PARTICIPATING_ARBITRATION:
+		// Perform actual arbitration
+		if(rx_arbitration_counter < 3) {
+			uint8_t *d_ptr = &(tx_arbitration.priority);
+
+			if(d_ptr[rx_arbitration_counter] != c && arbitration_loss_position == 0) {
+				arbitration_loss_position = get_missmatch_pos(d_ptr[rx_arbitration_counter], c);
+				arbitration_loss_position += 8*(2 - rx_arbitration_counter);
+			}
+
+			if(rx_arbitration_counter == 2) {
+				*reinterpret_cast<uint32_t*>(tx_arbitration.collision_map) = ~uint32_t(1<<arbitration_loss_position);
+
+				raw_start_tx(tx_arbitration.collision_map, 4);
+			}
+		}
+		else if(rx_arbitration_counter < 4) { }
+		else if(rx_arbitration_counter < 7) {
+			// Only the received byte, ~c would also set all bits above it.
+			uint32_t arb_c = uint32_t(uint8_t(~c)) << (8*(rx_arbitration_counter-4));
+			uint32_t arb_map = 0xFFFFFF >> (24 - arbitration_loss_position);
+
+			if(arb_c & arb_map) {
+				stats.arbitration_losses++;
+				stats.arbitration_loss_positions[arbitration_loss_position]++;
+
+				uint8_t &rounds = tx_aging_rounds[tx_active_queue - tx_queues];
+				if(rounds < tx_aging_max)
+					rounds++;
+
+				set_state(WAITING_ARBITRATION, arbitration_loss_position);
+			}
+			else if(rx_arbitration_counter == 6) {
+				set_state(SENDING, arbitration_loss_position);
+				load_frame();
+				start_frame_tx();
+			}
+		}
+
+		rx_arbitration_counter++;
+
+		break;
+
+	case WAITING_ARBITRATION:
+		if(rx_arbitration_counter++ == 7) {
+			set_state(RECEIVING);
+
+			// A buffer is kept for the next frame if this one is dropped.
+			if(rx_buffer_num < 0)
+				rx_buffer_num = rx_pool.claim();
+			else
+				rx_pool[rx_buffer_num].data_end = rx_pool[rx_buffer_num].raw_data;
+
+			// All buffers wait for the receiver thread or are loaned.
+			rx_dropping = rx_buffer_num < 0;
+
+			rx_filtered = false;
+			rx_filtering = rx_filter_enabled && !rx_dropping
+					&& on_rx == nullptr && frame_handler == nullptr;
+			if(rx_filtering) {
+				rx_filter_pos = rx_pool[rx_buffer_num].raw_data;
+				rx_filter_skip = 0;
+				Subscription_Table::filter_start(rx_filter);
+			}
+		}
+		break;
+
+	case RECEIVING: {
+		stats.rx_encoded_bytes++;
+		if(rx_dropping)
+			return;
+
+		rx_buffer_t &buffer = rx_pool[rx_buffer_num];
+
+		// Keep one byte past max_frame_length, see handle_stop_char().
+		if(buffer.data_end > buffer.raw_data + max_frame_length)
+			return;
+
+		if(had_received_escape) {
+			if(c == FURCOM_ESC_ESC)
+				*(buffer.data_end++) = FURCOM_ESCAPE;
+			else if(c == FURCOM_ESC_END) {
+				*(buffer.data_end++) = FURCOM_END;
+			}
+
+			had_received_escape = false;
+		}
+		else if(c == FURCOM_ESCAPE)
+			had_received_escape = true;
+		else
+			*(buffer.data_end++) = c;
+
+		filter_rx(buffer);
+		break;
+	}
+
+	case SENDING_COMPLETE:
+	case SENDING:
+		// TODO Figure out if we actually want to stop
+		// on a missmatch or just ignore it.
+		break;
+	}
+}
+
+void Protocol_Core::tx_single() {
+	if(tx_raw_length) {
+		transport->write_byte(*tx_raw_ptr);
+		tx_raw_ptr++;
+		tx_raw_length--;
+
+		if((tx_raw_length == 0) && (state == SENDING) && transport->has_dma_tx())
+			start_frame_tx();
+	}
+	else if(state == SENDING && !transport->has_dma_tx()) {
+		uint8_t out_c = *(tx_frame_ptr++);
+		tx_frame_length--;
+
+		transport->write_byte(out_c);
+
+		if(tx_frame_length == 0)
+			finish_frame();
+	}
+
+	if((tx_raw_length == 0) && ((state != SENDING) || transport->has_dma_tx()))
+		transport->set_tx_irq(false);
+}
+
+void Protocol_Core::set_chip_id(uint16_t chip_id) {
+	tx_arbitration.chip_id = encode_chip_id(chip_id);
+}
+uint16_t Protocol_Core::encode_chip_id(uint16_t chip_id) {
+	return 0x1 | 0x100 | ((chip_id & 0xEF) << 9) | ((chip_id >> 6) & 0xEF);
+}
+uint8_t Protocol_Core::encode_priority(int8_t priority) {
+	if(priority < -60)
+		return 1;
+	else if(priority > 60)
+		return 0xFF;
+	else
+		return 1 | (priority + 64) << 1;
+}
+void Protocol_Core::set_priority(int8_t priority) {
+	set_priority(priority, PRIO_NORMAL);
+}
+void Protocol_Core::set_priority(int8_t priority, tx_priority_t prio_class) {
+	tx_queues[prio_class].arbitration_priority = encode_priority(priority);
+}
+
+bool Protocol_Core::is_idle() {
+	if(state == IDLE)
+		return true;
+
+	if(rx_timeout_active) {
+		if(!line_stale)
+			return false;
+
+		// The tick comparison only keeps a wrapped timer from blocking forever.
+		if(!line_free)
+			line_free = (int32_t(get_timer_count() - line_free_count) >= 0)
+					|| (get_tick() - line_stale_tick > idle_tx_ticks + 1);
+
+		return line_free;
+	}
+
+	return get_tick() - last_active_tick > idle_tx_ticks;
+}
+
+void Protocol_Core::get_stats(bus_stats_t &out) {
+	uint32_t saved = enter_critical();
+
+	uint32_t now = get_trace_time();
+	stats.state_time[state] += uint32_t(now - state_enter_time);
+	state_enter_time = now;
+
+	out = stats;
+
+	exit_critical(saved);
+
+	for(int i = 0; i < PRIO_CLASS_NUM; i++)
+		out.tx_queue_high_water[i] = tx_queues[i].get_high_water();
+	out.tx_queue_size = tx_queues[0].get_size();
+	out.clock_rate = get_trace_rate();
+}
+
+void Protocol_Core::reset_stats() {
+	uint32_t saved = enter_critical();
+
+	stats = bus_stats_t();
+	state_enter_time = get_trace_time();
+
+	exit_critical(saved);
+
+	for(auto &queue : tx_queues)
+		queue.reset_high_water();
+}
+
+void Protocol_Core::set_trace(Trace_Ring *ring) {
+	uint32_t saved = enter_critical();
+	trace = ring;
+	exit_critical(saved);
+}
+
+void Protocol_Core::set_baudrate(uint32_t new_baudrate) {
+	if(new_baudrate == 0)
+		return;
+
+	baudrate = new_baudrate;
+	update_idle_timing();
+}
+
+void Protocol_Core::set_idle_timeouts(uint32_t reset_bits, uint32_t tx_bits) {
+	if(tx_bits < reset_bits)
+		tx_bits = reset_bits;
+
+	idle_reset_bits = reset_bits;
+	idle_tx_bits = tx_bits;
+	update_idle_timing();
+
+	if(rx_timeout_active)
+		transport->set_rx_timeout(idle_reset_bits);
+}
+
+bool Protocol_Core::start_tx() {
+	uint32_t saved = enter_critical();
+
+	update_rx_mode();
+
+	// Only if we are idle can we start sending!!
+	bool started = is_idle();
+	if(started) {
+		transport->write_byte(0);
+		mark_line_active();
+		set_state(PARTICIPATING_ARBITRATION);
+	}
+
+	exit_critical(saved);
+
+	return started;
+}
+
+void Protocol_Core::kick_tx() {
+	if(!start_tx())
+		notify_tx();
+}
+
+size_t Protocol_Core::get_max_packet_length(bool with_crc) const {
+	return max_frame_length - (with_crc ? FURCOM_CRC_OVERHEAD : 0);
+}
+
+void Protocol_Core::start_crc(tx_reservation_t &reservation, bool with_crc) {
+	if(!with_crc)
+		return;
+
+	// Space for marker and trailer was included in the reservation.
+	uint8_t marker = FURCOM_MARKER_CRC;
+	TX_Queue::add_data(reservation, &marker, 1);
+	TX_Queue::start_crc(reservation);
+}
+
+size_t Protocol_Core::encoded_packet_size(const char *topic, const void *data_ptr, size_t length) {
+	return slip_encoded_length(topic, strlen(topic) + 1)
+			+ slip_encoded_length(data_ptr, length) + 1;
+}
+
+size_t Protocol_Core::get_tx_free(tx_priority_t priority) const {
+	return tx_queues[priority].get_free_space();
+}
+
+void Protocol_Core::prepare_topic(const char *topic, packet_topic_t &out) {
+	topic_id_t id;
+
+	if(tx_topic_ids && topic_ids.find_id(topic, id)) {
+		out.id_buffer[0] = FURCOM_MARKER_TOPIC_ID;
+		out.length = 1 + Topic_Dictionary::encode_id(id, out.id_buffer + 1);
+		out.data = out.id_buffer;
+	}
+	else {
+		out.data = topic;
+		out.length = strlen(topic) + 1;
+	}
+}
+
+bool Protocol_Core::send_packet(const char *topic, const void *data_ptr, size_t length,
+		tx_priority_t priority, tx_done_handler_t handler, void *context) {
+	return queue_packet(nullptr, 0, topic, nullptr, 0, data_ptr, length, priority, handler, context);
+}
+
+bool Protocol_Core::queue_packet(const void *prefix, size_t prefix_length,
+		const char *topic, const void *payload_header, size_t header_length,
+		const void *data_ptr, size_t length,
+		tx_priority_t priority, tx_done_handler_t handler, void *context) {
+	packet_topic_t packet_topic;
+	prepare_topic(topic, packet_topic);
+
+	bool with_crc = tx_crc;
+	if(prefix_length + packet_topic.length + header_length + length > get_max_packet_length(with_crc))
+		return false;
+
+	size_t encoded_length = slip_encoded_length(prefix, prefix_length)
+			+ slip_encoded_length(packet_topic.data, packet_topic.length)
+			+ slip_encoded_length(payload_header, header_length)
+			+ slip_encoded_length(data_ptr, length);
+	if(with_crc)
+		encoded_length += 1 + 2*FURCOM_CRC_LENGTH;
+
+	tx_reservation_t reservation;
+	if(!tx_queues[priority].reserve(reservation, encoded_length, encoded_length, handler, context))
+		return false;
+
+	start_crc(reservation, with_crc);
+	TX_Queue::add_data(reservation, prefix, prefix_length);
+	TX_Queue::add_data(reservation, packet_topic.data, packet_topic.length);
+	TX_Queue::add_data(reservation, payload_header, header_length);
+	TX_Queue::add_data(reservation, data_ptr, length);
+	commit_packet(reservation);
+
+	return true;
+}
+
+bool Protocol_Core::send_frame(const void *header, size_t header_length,
+		const void *frame, size_t length, tx_priority_t priority) {
+	if(header_length + length > max_frame_length)
+		return false;
+
+	size_t encoded_length = slip_encoded_length(header, header_length)
+			+ slip_encoded_length(frame, length);
+
+	tx_reservation_t reservation;
+	if(!tx_queues[priority].reserve(reservation, encoded_length, encoded_length))
+		return false;
+
+	TX_Queue::add_data(reservation, header, header_length);
+	TX_Queue::add_data(reservation, frame, length);
+	commit_packet(reservation);
+
+	return true;
+}
+
+bool Protocol_Core::send_packet_wait(const char *topic, const void *data_ptr, size_t length,
+		uint32_t timeout, tx_priority_t priority, tx_done_handler_t handler, void *context) {
+	if(strlen(topic) + 1 + length > get_max_packet_length(tx_crc))
+		return false;
+	if(encoded_packet_size(topic, data_ptr, length) - 1 + (tx_crc ? 1 + 2*FURCOM_CRC_LENGTH : 0)
+			> tx_queues[priority].max_reservation())
+		return false;
+
+	uint32_t start_tick = get_tick();
+
+	while(!send_packet(topic, data_ptr, length, priority, handler, context)) {
+		uint32_t elapsed = get_tick() - start_tick;
+		if(elapsed >= timeout)
+			return false;
+
+		if(!wait_tx_space(timeout - elapsed))
+			return false;
+	}
+
+	return true;
+}
+
+bool Protocol_Core::reserve_packet(tx_reservation_t &reservation, const char *topic, size_t max_length,
+		tx_priority_t priority, tx_done_handler_t handler, void *context) {
+	reservation.queue = nullptr;
+
+	packet_topic_t packet_topic;
+	prepare_topic(topic, packet_topic);
+
+	bool with_crc = tx_crc;
+	size_t max_packet_length = get_max_packet_length(with_crc);
+	if(packet_topic.length > max_packet_length)
+		return false;
+	if(max_length > max_packet_length - packet_topic.length)
+		max_length = max_packet_length - packet_topic.length;
+
+	size_t encoded_topic = slip_encoded_length(packet_topic.data, packet_topic.length);
+	if(with_crc)
+		encoded_topic += 1 + 2*FURCOM_CRC_LENGTH;
+
+	if(!tx_queues[priority].reserve(reservation, encoded_topic, encoded_topic + 2*max_length,
+			handler, context))
+		return false;
+
+	start_crc(reservation, with_crc);
+	TX_Queue::add_data(reservation, packet_topic.data, packet_topic.length);
+	return true;
+}
+
+void Protocol_Core::add_packet_data(tx_reservation_t &reservation, const void *data_ptr, size_t length) {
+	if(reservation.queue == nullptr)
+		return;
+
+	TX_Queue::add_data(reservation, data_ptr, length);
+}
+
+void Protocol_Core::commit_packet(tx_reservation_t &reservation) {
+	if(reservation.queue == nullptr)
+		return;
+
+	reservation.queue->commit(reservation);
+
+	kick_tx();
+}
+
+void Protocol_Core::start_packet(const char *topic, tx_priority_t priority) {
+	lock_tx();
+
+	reserve_packet(tx_legacy_reservation, topic, max_frame_length, priority);
+}
+
+void Protocol_Core::add_packet_data(const void *data_ptr, size_t length) {
+	add_packet_data(tx_legacy_reservation, data_ptr, length);
+}
+
+void Protocol_Core::set_frame_handler(frame_handler_t handler, void *context) {
+	frame_handler = handler;
+	frame_context = context;
+}
+
+void Protocol_Core::set_crc(bool enabled) {
+	tx_crc = enabled;
+}
+
+void Protocol_Core::add_tx_service(tx_service_t &service) {
+	service.next = tx_services;
+	tx_services = &service;
+}
+
+bool Protocol_Core::loan_rx(const void *data, size_t length, rx_loan_t &loan) {
+	loan.buffer = -1;
+
+	if(rx_dispatch_num < 0)
+		return false;
+
+	rx_buffer_t &buffer = rx_pool[rx_dispatch_num];
+	auto start = reinterpret_cast<const char*>(data);
+	if(start < buffer.raw_data || start > buffer.data_end || length > size_t(buffer.data_end - start))
+		return false;
+
+	if(rx_pool.get_loans() >= rx_pool.get_count() - 1)
+		return false;
+
+	rx_pool.retain(rx_dispatch_num, true);
+
+	loan.buffer = rx_dispatch_num;
+	loan.data = data;
+	loan.length = length;
+	return true;
+}
+
+void Protocol_Core::return_rx(rx_loan_t &loan) {
+	if(loan.buffer < 0)
+		return;
+
+	rx_pool.release(loan.buffer, true);
+	loan.buffer = -1;
+}
+
+void Protocol_Core::set_rx_filter(bool enabled) {
+	rx_filter_enabled = enabled;
+}
+
+void Protocol_Core::set_topic_ids(bool enabled) {
+	tx_topic_ids = enabled;
+}
+
+bool Protocol_Core::announce_topic_id(topic_id_t id, tx_priority_t priority) {
+	const char *topic = topic_ids.find_topic(id);
+	if(topic == nullptr)
+		return false;
+
+	size_t topic_length = strlen(topic);
+	if(topic_length > max_frame_length - sizeof(FURCOM_TOPIC_ID_ANNOUNCE) - 3)
+		return false;
+
+	uint8_t payload[FURCOM_MAX_PACKET_LENGTH];
+	size_t id_length = Topic_Dictionary::encode_id(id, payload);
+	memcpy(payload + id_length, topic, topic_length);
+
+	return send_packet(FURCOM_TOPIC_ID_ANNOUNCE, payload, id_length + topic_length, priority);
+}
+
+void Protocol_Core::set_priority_aging(uint8_t max_steps) {
+	uint32_t saved = enter_critical();
+
+	tx_aging_max = max_steps;
+	for(auto &rounds : tx_aging_rounds) {
+		if(rounds > max_steps)
+			rounds = max_steps;
+	}
+
+	exit_critical(saved);
+}
+
+void Protocol_Core::set_batching(bool enabled) {
+	tx_batching = enabled;
+}
+
+int Protocol_Core::flush_tx(tx_priority_t priority) {
+	uint32_t saved = enter_critical();
+
+	TX_Queue &queue = tx_queues[priority];
+
+	// Keep the frames being arbitrated for or sent.
+	int in_flight = 0;
+	if(&queue == tx_active_queue) {
+		if(state == PARTICIPATING_ARBITRATION)
+			in_flight = 1;
+		else if(state == SENDING)
+			in_flight = tx_batch_count;
+	}
+
+	int dropped = queue.drop_frames(in_flight);
+
+	// Release the dropped frames right away, unless the head is still needed.
+	if(in_flight == 0) {
+		tx_aging_rounds[priority] = 0;
+		queue.release_dropped();
+	}
+
+	update_rx_mode();
+
+	exit_critical(saved);
+
+	if(dropped)
+		notify_tx_space();
+
+	return dropped;
+}
+
+void Protocol_Core::close_packet() {
+	commit_packet(tx_legacy_reservation);
+
+	unlock_tx();
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,183 @@
+/*
+ * RPC.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/RPC.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+RPC_Client::RPC_Client(Protocol_Core &handler, uint16_t client_id) :
+		handler(handler), client_id(client_id),
+		service{ handle_service, this, nullptr },
+		calls(), next_call_id(0),
+		completed_count(0), timeout_count(0) {
+}
+
+bool RPC_Client::attach() {
+	if(!handler.subscribe(FURCOM_RPC_REPLY_TOPIC, handle_reply, this))
+		return false;
+
+	handler.add_tx_service(service);
+	return true;
+}
+
+bool RPC_Client::call(const char *method, const void *args, size_t length,
+		rpc_done_handler_t handler, void *context, uint32_t timeout,
+		tx_priority_t priority) {
+	pending_call_t *call = nullptr;
+	for(auto &slot : calls) {
+		uint8_t expected = CALL_FREE;
+		if(slot.state.compare_exchange_strong(expected, CALL_CLAIMED)) {
+			call = &slot;
+			break;
+		}
+	}
+	if(call == nullptr)
+		return false;
+
+	call->call_id = next_call_id.fetch_add(1);
+	call->deadline = this->handler.get_tick() + timeout;
+	call->handler = handler;
+	call->context = context;
+
+	// The reply may come in before queue_packet() even returns.
+	call->state.store(CALL_SENDING, std::memory_order_release);
+
+	uint8_t header[FURCOM_RPC_REQUEST_HEADER_LENGTH] = {
+		uint8_t(client_id), uint8_t(client_id >> 8), call->call_id
+	};
+
+	if(!this->handler.queue_packet(nullptr, 0, method, header, sizeof(header), args, length,
+			priority, nullptr, nullptr)) {
+		call->state.store(CALL_FREE, std::memory_order_release);
+		return false;
+	}
+
+	uint8_t expected = CALL_SENDING;
+	if(!call->state.compare_exchange_strong(expected, CALL_PENDING))
+		call->state.store(CALL_FREE, std::memory_order_release);
+
+	// Have process_tx() pick up the new deadline.
+	this->handler.notify_tx();
+	return true;
+}
+
+int RPC_Client::get_pending() const {
+	int pending = 0;
+	for(auto &call : calls) {
+		if(call.state.load(std::memory_order_relaxed) != CALL_FREE)
+			pending++;
+	}
+
+	return pending;
+}
+
+void RPC_Client::handle_reply(void *context, const char *topic, const void *data, size_t length) {
+	auto client = reinterpret_cast<RPC_Client*>(context);
+	auto reply = reinterpret_cast<const uint8_t*>(data);
+	(void)topic;
+
+	if(length < FURCOM_RPC_REPLY_HEADER_LENGTH)
+		return;
+	if((reply[0] | (reply[1] << 8)) != client->client_id)
+		return;
+
+	for(auto &call : client->calls) {
+		uint8_t state = call.state.load(std::memory_order_acquire);
+		if(state != CALL_SENDING && state != CALL_PENDING)
+			continue;
+		if(call.call_id != reply[2])
+			continue;
+
+		rpc_done_handler_t done_handler = call.handler;
+		void *done_context = call.context;
+
+		// A call still being queued is freed by call() itself.
+		if(state == CALL_PENDING || !call.state.compare_exchange_strong(state, CALL_REPLIED))
+			call.state.store(CALL_FREE, std::memory_order_release);
+
+		client->completed_count++;
+		if(done_handler != nullptr)
+			done_handler(done_context, reply[3],
+					reply + FURCOM_RPC_REPLY_HEADER_LENGTH, length - FURCOM_RPC_REPLY_HEADER_LENGTH);
+		return;
+	}
+}
+
+uint32_t RPC_Client::handle_service(void *context, uint32_t now) {
+	auto client = reinterpret_cast<RPC_Client*>(context);
+	uint32_t delay = Protocol_Core::TX_WAIT_FOREVER;
+
+	for(auto &call : client->calls) {
+		if(call.state.load(std::memory_order_acquire) != CALL_PENDING)
+			continue;
+
+		int32_t remaining = call.deadline - now;
+		if(remaining > 0) {
+			// Waits count tick interrupts, so one more to not wake up early.
+			if(uint32_t(remaining) + 1 < delay)
+				delay = remaining + 1;
+			continue;
+		}
+
+		rpc_done_handler_t done_handler = call.handler;
+		void *done_context = call.context;
+
+		call.state.store(CALL_FREE, std::memory_order_release);
+
+		client->timeout_count++;
+		if(done_handler != nullptr)
+			done_handler(done_context, RPC_TIMEOUT, nullptr, 0);
+	}
+
+	return delay;
+}
+
+RPC_Method::RPC_Method(const char *topic, rpc_method_t method, void *context,
+		tx_priority_t priority) :
+		handler(nullptr), topic(topic), method(method), context(context),
+		priority(priority),
+		served_count(0), dropped_count(0) {
+}
+
+bool RPC_Method::attach(Protocol_Core &handler) {
+	if(!handler.subscribe(topic, handle_request, this))
+		return false;
+
+	this->handler = &handler;
+	return true;
+}
+
+void RPC_Method::handle_request(void *context, const char *topic, const void *data, size_t length) {
+	auto method = reinterpret_cast<RPC_Method*>(context);
+	auto request = reinterpret_cast<const uint8_t*>(data);
+	(void)topic;
+
+	if(length < FURCOM_RPC_REQUEST_HEADER_LENGTH || method->handler == nullptr)
+		return;
+
+	uint8_t reply_data[FURCOM_RPC_REPLY_HEADER_LENGTH + FURCOM_RPC_REPLY_LENGTH];
+	rpc_reply_t reply = { reply_data + FURCOM_RPC_REPLY_HEADER_LENGTH, FURCOM_RPC_REPLY_LENGTH, 0 };
+
+	uint8_t status = method->method(method->context,
+			request + FURCOM_RPC_REQUEST_HEADER_LENGTH, length - FURCOM_RPC_REQUEST_HEADER_LENGTH, reply);
+	if(reply.length > reply.size)
+		reply.length = reply.size;
+
+	memcpy(reply_data, request, FURCOM_RPC_REQUEST_HEADER_LENGTH);
+	reply_data[FURCOM_RPC_REQUEST_HEADER_LENGTH] = status;
+
+	if(method->handler->send_packet(FURCOM_RPC_REPLY_TOPIC,
+			reply_data, FURCOM_RPC_REPLY_HEADER_LENGTH + reply.length, method->priority))
+		method->served_count++;
+	else
+		method->dropped_count++;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
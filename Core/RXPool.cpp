@@ -0,0 +1,103 @@
+/*
+ * RXPool.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/RXPool.h>
+
+namespace TEF {
+namespace FurComs {
+
+RX_Pool::RX_Pool() :
+		buffers(nullptr), ready(nullptr), buffer_count(0),
+		free_head(NONE),
+		ready_head(0), ready_tail(0),
+		loan_count(0) {
+}
+
+void RX_Pool::set_storage(rx_buffer_t *buffers, uint16_t *ready, int count,
+		char *data, size_t frame_length) {
+	this->buffers = buffers;
+	this->ready = ready;
+	buffer_count = count;
+
+	for(int i = 0; i < count; i++) {
+		buffers[i].raw_data = data + i*(frame_length + 1);
+		buffers[i].data_end = buffers[i].raw_data;
+		buffers[i].refs.store(0, std::memory_order_relaxed);
+		buffers[i].next_free.store((i + 1 < count) ? i + 1 : NONE, std::memory_order_relaxed);
+	}
+
+	free_head.store(0, std::memory_order_release);
+}
+
+void RX_Pool::push_free(int index) {
+	uint32_t head = free_head.load(std::memory_order_relaxed);
+	uint32_t next;
+
+	do {
+		buffers[index].next_free.store(head & 0xFFFF, std::memory_order_relaxed);
+		next = ((head & 0xFFFF0000) + 0x10000) | uint32_t(index);
+	} while(!free_head.compare_exchange_weak(head, next,
+			std::memory_order_release, std::memory_order_relaxed));
+}
+
+int RX_Pool::claim() {
+	uint32_t head = free_head.load(std::memory_order_acquire);
+	uint32_t next;
+	int index;
+
+	do {
+		index = head & 0xFFFF;
+		if(index == NONE)
+			return -1;
+
+		next = ((head & 0xFFFF0000) + 0x10000)
+				| buffers[index].next_free.load(std::memory_order_relaxed);
+	} while(!free_head.compare_exchange_weak(head, next,
+			std::memory_order_acquire, std::memory_order_acquire));
+
+	rx_buffer_t &buffer = buffers[index];
+	buffer.data_end = buffer.raw_data;
+	buffer.refs.store(1, std::memory_order_relaxed);
+
+	return index;
+}
+
+void RX_Pool::push_ready(int index) {
+	uint32_t head = ready_head.load(std::memory_order_relaxed);
+
+	// Never full, there are only as many buffers as entries.
+	ready[head & (buffer_count - 1)] = index;
+	ready_head.store(head + 1, std::memory_order_release);
+}
+
+int RX_Pool::pop_ready() {
+	uint32_t tail = ready_tail.load(std::memory_order_relaxed);
+	if(tail == ready_head.load(std::memory_order_acquire))
+		return -1;
+
+	int index = ready[tail & (buffer_count - 1)];
+	ready_tail.store(tail + 1, std::memory_order_relaxed);
+
+	return index;
+}
+
+void RX_Pool::retain(int index, bool loan) {
+	buffers[index].refs.fetch_add(1, std::memory_order_relaxed);
+	if(loan)
+		loan_count++;
+}
+
+void RX_Pool::release(int index, bool loan) {
+	if(loan)
+		loan_count--;
+
+	// Everything done with the data happens before the next claim().
+	if(buffers[index].refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		push_free(index);
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,191 @@
+/*
+ * Router.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/Router.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+Router::Router(uint16_t router_id) :
+		ports(), port_count(0),
+		routes(), route_count(0),
+		router_id(router_id), max_hops(FURCOM_ROUTER_MAX_HOPS),
+		forwarded(0), dropped_loop(0), dropped_queue(0) {
+}
+
+int Router::add_port(Protocol_Core &handler) {
+	if(port_count >= FURCOM_ROUTER_PORT_NUM)
+		return -1;
+
+	ports[port_count] = &handler;
+	handler.set_frame_handler(Router::handle_frame, this);
+
+	return port_count++;
+}
+
+bool Router::add_route(const char *pattern, uint32_t from_ports, uint32_t to_ports,
+		tx_priority_t priority) {
+	if(pattern == nullptr || route_count >= FURCOM_ROUTER_ROUTE_NUM)
+		return false;
+
+	route_t &route = routes[route_count++];
+
+	route.pattern = pattern;
+	route.pattern_length = strlen(pattern);
+	route.is_prefix = (route.pattern_length > 0 && pattern[route.pattern_length - 1] == '*');
+	if(route.is_prefix)
+		route.pattern_length--;
+
+	route.from_ports = from_ports;
+	route.to_ports = to_ports;
+	route.priority = priority;
+
+	return true;
+}
+
+void Router::get_stats(router_stats_t &out) const {
+	out.forwarded = forwarded.load(std::memory_order_relaxed);
+	out.dropped_loop = dropped_loop.load(std::memory_order_relaxed);
+	out.dropped_queue = dropped_queue.load(std::memory_order_relaxed);
+}
+
+void Router::handle_frame(void *context, Protocol_Core &handler, const char *frame, size_t length) {
+	auto router = reinterpret_cast<Router*>(context);
+
+	int port = 0;
+	while(port < router->port_count && router->ports[port] != &handler)
+		port++;
+	if(port == router->port_count)
+		return;
+
+	if(length == 0 || uint8_t(frame[0]) != FURCOM_MARKER_BATCH) {
+		router->route_packet(port, frame, length);
+		return;
+	}
+
+	size_t pos = 1;
+	while(pos < length) {
+		size_t record_length = uint8_t(frame[pos++]);
+		if(record_length > length - pos)
+			break;
+
+		router->route_packet(port, frame + pos, record_length);
+		pos += record_length;
+	}
+}
+
+bool Router::get_topic(int port, const char *packet, size_t length,
+		const char *&topic, size_t &topic_length) const {
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_CRC) {
+		if(length < FURCOM_CRC_OVERHEAD)
+			return false;
+
+		packet++;
+		length -= FURCOM_CRC_OVERHEAD;
+	}
+
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_FRAGMENT) {
+		if(length < FURCOM_FRAGMENT_HEADER_LENGTH)
+			return false;
+
+		packet += FURCOM_FRAGMENT_HEADER_LENGTH;
+		length -= FURCOM_FRAGMENT_HEADER_LENGTH;
+	}
+
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_TOPIC_ID) {
+		topic_id_t id;
+		if(Topic_Dictionary::decode_id(reinterpret_cast<const uint8_t*>(packet) + 1, length - 1, id) == 0)
+			return false;
+
+		// Unknown IDs only match "*".
+		topic = ports[port]->find_topic(id);
+		if(topic == nullptr)
+			topic = "";
+		topic_length = strlen(topic);
+
+		return true;
+	}
+
+	if(length > 0 && uint8_t(packet[0]) < ' ')
+		return false;
+
+	// Without separator, the whole packet is the topic.
+	auto separator = reinterpret_cast<const char*>(memchr(packet, 0, length));
+
+	topic = packet;
+	topic_length = (separator == nullptr) ? length : (separator - packet);
+
+	return true;
+}
+
+void Router::route_packet(int port, const char *packet, size_t length) {
+	uint8_t header[FURCOM_ROUTED_HEADER_LENGTH] = {
+		FURCOM_MARKER_ROUTED, 1, uint8_t(router_id), uint8_t(router_id >> 8)
+	};
+
+	if(length > 0 && uint8_t(packet[0]) == FURCOM_MARKER_ROUTED) {
+		if(length < FURCOM_ROUTED_HEADER_LENGTH)
+			return;
+
+		uint8_t hops = packet[1];
+		uint16_t origin = uint8_t(packet[2]) | (uint8_t(packet[3]) << 8);
+
+		if(origin == router_id || hops >= max_hops) {
+			dropped_loop++;
+			return;
+		}
+
+		header[1] = hops + 1;
+		header[2] = packet[2];
+		header[3] = packet[3];
+
+		packet += FURCOM_ROUTED_HEADER_LENGTH;
+		length -= FURCOM_ROUTED_HEADER_LENGTH;
+	}
+
+	const char *topic;
+	size_t topic_length;
+	if(!get_topic(port, packet, length, topic, topic_length))
+		return;
+
+	uint32_t to_ports = 0;
+	tx_priority_t priority = PRIO_BULK;
+
+	for(int i = 0; i < route_count; i++) {
+		const route_t &route = routes[i];
+
+		if(!(route.from_ports & (1 << port)))
+			continue;
+
+		if(route.is_prefix) {
+			if(topic_length < route.pattern_length || memcmp(topic, route.pattern, route.pattern_length))
+				continue;
+		}
+		else if(topic_length != route.pattern_length || memcmp(topic, route.pattern, topic_length))
+			continue;
+
+		to_ports |= route.to_ports;
+		if(route.priority < priority)
+			priority = route.priority;
+	}
+
+	to_ports &= ~(1 << port);
+
+	for(int i = 0; i < port_count; i++) {
+		if(!(to_ports & (1 << i)))
+			continue;
+
+		if(ports[i]->send_frame(header, sizeof(header), packet, length, priority))
+			forwarded++;
+		else
+			dropped_queue++;
+	}
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,109 @@
+/*
+ * SLIP.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/SLIP.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+size_t slip_encoded_length(const void *data, size_t length) {
+	const uint8_t *pos = reinterpret_cast<const uint8_t*>(data);
+	size_t encoded = length;
+
+	for(size_t i = 0; i < length; i++) {
+		if(pos[i] == FURCOM_END || pos[i] == FURCOM_ESCAPE)
+			encoded++;
+	}
+
+	return encoded;
+}
+
+size_t slip_encode(const void *src, size_t length, uint8_t *dst) {
+	const uint8_t *pos = reinterpret_cast<const uint8_t*>(src);
+	uint8_t *out = dst;
+
+	for(size_t i = 0; i < length; i++) {
+		uint8_t c = pos[i];
+
+		if(c == FURCOM_END || c == FURCOM_ESCAPE) {
+			*(out++) = FURCOM_ESCAPE;
+			*(out++) = (c == FURCOM_END) ? FURCOM_ESC_END : FURCOM_ESC_ESC;
+		}
+		else
+			*(out++) = c;
+	}
+
+	return out - dst;
+}
+
+size_t slip_decoded_length(const uint8_t *encoded, size_t length) {
+	size_t decoded = length;
+	const uint8_t *end = encoded + length;
+
+	while((encoded = reinterpret_cast<const uint8_t*>(memchr(encoded, FURCOM_ESCAPE, end - encoded)))) {
+		decoded--;
+		encoded += 2;
+		if(encoded >= end)
+			break;
+	}
+
+	return decoded;
+}
+
+size_t slip_decode_span(const uint8_t *src, size_t length,
+		char *&dst, const char *dst_end, bool &had_escape) {
+	const uint8_t *pos = src;
+	const uint8_t *end = src + length;
+
+	while(pos < end) {
+		if(*pos == FURCOM_END)
+			break;
+
+		if(dst >= dst_end) {
+			// Buffer full, discard everything up to the STOP.
+			const uint8_t *stop = reinterpret_cast<const uint8_t*>(memchr(pos, FURCOM_END, end - pos));
+			pos = (stop != nullptr) ? stop : end;
+			break;
+		}
+
+		if(had_escape) {
+			if(*pos == FURCOM_ESC_ESC)
+				*(dst++) = char(FURCOM_ESCAPE);
+			else if(*pos == FURCOM_ESC_END)
+				*(dst++) = char(FURCOM_END);
+
+			had_escape = false;
+			pos++;
+			continue;
+		}
+
+		if(*pos == FURCOM_ESCAPE) {
+			had_escape = true;
+			pos++;
+			continue;
+		}
+
+		// Copy the clean run up to the next special character in one go.
+		const uint8_t *run_end = pos;
+		size_t max_run = dst_end - dst;
+		if(size_t(end - pos) < max_run)
+			max_run = end - pos;
+
+		while((run_end < pos + max_run) && (*run_end != FURCOM_END) && (*run_end != FURCOM_ESCAPE))
+			run_end++;
+
+		memcpy(dst, pos, run_end - pos);
+		dst += run_end - pos;
+		pos = run_end;
+	}
+
+	return pos - src;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
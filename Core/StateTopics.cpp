@@ -0,0 +1,143 @@
+/*
+ * StateTopics.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/StateTopics.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+State_Publisher::State_Publisher(Protocol_Core &handler, const char *topic, tx_priority_t priority) :
+		handler(handler), topic(topic), priority(priority),
+		in_flight(0), last_position(0),
+		published_count(0), replaced_count(0) {
+}
+
+bool State_Publisher::publish(const void *data, size_t length) {
+	Protocol_Core::packet_topic_t packet_topic;
+	handler.prepare_topic(topic, packet_topic);
+
+	bool with_crc = handler.get_crc();
+	if(packet_topic.length + length > handler.get_max_packet_length(with_crc))
+		return false;
+
+	size_t encoded_length = slip_encoded_length(packet_topic.data, packet_topic.length)
+			+ slip_encoded_length(data, length);
+
+	// Exact length, a reopened frame has no room to spare.
+	uint8_t trailer[FURCOM_CRC_LENGTH];
+	if(with_crc) {
+		uint32_t crc = crc_update(FURCOM_CRC_INIT, packet_topic.data, packet_topic.length);
+		crc_write_trailer(crc_update(crc, data, length), trailer);
+
+		encoded_length += 1 + slip_encoded_length(trailer, FURCOM_CRC_LENGTH);
+	}
+
+	TX_Queue &queue = handler.get_tx_queue(priority);
+	tx_reservation_t reservation;
+
+	// Frames are released in order, so while any is left, the newest is too.
+	bool replaced = (in_flight > 0) && queue.reopen(reservation, last_position, encoded_length);
+
+	if(!replaced) {
+		// Counted beforehand, the completion may come in right away.
+		in_flight++;
+		if(!queue.reserve(reservation, encoded_length, encoded_length,
+				State_Publisher::handle_done, this)) {
+			in_flight--;
+			return false;
+		}
+
+		last_position = reservation.start;
+	}
+
+	if(with_crc) {
+		uint8_t marker = FURCOM_MARKER_CRC;
+		TX_Queue::add_data(reservation, &marker, 1);
+	}
+	TX_Queue::add_data(reservation, packet_topic.data, packet_topic.length);
+	TX_Queue::add_data(reservation, data, length);
+	if(with_crc)
+		TX_Queue::add_data(reservation, trailer, FURCOM_CRC_LENGTH);
+	// Also wakes up the handler, should it have skipped the frame while reopened.
+	handler.commit_packet(reservation);
+
+	published_count++;
+	if(replaced)
+		replaced_count++;
+
+	return true;
+}
+
+void State_Publisher::handle_done(void *context, bool sent) {
+	auto publisher = reinterpret_cast<State_Publisher*>(context);
+	(void)sent;
+
+	publisher->in_flight--;
+}
+
+State_Cache_Base::State_Cache_Base(const char *topic, std::atomic<uint32_t> *buffers, size_t size) :
+		topic(topic), buffers(buffers), buffer_size(size), buffer_words(words(size)),
+		lengths(), update_count(0), dropped_count(0) {
+}
+
+void State_Cache_Base::handle_message(void *context, const char *topic, const void *data, size_t length) {
+	auto cache = reinterpret_cast<State_Cache_Base*>(context);
+	(void)topic;
+
+	if(length > cache->buffer_size) {
+		cache->dropped_count++;
+		return;
+	}
+
+	// Readers may still copy the value before the current one out of this
+	// buffer. Release stores make sure that those who see any new word
+	// also see the update_count that published the current value, and
+	// retry, see read().
+	uint32_t count = cache->update_count.load(std::memory_order_relaxed) + 1;
+	int index = count & 1;
+
+	auto bytes = reinterpret_cast<const uint8_t*>(data);
+	std::atomic<uint32_t> *words = cache->buffers + index * cache->buffer_words;
+	for(size_t i = 0; i < length; i += 4) {
+		uint32_t word = 0;
+		memcpy(&word, bytes + i, (length - i < 4) ? length - i : 4);
+		words[i / 4].store(word, std::memory_order_release);
+	}
+	cache->lengths[index].store(length, std::memory_order_release);
+
+	cache->update_count.store(count, std::memory_order_release);
+}
+
+size_t State_Cache_Base::read(void *data, size_t size, uint32_t *update) const {
+	while(true) {
+		uint32_t count = update_count.load(std::memory_order_acquire);
+		int index = count & 1;
+
+		size_t length = (count == 0) ? 0 : lengths[index].load(std::memory_order_acquire);
+		size_t copy = (length < size) ? length : size;
+
+		auto bytes = reinterpret_cast<uint8_t*>(data);
+		const std::atomic<uint32_t> *words = buffers + index * buffer_words;
+		for(size_t i = 0; i < copy; i += 4) {
+			uint32_t word = words[i / 4].load(std::memory_order_acquire);
+			memcpy(bytes + i, &word, (copy - i < 4) ? copy - i : 4);
+		}
+
+		// Should the receiver have begun to overwrite this buffer, the
+		// acquire loads above make the next update_count visible.
+		if(update_count.load(std::memory_order_relaxed) != count)
+			continue;
+
+		if(update != nullptr)
+			*update = count;
+		return length;
+	}
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,190 @@
+/*
+ * Subscriptions.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/Subscriptions.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+static constexpr uint8_t EXACT_MATCH = 0xFF;
+
+Subscription_Table::Subscription_Table() :
+		entries(), used_entries(0), live_entries(0),
+		prefix_lengths(0) {
+}
+
+bool Subscription_Table::subscribe(const char *pattern, rx_handler_t handler, void *context) {
+	if(pattern == nullptr || handler == nullptr)
+		return false;
+
+	if(live_entries >= TABLE_SIZE - 1)
+		return false;
+
+	size_t length = strlen(pattern);
+	uint8_t prefix_length = EXACT_MATCH;
+
+	if(length > 0 && pattern[length - 1] == '*') {
+		length--;
+		if(length > 63)
+			return false;
+
+		prefix_length = length;
+	}
+
+	topic_hash_t hash = FURCOM_TOPIC_HASH_SEED;
+	for(size_t i = 0; i < length; i++)
+		hash = topic_hash_step(hash, pattern[i]);
+
+	// Re-use removed entries along the probe sequence, or the first free one.
+	for(size_t i = hash & (TABLE_SIZE - 1);; i = (i + 1) & (TABLE_SIZE - 1)) {
+		entry_t &entry = entries[i];
+		if(entry.handler != nullptr)
+			continue;
+
+		if(entry.pattern == nullptr) {
+			// Keep at least one free slot so that probing always terminates.
+			if(used_entries >= TABLE_SIZE - 1)
+				return false;
+			used_entries++;
+		}
+		live_entries++;
+
+		entry.hash = hash;
+		entry.pattern = pattern;
+		entry.prefix_length = prefix_length;
+		entry.context = context;
+		entry.handler = handler;
+		break;
+	}
+
+	if(prefix_length != EXACT_MATCH)
+		prefix_lengths |= uint64_t(1) << prefix_length;
+
+	return true;
+}
+
+bool Subscription_Table::unsubscribe(const char *pattern, rx_handler_t handler, void *context) {
+	for(size_t i = 0; i < TABLE_SIZE; i++) {
+		entry_t &entry = entries[i];
+		if(entry.handler != handler || entry.context != context)
+			continue;
+		if(entry.pattern == nullptr || strcmp(entry.pattern, pattern))
+			continue;
+
+		// Leave the pattern set as tombstone, so that probe chains stay intact.
+		entry.handler = nullptr;
+		live_entries--;
+
+		// No probe chain passes a tombstone right before a free slot, so
+		// those are freed, walking back from this one.
+		while(entries[(i + 1) & (TABLE_SIZE - 1)].pattern == nullptr
+				&& entries[i].pattern != nullptr && entries[i].handler == nullptr) {
+			entries[i].pattern = nullptr;
+			used_entries--;
+			i = (i - 1) & (TABLE_SIZE - 1);
+		}
+
+		if(entry.prefix_length != EXACT_MATCH)
+			update_prefix_lengths();
+
+		return true;
+	}
+
+	return false;
+}
+
+void Subscription_Table::update_prefix_lengths() {
+	uint64_t lengths = 0;
+
+	for(auto &entry : entries) {
+		if(entry.handler != nullptr && entry.prefix_length != EXACT_MATCH)
+			lengths |= uint64_t(1) << entry.prefix_length;
+	}
+
+	prefix_lengths = lengths;
+}
+
+int Subscription_Table::dispatch_entries(topic_hash_t hash, uint8_t prefix_length,
+		const char *topic, const void *data, size_t length) const {
+	int called = 0;
+
+	for(size_t i = hash & (TABLE_SIZE - 1);; i = (i + 1) & (TABLE_SIZE - 1)) {
+		const entry_t &entry = entries[i];
+		if(entry.pattern == nullptr)
+			break;
+
+		if(entry.handler == nullptr || entry.hash != hash || entry.prefix_length != prefix_length)
+			continue;
+
+		// Only compare strings on a full hash hit, to weed out collisions.
+		if(prefix_length == EXACT_MATCH) {
+			if(strcmp(entry.pattern, topic))
+				continue;
+		}
+		else if(strncmp(entry.pattern, topic, prefix_length))
+			continue;
+
+		entry.handler(entry.context, topic, data, length);
+		called++;
+	}
+
+	return called;
+}
+
+bool Subscription_Table::has_entry(topic_hash_t hash, uint8_t prefix_length) const {
+	for(size_t i = hash & (TABLE_SIZE - 1);; i = (i + 1) & (TABLE_SIZE - 1)) {
+		const entry_t &entry = entries[i];
+		if(entry.pattern == nullptr)
+			return false;
+
+		if(entry.handler != nullptr && entry.hash == hash && entry.prefix_length == prefix_length)
+			return true;
+	}
+}
+
+topic_filter_result_t Subscription_Table::filter_step(topic_filter_t &filter, char c) const {
+	size_t pos = filter.position;
+
+	if((pos < 64) && (prefix_lengths & (uint64_t(1) << pos)) && has_entry(filter.hash, pos))
+		return TOPIC_FILTER_PASS;
+
+	if(c == 0)
+		return has_entry(filter.hash, EXACT_MATCH) ? TOPIC_FILTER_PASS : TOPIC_FILTER_REJECT;
+
+	filter.hash = topic_hash_step(filter.hash, c);
+	filter.position++;
+
+	return TOPIC_FILTER_PENDING;
+}
+
+int Subscription_Table::dispatch(const char *topic, const void *data, size_t length) const {
+	if(live_entries == 0)
+		return 0;
+
+	int called = 0;
+
+	topic_hash_t hash = FURCOM_TOPIC_HASH_SEED;
+	size_t pos = 0;
+
+	for(;; pos++) {
+		if((pos < 64) && (prefix_lengths & (uint64_t(1) << pos)))
+			called += dispatch_entries(hash, pos, topic, data, length);
+
+		if(topic[pos] == 0)
+			break;
+
+		hash = topic_hash_step(hash, topic[pos]);
+	}
+
+	called += dispatch_entries(hash, EXACT_MATCH, topic, data, length);
+
+	return called;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
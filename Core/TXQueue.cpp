@@ -0,0 +1,497 @@
+/*
+ * TXQueue.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/TXQueue.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+TX_Queue::TX_Queue() :
+		reserve_head(0), tail(0),
+		packet_count(0), high_water(0),
+		peek_block(0), peek_cursor(0), peek_previous(0),
+		data(nullptr), queue_size(0), size_mask(0),
+		arbitration_priority(0xFF) {
+}
+
+void TX_Queue::set_storage(uint8_t *data, uint32_t size) {
+	this->data = data;
+	queue_size = size;
+	size_mask = size - 1;
+
+	// Block positions are always 8-byte aligned, and no block ever has all
+	// tag flags set, so this tag never matches.
+	for(uint32_t i = 0; i < queue_size; i += HEADER_SIZE)
+		header_at(i).tag.store(TAG_FLAGS, std::memory_order_relaxed);
+}
+
+void TX_Queue::publish(uint32_t position, uint16_t length) {
+	block_header_t &header = header_at(position);
+
+	header.length = length;
+	header.tag.store(position, std::memory_order_release);
+}
+
+bool TX_Queue::claim(block_header_t &header, uint32_t position) {
+	uint32_t tag = position;
+	if(header.tag.compare_exchange_strong(tag, position | TAG_CLAIMED, std::memory_order_acquire))
+		return true;
+
+	return tag == (position | TAG_CLAIMED);
+}
+
+bool TX_Queue::reserve(tx_reservation_t &reservation, size_t min_length, size_t max_length,
+		tx_done_handler_t handler, void *context) {
+	reservation.queue = nullptr;
+
+	uint32_t overhead = HEADER_SIZE + (handler ? CALLBACK_SIZE : 0);
+
+	if(max_length < min_length)
+		max_length = min_length;
+	if(max_length > queue_size - overhead - 1)
+		max_length = queue_size - overhead - 1;
+	if(min_length > max_length)
+		return false;
+
+	// One extra byte for the FURCOM_END
+	uint32_t min_size = align_block(overhead + min_length + 1);
+	uint32_t max_size = align_block(overhead + max_length + 1);
+
+	uint32_t head = reserve_head.load(std::memory_order_relaxed);
+	uint32_t padding;
+	uint32_t size;
+
+	do {
+		uint32_t free = queue_size - (head - tail.load(std::memory_order_acquire));
+		uint32_t contiguous = queue_size - (head & size_mask);
+
+		padding = 0;
+		if(contiguous < min_size) {
+			// Blocks never wrap, skip to the start of the ring.
+			padding = contiguous;
+			contiguous = queue_size;
+		}
+
+		if(free < padding + min_size)
+			return false;
+
+		size = free - padding;
+		if(size > contiguous)
+			size = contiguous;
+		if(size > max_size)
+			size = max_size;
+	} while(!reserve_head.compare_exchange_weak(head, head + padding + size,
+			std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	if(padding) {
+		header_at(head).block_size = padding;
+		publish(head, PADDING_LENGTH);
+	}
+
+	uint32_t start = head + padding;
+	block_header_t &header = header_at(start);
+	header.block_size = size;
+
+	if(handler) {
+		header.block_size |= BLOCK_HAS_CALLBACK;
+		callback_of(header) = { handler, context };
+	}
+
+	// Lets drop_frames() skip the block while it is being written.
+	header.tag.store(start | TAG_RESERVED, std::memory_order_release);
+
+	reservation.queue = this;
+	reservation.start = start;
+	reservation.data_ptr = frame_of(header);
+	reservation.data_end = reinterpret_cast<uint8_t*>(&header) + size - 1;
+	reservation.overflow = false;
+	reservation.has_crc = false;
+	reservation.reopened = false;
+
+	return true;
+}
+
+bool TX_Queue::reopen(tx_reservation_t &reservation, uint32_t position, size_t length) {
+	reservation.queue = nullptr;
+
+	// Frames behind the tail are gone, the block may have been reused.
+	uint32_t first = tail.load(std::memory_order_acquire);
+	if(position - first >= reserve_head.load(std::memory_order_acquire) - first)
+		return false;
+
+	block_header_t &header = header_at(position);
+
+	uint32_t tag = position;
+	if(!header.tag.compare_exchange_strong(tag, position | TAG_REOPENED, std::memory_order_acquire))
+		return false;
+
+	uint8_t *frame_start = frame_of(header);
+	uint8_t *block_end = reinterpret_cast<uint8_t*>(&header) + (header.block_size & ~BLOCK_FLAGS);
+
+	// Commit it again unchanged.
+	if((header.block_size & BLOCK_DROPPED) || size_t(block_end - frame_start) < length + 1) {
+		header.tag.store(position, std::memory_order_release);
+		return false;
+	}
+
+	reservation.queue = this;
+	reservation.start = position;
+	reservation.data_ptr = frame_start;
+	reservation.data_end = block_end - 1;
+	reservation.overflow = false;
+	reservation.has_crc = false;
+	reservation.reopened = true;
+
+	return true;
+}
+
+void TX_Queue::add_data(tx_reservation_t &reservation, const void *data_ptr, size_t length) {
+	const uint8_t *cast_ptr = reinterpret_cast<const uint8_t *>(data_ptr);
+	uint8_t *out = reservation.data_ptr;
+
+	const uint8_t *start_ptr = cast_ptr;
+
+	while(length) {
+		uint8_t c = *cast_ptr;
+
+		if(c == FURCOM_END || c == FURCOM_ESCAPE) {
+			if(reservation.data_end - out < 2)
+				break;
+
+			*(out++) = FURCOM_ESCAPE;
+			*(out++) = (c == FURCOM_END) ? FURCOM_ESC_END : FURCOM_ESC_ESC;
+		}
+		else {
+			if(out >= reservation.data_end)
+				break;
+
+			*(out++) = c;
+		}
+
+		cast_ptr++;
+		length--;
+	}
+
+	if(length)
+		reservation.overflow = true;
+
+	if(reservation.has_crc)
+		reservation.crc = crc_update(reservation.crc, start_ptr, cast_ptr - start_ptr);
+
+	reservation.data_ptr = out;
+}
+
+void TX_Queue::add_encoded(tx_reservation_t &reservation, const void *data_ptr, size_t length) {
+	size_t space = reservation.data_end - reservation.data_ptr;
+	if(length > space) {
+		length = space;
+		reservation.overflow = true;
+	}
+
+	memcpy(reservation.data_ptr, data_ptr, length);
+	reservation.data_ptr += length;
+}
+
+bool TX_Queue::start_crc(tx_reservation_t &reservation) {
+	if(reservation.data_end - reservation.data_ptr < 2*FURCOM_CRC_LENGTH)
+		return false;
+
+	reservation.data_end -= 2*FURCOM_CRC_LENGTH;
+	reservation.has_crc = true;
+	reservation.crc = FURCOM_CRC_INIT;
+
+	return true;
+}
+
+void TX_Queue::commit(tx_reservation_t &reservation) {
+	if(reservation.queue != this)
+		return;
+
+	if(reservation.has_crc) {
+		uint8_t trailer[FURCOM_CRC_LENGTH];
+		crc_write_trailer(reservation.crc, trailer);
+
+		reservation.has_crc = false;
+		reservation.data_end += 2*FURCOM_CRC_LENGTH;
+		add_data(reservation, trailer, FURCOM_CRC_LENGTH);
+	}
+
+	// Add mandatory end character, space for it is always kept free.
+	*(reservation.data_ptr++) = FURCOM_END;
+
+	block_header_t &header = header_at(reservation.start);
+	uint8_t *frame_start = frame_of(header);
+	uint16_t length = reservation.data_ptr - frame_start;
+
+	if(reservation.reopened) {
+		// Already counted, and keeps its block for the next reopen().
+		publish(reservation.start, length);
+		reservation.queue = nullptr;
+		return;
+	}
+
+	// Give back unused space, as long as no one has reserved behind us,
+	// and drop_frames() has not skipped the block by its size.
+	uint32_t block_size = header.block_size & ~BLOCK_FLAGS;
+	uint32_t used = align_block((frame_start - reinterpret_cast<uint8_t*>(&header)) + length);
+	uint32_t expected = reservation.start + block_size;
+	uint32_t tag = reservation.start | TAG_RESERVED;
+	if(used < block_size
+			&& header.tag.compare_exchange_strong(tag, reservation.start | TAG_COMMITTING,
+					std::memory_order_relaxed)
+			&& reserve_head.compare_exchange_strong(expected, reservation.start + used))
+		header.block_size = used | (header.block_size & BLOCK_FLAGS);
+
+	// Includes blocks of other producers that are still being written.
+	uint32_t fill = reserve_head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+	uint32_t peak = high_water.load(std::memory_order_relaxed);
+	while(fill > peak && !high_water.compare_exchange_weak(peak, fill, std::memory_order_relaxed)) {}
+
+	publish(reservation.start, length);
+	packet_count++;
+
+	reservation.queue = nullptr;
+}
+
+void TX_Queue::cancel(tx_reservation_t &reservation) {
+	if(reservation.queue != this)
+		return;
+
+	block_header_t &header = header_at(reservation.start);
+
+	if(reservation.reopened) {
+		// Possibly batched behind by now, so it stays a frame. It no longer
+		// counts, unless drop_frames() uncounted it already.
+		if(!(header.block_size.fetch_or(BLOCK_DROPPED) & BLOCK_DROPPED))
+			packet_count--;
+		header.tag.store(reservation.start, std::memory_order_release);
+		reservation.queue = nullptr;
+		return;
+	}
+
+	// Cancelled packets are never handed to the completion handler.
+	header.block_size &= ~BLOCK_FLAGS;
+
+	publish(reservation.start, PADDING_LENGTH);
+	reservation.queue = nullptr;
+}
+
+size_t TX_Queue::get_free_space() const {
+	uint32_t head = reserve_head.load(std::memory_order_relaxed);
+	uint32_t free = queue_size - (head - tail.load(std::memory_order_acquire));
+	uint32_t contiguous = queue_size - (head & size_mask);
+
+	uint32_t usable = (contiguous < free) ? contiguous : free;
+	// Space at the start of the ring, after padding out the end
+	if(free > contiguous && (free - contiguous) > usable)
+		usable = free - contiguous;
+
+	if(usable < HEADER_SIZE + 1)
+		return 0;
+
+	return usable - HEADER_SIZE - 1;
+}
+
+bool TX_Queue::find_head(uint32_t &position) {
+	position = tail.load(std::memory_order_relaxed);
+
+	while(position != reserve_head.load(std::memory_order_acquire)) {
+		block_header_t &header = header_at(position);
+
+		if((header.tag.load(std::memory_order_acquire) & ~TAG_CLAIMED) != position)
+			return false;
+
+		if(header.length == PADDING_LENGTH) {
+			position += header.block_size & ~BLOCK_FLAGS;
+			tail.store(position, std::memory_order_release);
+			// Cancelled reservations leave padding behind as well.
+			rewind(position);
+			position = tail.load(std::memory_order_relaxed);
+			continue;
+		}
+
+		if(!(header.block_size & BLOCK_DROPPED))
+			return true;
+
+		// Claimed so that reopen() keeps off while it is released.
+		if(!claim(header, position))
+			return false;
+
+		peek_block = position;
+		peek_cursor = position;
+		release_frame(false);
+
+		position = tail.load(std::memory_order_relaxed);
+	}
+
+	return false;
+}
+
+void TX_Queue::rewind(uint32_t position) {
+	uint32_t offset = position & size_mask;
+	if(offset == 0)
+		return;
+
+	// Otherwise a frame longer than the space left on either side of
+	// position would never fit, not even into the empty queue.
+	uint32_t start = position + (queue_size - offset);
+
+	// Fails if a producer reserved meanwhile, the queue is not empty then.
+	if(reserve_head.compare_exchange_strong(position, start,
+			std::memory_order_acq_rel, std::memory_order_relaxed))
+		tail.store(start, std::memory_order_release);
+}
+
+bool TX_Queue::has_frame() const {
+	uint32_t position = tail.load(std::memory_order_relaxed);
+
+	while(position != reserve_head.load(std::memory_order_acquire)) {
+		const block_header_t &header = header_at(position);
+
+		if((header.tag.load(std::memory_order_acquire) & ~TAG_CLAIMED) != position)
+			return false;
+
+		if(header.length != PADDING_LENGTH && !(header.block_size & BLOCK_DROPPED))
+			return true;
+
+		position += header.block_size & ~BLOCK_FLAGS;
+	}
+
+	return false;
+}
+
+void TX_Queue::release_dropped() {
+	uint32_t position;
+	find_head(position);
+}
+
+bool TX_Queue::peek_frame(const uint8_t *&ptr, size_t &length) {
+	uint32_t position;
+
+	while(find_head(position)) {
+		block_header_t &header = header_at(position);
+
+		// Reopened just now, it will be committed again shortly.
+		if(!claim(header, position))
+			return false;
+
+		peek_block = position;
+		peek_cursor = position;
+
+		// Cancelled after being reopened since find_head() looked.
+		if(header.block_size & BLOCK_DROPPED) {
+			release_frame(false);
+			continue;
+		}
+
+		ptr = frame_of(header);
+		length = header.length;
+
+		return true;
+	}
+
+	return false;
+}
+
+bool TX_Queue::peek_next(const uint8_t *&ptr, size_t &length) {
+	uint32_t position = peek_cursor + (header_at(peek_cursor).block_size & ~BLOCK_FLAGS);
+
+	while(position != reserve_head.load(std::memory_order_acquire)) {
+		block_header_t &header = header_at(position);
+
+		if((header.tag.load(std::memory_order_acquire) & ~TAG_CLAIMED) != position)
+			return false;
+
+		if(header.length == PADDING_LENGTH) {
+			position += header.block_size & ~BLOCK_FLAGS;
+			continue;
+		}
+
+		if(!claim(header, position) || (header.block_size & BLOCK_DROPPED))
+			return false;
+
+		peek_previous = peek_cursor;
+		peek_cursor = position;
+
+		ptr = frame_of(header);
+		length = header.length;
+
+		return true;
+	}
+
+	return false;
+}
+
+void TX_Queue::unpeek_next() {
+	// Only the consumer changes the tag of a claimed frame.
+	header_at(peek_cursor).tag.store(peek_cursor, std::memory_order_release);
+	peek_cursor = peek_previous;
+}
+
+void TX_Queue::release_frame(bool sent) {
+	block_header_t &header = header_at(peek_block);
+	uint16_t block_size = header.block_size;
+
+	// Copy the callback out, the block may be reused as soon as tail moves.
+	block_callback_t callback = { nullptr, nullptr };
+	if(block_size & BLOCK_HAS_CALLBACK)
+		callback = callback_of(header);
+
+	uint32_t next = peek_block + (block_size & ~BLOCK_FLAGS);
+	tail.store(next, std::memory_order_release);
+	// Dropped frames were uncounted when they were marked.
+	if(!(block_size & BLOCK_DROPPED))
+		packet_count--;
+
+	// Before the handler runs, which may queue the next frame right away.
+	rewind(next);
+
+	if(callback.handler)
+		callback.handler(callback.context, sent);
+}
+
+int TX_Queue::drop_frames(int keep_count) {
+	uint32_t position = tail.load(std::memory_order_relaxed);
+	int dropped = 0;
+
+	while(position != reserve_head.load(std::memory_order_acquire)) {
+		block_header_t &header = header_at(position);
+		uint32_t tag = header.tag.load(std::memory_order_acquire);
+
+		// Frames behind blocks still being written are dropped all the same.
+		// Pinned blocks keep their size, see commit().
+		if(tag == (position | TAG_RESERVED))
+			header.tag.compare_exchange_strong(tag, position | TAG_PINNED, std::memory_order_acquire);
+		if(tag == (position | TAG_RESERVED) || tag == (position | TAG_PINNED)) {
+			position += header.block_size & ~BLOCK_FLAGS;
+			continue;
+		}
+
+		// Reopened frames are dropped as well, see cancel(). Anything else
+		// is a reservation not set up yet, or a shrinking one.
+		if((tag & ~(TAG_CLAIMED | TAG_REOPENED)) != position)
+			break;
+
+		if(((tag & TAG_REOPENED) || header.length != PADDING_LENGTH)
+				&& !(header.block_size & BLOCK_DROPPED)) {
+			if(keep_count > 0)
+				keep_count--;
+			else if(!(header.block_size.fetch_or(BLOCK_DROPPED) & BLOCK_DROPPED)) {
+				packet_count--;
+				dropped++;
+			}
+		}
+
+		position += header.block_size & ~BLOCK_FLAGS;
+	}
+
+	return dropped;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
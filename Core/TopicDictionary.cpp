@@ -0,0 +1,131 @@
+/*
+ * TopicDictionary.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/TopicDictionary.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+Topic_Dictionary::Topic_Dictionary() :
+		entries(), entry_count(0),
+		pool(), pool_used(0) {
+}
+
+bool Topic_Dictionary::add(topic_id_t id, const char *topic, size_t length, bool copy) {
+	if(id > FURCOM_TOPIC_ID_MAX)
+		return false;
+
+	topic_hash_t hash = FURCOM_TOPIC_HASH_SEED;
+	for(size_t i = 0; i < length; i++)
+		hash = topic_hash_step(hash, topic[i]);
+
+	size_t count = entry_count.load(std::memory_order_relaxed);
+
+	for(size_t i = 0; i < count; i++) {
+		const entry_t &entry = entries[i];
+
+		bool same_topic = (entry.hash == hash)
+				&& (strncmp(entry.topic, topic, length) == 0) && (entry.topic[length] == 0);
+
+		// Re-announcing a known pair is fine, reassigning is not.
+		if(entry.id == id || same_topic)
+			return (entry.id == id) && same_topic;
+	}
+
+	if(count >= entries.size())
+		return false;
+
+	if(copy) {
+		if(pool_used + length + 1 > pool.size())
+			return false;
+
+		char *stored = pool.data() + pool_used;
+		memcpy(stored, topic, length);
+		stored[length] = 0;
+
+		pool_used += length + 1;
+		topic = stored;
+	}
+
+	entries[count] = { hash, id, topic };
+	entry_count.store(count + 1, std::memory_order_release);
+
+	return true;
+}
+
+int Topic_Dictionary::add_table(const topic_id_def_t *table, size_t count) {
+	int added = 0;
+
+	for(size_t i = 0; i < count; i++) {
+		if(add(table[i].id, table[i].topic, strlen(table[i].topic), false))
+			added++;
+	}
+
+	return added;
+}
+
+const char *Topic_Dictionary::find_topic(topic_id_t id) const {
+	size_t count = entry_count.load(std::memory_order_acquire);
+
+	for(size_t i = 0; i < count; i++) {
+		if(entries[i].id == id)
+			return entries[i].topic;
+	}
+
+	return nullptr;
+}
+
+bool Topic_Dictionary::find_id(const char *topic, topic_id_t &id) const {
+	size_t count = entry_count.load(std::memory_order_acquire);
+	if(count == 0)
+		return false;
+
+	// topic_hash() recurses per character when not evaluated at compile time.
+	topic_hash_t hash = FURCOM_TOPIC_HASH_SEED;
+	for(const char *c = topic; *c != 0; c++)
+		hash = topic_hash_step(hash, *c);
+
+	for(size_t i = 0; i < count; i++) {
+		if(entries[i].hash != hash || strcmp(entries[i].topic, topic))
+			continue;
+
+		id = entries[i].id;
+		return true;
+	}
+
+	return false;
+}
+
+size_t Topic_Dictionary::encode_id(topic_id_t id, uint8_t *out) {
+	size_t length = 0;
+
+	do {
+		uint8_t c = id & 0x7F;
+		id >>= 7;
+
+		out[length++] = c | (id ? 0x80 : 0);
+	} while(id);
+
+	return length;
+}
+
+size_t Topic_Dictionary::decode_id(const uint8_t *data, size_t length, topic_id_t &id) {
+	id = 0;
+
+	for(size_t i = 0; i < length && i < 3; i++) {
+		id |= topic_id_t(data[i] & 0x7F) << (7*i);
+
+		if(!(data[i] & 0x80))
+			return i + 1;
+	}
+
+	return 0;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,91 @@
+/*!
+ * \file BusTrace.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_BUSTRACE_H_
+#define FURCOMS_BUSTRACE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <atomic>
+
+#ifndef FURCOM_TRACE_SIZE
+/*! Number of state transitions kept by a Trace_Ring. The oldest one may
+ *  be overwritten at any time, so one less can be read back. */
+#define FURCOM_TRACE_SIZE 64
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+//! One recorded bus state transition, see Trace_Ring.
+struct trace_entry_t {
+	uint32_t timestamp; //!< Trace clock count at the transition.
+	uint8_t from_state; //!< Previous handler_state_t.
+	uint8_t to_state;   //!< New handler_state_t.
+	/*! Transition detail. For transitions out of PARTICIPATING_ARBITRATION,
+	 *  the arbitration_loss_position of this node, 0 otherwise. */
+	uint8_t detail;
+};
+
+/*! \brief Lock-free ring of bus state transitions.
+ *  \details Attached to a Protocol_Core with Protocol_Core::set_trace(),
+ *   every change of the handler state is recorded together with a
+ *   timestamp of the platform's trace clock, i.e. the DWT cycle counter on
+ *   the LL_Handler.
+ *
+ *   The handler ISR is the only writer and never waits for readers; old
+ *   entries are simply overwritten. Any number of readers may follow the
+ *   ring with their own cursor using read(), from any thread. Entries that
+ *   were overwritten before or while they were read are skipped and
+ *   counted as lost.
+ */
+class Trace_Ring {
+private:
+	static constexpr uint32_t SIZE = FURCOM_TRACE_SIZE;
+	static_assert((SIZE & (SIZE - 1)) == 0, "FURCOM_TRACE_SIZE must be a power of two!");
+
+	//! Entry stored as two words, so that racing reads stay well-defined.
+	struct slot_t {
+		std::atomic<uint32_t> timestamp;
+		std::atomic<uint32_t> info;
+	};
+
+	//! Number of entries ever recorded.
+	std::atomic<uint32_t> write_seq;
+	std::array<slot_t, SIZE> slots;
+
+public:
+	Trace_Ring();
+
+	Trace_Ring(const Trace_Ring&) = delete;
+	Trace_Ring &operator=(const Trace_Ring&) = delete;
+
+	//! Record one entry. Single writer only, i.e. the handler ISR.
+	void record(uint32_t timestamp, uint8_t from_state, uint8_t to_state, uint8_t detail);
+
+	/*! \brief Copy out entries recorded since the cursor.
+	 *  \details Start with a cursor of 0 to read everything still in the
+	 *   ring, or get_write_seq() to only read what is recorded from now on.
+	 *
+	 * @param cursor Sequence number of the next entry to read, advanced by this call.
+	 * @param out Buffer for the entries, oldest first.
+	 * @param max Size of the buffer.
+	 * @param lost Optional, incremented by the number of entries that were overwritten.
+	 * @return Number of entries copied.
+	 */
+	size_t read(uint32_t &cursor, trace_entry_t *out, size_t max, uint32_t *lost = nullptr) const;
+
+	//! Return the sequence number the next recorded entry will get.
+	uint32_t get_write_seq() const { return write_seq.load(std::memory_order_acquire); }
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_BUSTRACE_H_ */
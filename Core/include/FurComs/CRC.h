@@ -0,0 +1,71 @@
+/*!
+ * \file CRC.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_CRC_H_
+#define FURCOMS_CRC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+//! Initial value of the frame CRC.
+#define FURCOM_CRC_INIT 0xFFFFFFFF
+//! Length of the CRC trailer, before SLIP encoding.
+#define FURCOM_CRC_LENGTH 4
+//! Decoded bytes a CRC adds to a frame, i.e. the marker and trailer.
+#define FURCOM_CRC_OVERHEAD (1 + FURCOM_CRC_LENGTH)
+
+namespace TEF {
+namespace FurComs {
+
+//! Shift the given number of zero bits into a frame CRC, usable at compile time.
+constexpr uint32_t crc_shift(uint32_t crc, int bits) {
+	return (bits == 0) ? crc
+			: crc_shift((crc & 0x80000000) ? ((crc << 1) ^ 0x04C11DB7) : (crc << 1), bits - 1);
+}
+
+//! Entry i of the byte-wise CRC table, i.e. the CRC of byte i from a zero start.
+constexpr uint32_t crc_table_entry(uint32_t i) {
+	return crc_shift(i << 24, 8);
+}
+
+/*! \brief Continue the FurComs frame CRC over more data.
+ *  \details The frame CRC is CRC-32/MPEG-2: polynomial 0x04C11DB7, MSB
+ *   first, starting at FURCOM_CRC_INIT, without final XOR. This is what
+ *   the STM32 CRC unit computes for data fed in big-endian words. Note
+ *   that zlib's crc32() is a different, bit-reflected CRC.
+ *
+ *   This is a byte-wise table implementation with a 1kB table in flash.
+ *   It has no hardware dependencies, platforms with a faster way override
+ *   Packet_Dispatcher::compute_crc().
+ *
+ * @param crc FURCOM_CRC_INIT, or the result of the previous call.
+ */
+uint32_t crc_update(uint32_t crc, const void *data, size_t length);
+
+//! Return the frame CRC of the given data.
+inline uint32_t crc_compute(const void *data, size_t length) {
+	return crc_update(FURCOM_CRC_INIT, data, length);
+}
+
+//! Read a CRC trailer, which is sent big-endian.
+inline uint32_t crc_read_trailer(const uint8_t *trailer) {
+	return (uint32_t(trailer[0]) << 24) | (uint32_t(trailer[1]) << 16)
+			| (uint32_t(trailer[2]) << 8) | trailer[3];
+}
+//! Write a CRC trailer, which is sent big-endian.
+inline void crc_write_trailer(uint32_t crc, uint8_t *trailer) {
+	trailer[0] = crc >> 24;
+	trailer[1] = crc >> 16;
+	trailer[2] = crc >> 8;
+	trailer[3] = crc;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_CRC_H_ */
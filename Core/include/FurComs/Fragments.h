@@ -0,0 +1,256 @@
+/*!
+ * \file Fragments.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_FRAGMENTS_H_
+#define FURCOMS_FRAGMENTS_H_
+
+#include <FurComs/ProtocolCore.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#ifndef FURCOM_FRAGMENT_WINDOW
+//! Fragments Fragment_Sender::send() keeps queued at once.
+#define FURCOM_FRAGMENT_WINDOW 2
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Fragment receive handler.
+ *  \details Called for every fragment of a message in order, see
+ *   Fragment_Receiver::set_fragment_handler().
+ *
+ * @param context Context pointer given with the handler.
+ * @param topic Topic of the message, null-terminated.
+ * @param offset Position of this fragment in the message. A fragment at
+ *  offset 0 starts a new message, dropping any earlier incomplete one.
+ * @param data Pointer to the fragment data.
+ * @param length Length of the fragment data, in bytes.
+ * @param last true for the last fragment of the message.
+ */
+typedef void (*fragment_handler_t)(void *context, const char *topic, size_t offset,
+		const void *data, size_t length, bool last);
+
+/*! \brief Receiver of messages sent in fragments.
+ *  \details Takes the FURCOM_MARKER_FRAGMENT packets of one topic, once
+ *   added with Packet_Dispatcher::add_fragment_receiver(). Fragments can
+ *   be handed out one by one as they arrive, see set_fragment_handler(),
+ *   so large messages can be processed, i.e. written to flash, without
+ *   ever being held in RAM. Alternatively, or additionally, the message
+ *   is collected into a caller-supplied buffer and handed out as a whole
+ *   once complete, see set_buffer().
+ *
+ *   Fragments must arrive in sequence. If one is missing, or the message
+ *   length the last one carries does not match what arrived, i.e. because
+ *   a fragment was cut short on the way, the message is dropped and
+ *   counted, see get_dropped(). Fragment handlers then never get the last
+ *   fragment. The receiver waits for the first fragment of the next
+ *   message in either case. Only one message per topic can
+ *   be received at a time, so a topic should only have one sender.
+ *
+ *   Handlers are called from the receiver thread, just like on_rx.
+ */
+class Fragment_Receiver {
+private:
+	friend Packet_Dispatcher;
+
+	const char *topic;
+	//! Next receiver of the same Packet_Dispatcher.
+	Fragment_Receiver *next;
+
+	uint8_t *buffer;
+	size_t buffer_size;
+	rx_handler_t message_handler;
+	void *message_context;
+
+	fragment_handler_t fragment_handler;
+	void *fragment_context;
+
+	//! Set between the first and last fragment of a message.
+	bool receiving;
+	uint8_t transfer_id;
+	uint16_t next_sequence;
+	size_t offset;
+
+	uint32_t completed_count;
+	uint32_t dropped_count;
+
+	void handle_fragment(const char *topic, uint8_t transfer_id, uint16_t sequence,
+			const void *data, size_t length);
+
+public:
+	/*! \brief Construct a receiver.
+	 * @param topic Exact topic to receive. Must stay valid (i.e. a string literal).
+	 */
+	Fragment_Receiver(const char *topic);
+
+	Fragment_Receiver(const Fragment_Receiver&) = delete;
+	Fragment_Receiver &operator=(const Fragment_Receiver&) = delete;
+
+	/*! \brief Collect messages into a buffer.
+	 *  \details Once the last fragment arrived, the handler is called with
+	 *   the whole message. The buffer is reused for the next message right
+	 *   after. Messages longer than the buffer are dropped, as is a message
+	 *   being received while the buffer is changed, unless its fragments
+	 *   so far still fit. Pass nullptr to stop collecting.
+	 *
+	 * @param buffer Buffer to collect into, must stay valid.
+	 * @param size Size of the buffer, in bytes.
+	 * @param handler Handler to call with complete messages.
+	 * @param context Pointer handed to the handler on every call.
+	 */
+	void set_buffer(void *buffer, size_t size, rx_handler_t handler, void *context = nullptr);
+	/*! \brief Hand out fragments as they arrive.
+	 *  \details Called before the fragment is collected into the buffer,
+	 *   if there is one. May be set with or without buffer.
+	 */
+	void set_fragment_handler(fragment_handler_t handler, void *context = nullptr);
+
+	//! Return true while a message has been started but not completed.
+	bool is_receiving() const { return receiving; }
+	//! Return the number of completely received messages.
+	uint32_t get_completed() const { return completed_count; }
+	//! Return the number of messages dropped due to missing fragments or lack of buffer.
+	uint32_t get_dropped() const { return dropped_count; }
+};
+
+/*! \brief Sender of messages too long for a single frame.
+ *  \details Splits a message into FURCOM_MARKER_FRAGMENT packets and
+ *   queues them on one topic and priority class. Fragments are cut to
+ *   at most half the TX queue once encoded, see
+ *   TX_Queue::max_safe_reservation(), so one always fits into the queue
+ *   eventually, whatever other frames came before. Topic IDs and CRCs are applied to every fragment as
+ *   set on the handler, and the fragments are forwarded by a Router like
+ *   any other packet.
+ *
+ *   A message held in memory, i.e. an animation table in flash, is sent
+ *   in the background with send(). Only FURCOM_FRAGMENT_WINDOW fragments
+ *   are queued at once, and every fragment that left the wire queues the
+ *   next from its completion handler. The message thusly needs no thread,
+ *   and does not crowd other packets of its class out of the queue.
+ *
+ *   Messages that are produced piece by piece are streamed with begin()
+ *   and write() or write_wait() instead, which queue fragments as the
+ *   data is handed in.
+ *
+ *   One sender may only send one message at a time. Messages are limited
+ *   to FURCOM_FRAGMENT_SEQUENCE_MAX + 1 fragments, about 7MB.
+ *
+ *  \note A Router has no flow control. Forwarding fragments at full
+ *   rate onto a bus that is slower or busier than the sender's drops
+ *   fragments, and with them the message, see router_stats_t::dropped_queue.
+ */
+class Fragment_Sender {
+private:
+	Protocol_Core &handler;
+	const char *topic;
+	tx_priority_t priority;
+
+	uint8_t transfer_id;
+	uint16_t sequence;
+	//! Bytes of the message queued so far.
+	uint32_t transfer_length;
+	//! The last fragment of the message has been queued.
+	std::atomic<bool> finished;
+
+	//! Message of send(), and how much of it was queued.
+	const uint8_t *message;
+	size_t message_length;
+	size_t message_position;
+
+	std::atomic<bool> busy;
+	std::atomic<bool> failed;
+	std::atomic<int> in_flight;
+	//! Requests to queue fragments, see pump().
+	std::atomic<uint32_t> pump_requests;
+
+	tx_done_handler_t done_handler;
+	void *done_context;
+
+	static void handle_fragment_done(void *context, bool sent);
+
+	//! Return the longest fragment, decoded and encoded, without header and topic.
+	bool get_fragment_limits(size_t &max_length, size_t &max_encoded);
+	//! Return how much of the data fits into one fragment.
+	static size_t fit_fragment(const uint8_t *data, size_t length,
+			size_t max_length, size_t max_encoded);
+	bool queue_fragment(const void *data, size_t length, bool last,
+			tx_done_handler_t handler, void *context);
+	void queue_message();
+	void check_done();
+
+public:
+	/*! \brief Construct a sender.
+	 * @param handler Handler to queue fragments on.
+	 * @param topic Topic to send on. Must stay valid (i.e. a string literal).
+	 * @param priority Priority class to queue fragments in.
+	 */
+	Fragment_Sender(Protocol_Core &handler, const char *topic, tx_priority_t priority = PRIO_BULK);
+
+	Fragment_Sender(const Fragment_Sender&) = delete;
+	Fragment_Sender &operator=(const Fragment_Sender&) = delete;
+
+	/*! \brief Send a message in the background.
+	 *  \details Queues the first fragments right away, the rest are
+	 *   queued from the completion handlers of earlier ones. May be called
+	 *   from interrupts.
+	 *
+	 *   Should other packets fill the queue so that not one fragment could
+	 *   be kept queued, sending pauses until pump() is called.
+	 *
+	 * @param data Message to send. Must stay valid until the handler was called.
+	 * @param length Length of the message, in bytes.
+	 * @param handler Optional handler called once the last fragment has left
+	 *  the wire, or with sent == false once the message was given up on
+	 *  because a fragment was dropped by Protocol_Core::flush_tx().
+	 * @param context Context pointer passed to the handler.
+	 * @return false if the sender is busy, or not even the first fragment could be queued.
+	 */
+	bool send(const void *data, size_t length,
+			tx_done_handler_t handler = nullptr, void *context = nullptr);
+	/*! \brief Continue sending a paused message.
+	 *  \details Queues fragments of a send() message if there is room.
+	 *   Does nothing otherwise, so it may be called periodically.
+	 *   Safe to call from any thread and from interrupts.
+	 */
+	void pump();
+	//! Return true while a message of send() has not completely left the wire.
+	bool is_busy() const { return busy; }
+
+	/*! \brief Start streaming a message.
+	 *  \details Must not be called while is_busy().
+	 */
+	void begin();
+	/*! \brief Queue the next part of a streamed message.
+	 *  \details Queues as many fragments as fit into the queue right now,
+	 *   without waiting. Fragments are as long as possible, but data is
+	 *   never held back for a later call, so data should be written in
+	 *   large pieces.
+	 *
+	 * @param last This is the end of the message, the last fragment is
+	 *  marked as such. An empty last write() ends the message.
+	 * @return Number of bytes queued. The message only ended if all data was queued.
+	 */
+	size_t write(const void *data, size_t length, bool last = false);
+	/*! \brief Queue the next part of a streamed message, waiting for space.
+	 *  \details Same as write(), but waits for fragments to leave the queue
+	 *   whenever it is full, using Protocol_Core::send_packet_wait()'s
+	 *   mechanism. Must not be called from interrupts.
+	 *
+	 * @param timeout Maximum time to wait for space, in ticks, per fragment.
+	 * @return false if not all data could be queued in time.
+	 */
+	bool write_wait(const void *data, size_t length, bool last, uint32_t timeout);
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_FRAGMENTS_H_ */
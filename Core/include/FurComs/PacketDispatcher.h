@@ -0,0 +1,219 @@
+/*!
+ * \file PacketDispatcher.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_PACKETDISPATCHER_H_
+#define FURCOMS_PACKETDISPATCHER_H_
+
+#include <FurComs/CRC.h>
+#include <FurComs/Subscriptions.h>
+#include <FurComs/TopicDictionary.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Frame marker bytes.
+ *  \details A frame normally starts with its topic string. Topics are
+ *   printable, so a frame starting with one of these bytes instead has
+ *   a special format, described per marker.
+ */
+enum frame_marker_t : uint8_t {
+	/*! Batch frame, carrying several packets.
+	 *  After the marker, each packet follows as one record made of a length
+	 *  byte and the usual topic, NUL separator and payload. The length byte
+	 *  counts topic, separator and payload, and is SLIP-encoded like all
+	 *  other frame data. Receivers dispatch every record as its own packet. */
+	FURCOM_MARKER_BATCH = 0x01,
+	/*! Packet with a numeric topic ID instead of a topic string.
+	 *  After the marker, the ID follows as unsigned LEB128 varint, then
+	 *  directly the payload, without NUL separator. See Topic_Dictionary. */
+	FURCOM_MARKER_TOPIC_ID = 0x02,
+	/*! Frame or batch record protected by a CRC.
+	 *  After the marker follows the frame as it would be sent without CRC,
+	 *  then FURCOM_CRC_LENGTH bytes of its CRC, big-endian, see crc_update().
+	 *  The CRC covers everything between marker and CRC. */
+	FURCOM_MARKER_CRC = 0x03,
+	/*! Frame or batch record forwarded by a Router.
+	 *  After the marker follow the number of routers it passed, the ID of
+	 *  the first router as two bytes little-endian, and then the frame or
+	 *  record as it was received there. See FURCOM_ROUTED_HEADER_LENGTH. */
+	FURCOM_MARKER_ROUTED = 0x04,
+	/*! One fragment of a message too long for a single frame.
+	 *  After the marker follow a transfer ID byte and the sequence number
+	 *  of the fragment as two bytes little-endian, with
+	 *  FURCOM_FRAGMENT_LAST set on the last fragment. Then follows a
+	 *  packet as usual, with a topic string or ID, carrying the next piece
+	 *  of the message as payload. The payload of the last fragment starts
+	 *  with the length of the whole message, FURCOM_FRAGMENT_TOTAL_LENGTH
+	 *  bytes little-endian, so that messages with fragments cut short on
+	 *  the way are not completed. See Fragment_Sender. */
+	FURCOM_MARKER_FRAGMENT = 0x05,
+};
+
+//! Length of the FURCOM_MARKER_ROUTED header, including the marker.
+#define FURCOM_ROUTED_HEADER_LENGTH 4
+//! Length of the FURCOM_MARKER_FRAGMENT header, including the marker.
+#define FURCOM_FRAGMENT_HEADER_LENGTH 4
+//! Length of the message length in front of the last fragment's payload.
+#define FURCOM_FRAGMENT_TOTAL_LENGTH 4
+//! Sequence number flag marking the last fragment of a message.
+#define FURCOM_FRAGMENT_LAST 0x8000
+//! Highest fragment sequence number.
+#define FURCOM_FRAGMENT_SEQUENCE_MAX 0x7FFF
+
+class Fragment_Receiver;
+class State_Cache_Base;
+
+
+/*! \brief Receive side of a FurComs node.
+ *  \details Takes decoded frames, splits batch frames, resolves topic IDs
+ *   and hands the resulting messages to subscriptions and on_rx.
+ *   Protocol_Core uses this for frames received on the bus, host-side
+ *   receivers such as the Linux Serial_Bus use it for frames read from
+ *   a serial adapter, so both understand the exact same frame formats.
+ *
+ *   Announcements on FURCOM_TOPIC_ID_ANNOUNCE are handled internally and
+ *   added to the topic ID dictionary.
+ */
+class Packet_Dispatcher {
+protected:
+	//! Topic subscriptions, dispatched from dispatch_frame()
+	Subscription_Table subscriptions;
+
+	//! Known topic IDs, see add_topic_id()
+	Topic_Dictionary topic_ids;
+
+	//! Frames and records dropped by check_crc(), see get_crc_errors()
+	uint32_t crc_error_count;
+
+	//! Receivers of FURCOM_MARKER_FRAGMENT packets, see add_fragment_receiver()
+	Fragment_Receiver *fragment_receivers;
+
+	static void handle_topic_announce(void *context, const char *topic, const void *data, size_t length);
+
+	/*! \brief Return the frame CRC of the given data.
+	 *  \details Defaults to the portable crc_update(). Called from the
+	 *   receiving thread, hosts may override it with a faster implementation.
+	 */
+	virtual uint32_t compute_crc(const void *data, size_t length) { return crc_compute(data, length); }
+	/*! \brief Check the trailer of a FURCOM_MARKER_CRC frame or record.
+	 *  \details Counts a mismatch in crc_error_count.
+	 * @return true if the CRC matches.
+	 */
+	bool check_crc(const char *frame, size_t length);
+
+	/*! \brief Dispatch one decoded frame.
+	 *  \details The frame must be followed by one writable byte, which may
+	 *   be overwritten with a terminating NUL.
+	 *
+	 * @param crc_checked The caller has already verified the CRC, if the
+	 *  frame has one. Records in batch frames are always checked.
+	 */
+	void dispatch_frame(char *frame, size_t length, bool crc_checked = false);
+	void dispatch_packet(const char *packet, size_t length);
+	void dispatch_fragment(const char *packet, size_t length);
+	void dispatch_message(const char *topic, const void *data, size_t length);
+
+	Packet_Dispatcher();
+
+public:
+	virtual ~Packet_Dispatcher() {}
+
+	/*! \brief Subscribe to a topic.
+	 *  \details Registers a handler for all messages received on the given
+	 *   topic. The pattern may either be an exact topic, or a prefix ending
+	 *   in '*'. Matching is done via a precomputed hash table, making dispatch
+	 *   cost independent of the number of subscriptions.
+	 *   Handlers are called from the receiver thread, just like on_rx.
+	 *
+	 *  \attention Subscriptions must be made before init(), or from within
+	 *   a receive handler, as the table is not locked.
+	 *  \see Subscription_Table
+	 *
+	 * @param pattern Topic or topic prefix. Must stay valid (i.e. a string literal).
+	 * @param handler Handler to call for received messages.
+	 * @param context Pointer handed to the handler on every call.
+	 * @return false if the subscription table is full.
+	 */
+	bool subscribe(const char *pattern, rx_handler_t handler, void *context = nullptr);
+	//! Remove a subscription previously made with subscribe().
+	bool unsubscribe(const char *pattern, rx_handler_t handler, void *context = nullptr);
+
+	/*! \brief Add a topic ID to the dictionary.
+	 *  \attention Same restrictions as subscribe() apply.
+	 * @param id ID to assign, up to FURCOM_TOPIC_ID_MAX.
+	 * @param topic Topic string. Must stay valid (i.e. a string literal).
+	 * @return false if the ID or topic are assigned differently, or the dictionary is full.
+	 */
+	bool add_topic_id(topic_id_t id, const char *topic);
+	//! Add a compile-time table of topic IDs. Returns the number of added entries.
+	int add_topic_ids(const topic_id_def_t *table, size_t count);
+
+	/*! \brief Register a receiver for fragmented messages.
+	 *  \details Fragments of messages on the receiver's topic are handed
+	 *   to it, see Fragment_Receiver. Fragments are not passed to
+	 *   subscriptions or on_rx.
+	 *  \attention Same restrictions as subscribe() apply.
+	 */
+	void add_fragment_receiver(Fragment_Receiver &receiver);
+	//! Remove a receiver previously added with add_fragment_receiver().
+	void remove_fragment_receiver(Fragment_Receiver &receiver);
+
+	/*! \brief Keep the last value of a state topic.
+	 *  \details Subscribes the cache to its topic, see State_Cache_Base.
+	 *  \attention Same restrictions as subscribe() apply.
+	 * @return false if the subscription table is full.
+	 */
+	bool add_state_cache(State_Cache_Base &cache);
+	//! Remove a cache previously added with add_state_cache().
+	bool remove_state_cache(State_Cache_Base &cache);
+
+	/*! \brief Return the number of received frames with a wrong CRC.
+	 *  \details Counts the frames and batch records dropped while
+	 *   dispatching. Frames that a Protocol_Core drops from its ISR are
+	 *   counted in bus_stats_t::rx_crc_errors instead.
+	 */
+	uint32_t get_crc_errors() const { return crc_error_count; }
+
+	//! Return the topic of a topic ID, or nullptr if it is unknown.
+	const char *find_topic(topic_id_t id) const { return topic_ids.find_topic(id); }
+
+	/*!\brief FurComs receive callback
+	 * \details This function pointer will be called for any data received,
+	 *   after all matching subscriptions have been handled. It may be left at
+	 *   nullptr if only subscribe() is used.
+	 *   It will be called for any data received
+	 *   on the FurComs bus. It will be called from the context of the receiver
+	 *   thread, which may be high priority and thusly may preempt user threads!
+	 *   Be aware that this may necessitate Mutexes to prevent data corruption.
+	 *
+	 * @param topic String of the topic that data was received on. Always null-terminated.
+	 * @param data Pointer to the received binary data. May not be a readable string, nor null-terminated.
+	 * @param length Length of the received data, in bytes.
+	 */
+	void (*on_rx)(const char * topic, const void * data, size_t length);
+
+	/*!\brief FurComs topic ID receive callback
+	 * \details Optional. Called for every packet received with a numeric
+	 *   topic ID, before it is dispatched by topic string. Unlike on_rx,
+	 *   this is also called for IDs that are not in the dictionary.
+	 *   Called from the receiver thread, just like on_rx.
+	 *
+	 * @param id Numeric topic ID of the packet.
+	 * @param data Pointer to the received binary data.
+	 * @param length Length of the received data, in bytes.
+	 */
+	void (*on_rx_id)(topic_id_t id, const void * data, size_t length);
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_PACKETDISPATCHER_H_ */
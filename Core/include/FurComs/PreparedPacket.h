@@ -0,0 +1,158 @@
+/*!
+ * \file PreparedPacket.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_PREPAREDPACKET_H_
+#define FURCOMS_PREPAREDPACKET_H_
+
+#include <FurComs/ProtocolCore.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef FURCOM_PREPARED_TOPIC_LENGTH
+//! Default longest topic of a Prepared_Packet, excluding the NUL.
+#define FURCOM_PREPARED_TOPIC_LENGTH 32
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Packet that is kept encoded, for topics sent over and over.
+ *  \details Telemetry is usually the same few topics, republished
+ *   periodically with a payload of fixed layout of which only some
+ *   fields change. send_packet() looks up and encodes the topic and
+ *   escapes every payload byte anew each time. A prepared packet instead
+ *   keeps its frame SLIP-encoded: the topic, or its topic ID, is
+ *   encoded once, and set() only has the payload re-encoded from the
+ *   first changed byte on. send() then copies the frame into the TX
+ *   queue in one go.
+ *
+ *   With CRCs enabled, the CRC of the topic is kept as well, and only
+ *   continued over the payload per frame.
+ *
+ *   The frame is rebuilt by itself when set_crc() or set_topic_ids() of
+ *   the handler changed. A topic ID added to the dictionary later on is
+ *   only picked up after invalidate().
+ *
+ *   set() and send() must not be called concurrently, i.e. they should be
+ *   called from one thread. The handler may be used by others meanwhile.
+ *
+ *   Storage is part of the Prepared_Packet template, see there.
+ */
+class Prepared_Packet_Base {
+private:
+	Protocol_Core &handler;
+	const char *topic;
+	tx_priority_t priority;
+
+	uint8_t *payload;
+	size_t payload_length;
+	//! Encoded frame, without CRC trailer and FURCOM_END.
+	uint8_t *encoded;
+	size_t encoded_size;
+
+	//! Encoded length of CRC marker and topic, 0 if the prefix must be rebuilt.
+	size_t prefix_length;
+	//! Encoded length of prefix and payload, up to dirty_from.
+	size_t encoded_length;
+	//! Handler settings the prefix was built for.
+	bool prefix_crc;
+	bool prefix_topic_ids;
+	//! CRC over the topic, continued over the payload for every frame.
+	uint32_t prefix_crc_state;
+	//! First payload byte changed since the payload was encoded.
+	size_t dirty_from;
+
+	bool build_prefix();
+	void encode_payload();
+
+protected:
+	/*! \brief Construct a prepared packet on the given storage.
+	 *  \details Storage is only stored, it is not accessed before the first
+	 *   set() or send(), so it may be a not-yet-constructed member of the
+	 *   subclass.
+	 *
+	 * @param payload Payload buffer of payload_length bytes.
+	 * @param encoded Frame buffer, see Prepared_Packet for its size.
+	 */
+	Prepared_Packet_Base(Protocol_Core &handler, const char *topic, tx_priority_t priority,
+			uint8_t *payload, size_t payload_length, uint8_t *encoded, size_t encoded_size);
+
+public:
+	Prepared_Packet_Base(const Prepared_Packet_Base&) = delete;
+	Prepared_Packet_Base &operator=(const Prepared_Packet_Base&) = delete;
+
+	/*! \brief Update part of the payload.
+	 *  \details Bytes that did not change cost nothing to send. The payload
+	 *   keeps its contents between send() calls.
+	 * @return false if the range does not fit into the payload.
+	 */
+	bool set(size_t offset, const void *data, size_t length);
+	/*! \brief Update one field of the payload.
+	 *  \details The value is copied as it is in memory, i.e. a number or
+	 *   a plain struct, in the byte order of the platform.
+	 */
+	template<typename T>
+	bool set(size_t offset, const T &value) {
+		return set(offset, &value, sizeof(T));
+	}
+
+	//! Return the current payload.
+	const void *get_data() const { return payload; }
+	//! Return the payload length, which is fixed.
+	size_t get_length() const { return payload_length; }
+
+	//! Have the topic encoded anew at the next send(), i.e. after adding its topic ID.
+	void invalidate() { prefix_length = 0; }
+
+	/*! \brief Queue the packet with its current payload.
+	 *  \details Same as Protocol_Core::send_packet(), and may be called from
+	 *   the same contexts, as long as not concurrently with set().
+	 *
+	 * @param done_handler Optional handler called once the packet has left the wire.
+	 * @param context Context pointer passed to the handler.
+	 * @return false if the packet did not fit into the queue, or is too long
+	 *  for the handler's frame length.
+	 */
+	bool send(tx_done_handler_t done_handler = nullptr, void *context = nullptr);
+};
+
+/*! \brief Prepared packet with its own storage.
+ *  \details See Prepared_Packet_Base. Takes about three times LENGTH
+ *   plus twice TOPIC_LENGTH bytes of RAM.
+ *
+ * @tparam LENGTH Payload length, in bytes.
+ * @tparam TOPIC_LENGTH Longest topic the packet can hold, excluding the NUL.
+ */
+template<size_t LENGTH, size_t TOPIC_LENGTH = FURCOM_PREPARED_TOPIC_LENGTH>
+class Prepared_Packet : public Prepared_Packet_Base {
+private:
+	static_assert(LENGTH > 0, "LENGTH must not be zero!");
+
+	uint8_t payload_data[LENGTH];
+	//! CRC marker, then topic, separator and payload, each byte possibly escaped.
+	uint8_t encoded_data[1 + 2*(TOPIC_LENGTH + 1) + 2*LENGTH];
+
+public:
+	/*! \brief Construct a prepared packet.
+	 *  \details The payload starts out zeroed.
+	 * @param handler Handler to queue on.
+	 * @param topic Topic to send on. Must stay valid (i.e. a string literal).
+	 * @param priority Priority class to queue in.
+	 */
+	Prepared_Packet(Protocol_Core &handler, const char *topic, tx_priority_t priority = PRIO_NORMAL) :
+			Prepared_Packet_Base(handler, topic, priority,
+					payload_data, LENGTH, encoded_data, sizeof(encoded_data)),
+			payload_data(), encoded_data() {
+	}
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_PREPAREDPACKET_H_ */
@@ -0,0 +1,952 @@
+/*!
+ * \file ProtocolCore.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_PROTOCOLCORE_H_
+#define FURCOMS_PROTOCOLCORE_H_
+
+#include <FurComs/BusTrace.h>
+#include <FurComs/PacketDispatcher.h>
+#include <FurComs/RXPool.h>
+#include <FurComs/SLIP.h>
+#include <FurComs/Transport.h>
+#include <FurComs/TXQueue.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <atomic>
+
+#ifndef FURCOM_RX_BUFFER_NUM
+//! Default number of RX buffers of a handler, see Handler_Storage.
+#define FURCOM_RX_BUFFER_NUM 4
+#endif
+
+//! Maximum packet length, including topic but excluding escape characters.
+#define FURCOM_MAX_PACKET_LENGTH 256
+
+#ifndef FURCOM_IDLE_RESET_BITS
+//! Idle time, in bit-times, after which a 0x00 counts as START (5ms at 250 kBaud).
+#define FURCOM_IDLE_RESET_BITS 1250
+#endif
+#ifndef FURCOM_IDLE_TX_BITS
+//! Idle time, in bit-times, after which a node may send a START (10ms at 250 kBaud).
+#define FURCOM_IDLE_TX_BITS 2500
+#endif
+
+#ifndef FURCOM_BATCH_RECORD_MAX
+//! Largest packet, topic and payload, that will be packed into a batch frame.
+#define FURCOM_BATCH_RECORD_MAX 64
+#endif
+
+//! \brief Namespace of The Electric Fursuits code
+//! \see https://github.com/TheElectricFursuits/
+namespace TEF {
+//! \brief Namespace of FurComs related definitions
+//! \see https://github.com/TheElectricFursuits/tef-FurComs
+namespace FurComs {
+
+/*! \brief Transceiver bus state.
+ *  \details This enum defines the states that a bus transceiver can be in
+ *    during any given moment in time, be it a idle bus, waiting for
+ *    transmission of receiving data.
+ *
+ *    The following states are relevant for transmission only:
+ *    - PARTICIPATING_ARBITRATION
+ *    - SENDING
+ *    - SENDING_COMPLETE
+ *
+ *   A listen-only node may leave these states out.
+ *
+ *   At any given time, if the bus has been idle for more than 5ms, any
+ *   received 0x00 will count as a START and not packet STOP, and thusly trigger
+ *   a new message.
+ *   However, it is advised that nodes may only send a 0x00 after 10ms of
+ *   bus idle time, to ensure that all nodes agree on the START condition.
+ *   Both times are configured in bit-times, see Protocol_Core::set_idle_timeouts().
+ */
+enum handler_state_t {
+	IDLE, //!< Bus is idle, sending is permitted at any time.
+	PARTICIPATING_ARBITRATION, //!< Handler is participating in arbitration right now
+	WAITING_ARBITRATION, //!< Handler is receiving, waiting for the arbitration to finish
+	RECEIVING, //!< Handler is now receiving
+	SENDING,   //!< Handler is now sending
+	SENDING_COMPLETE, //!< Handler completed, waiting to receive final 0x00
+};
+//! Number of handler_state_t values.
+constexpr int HANDLER_STATE_NUM = SENDING_COMPLETE + 1;
+
+/*! \brief Struct defining the arbitration phase data.
+ *	\details This struct defines the data used during the arbitration phase.
+ *   It shall be used as follows:
+ *   - After receiving a starting 0x00, all nodes that wish to transmit will
+ *     fill the 'priority' and 'chip_id' fields.
+ *     Default priority will be 64, chip_id is user-settable. See the in-struct
+ *     documentation for how to fill these fields.
+ *   - The _latency_a and _latency_b fields will be filled with 0xFF
+ *   - All sending nodes may then participate in the arbitration by sending
+ *     the first 4 bytes (up to, including _latency_a) onto the bus.
+ *   - All participating nodes MUST be listening to the bus line, and MUST
+ *     record the first bit missmatch of bus-data. Earlier packets are lower-value,
+ *     MSB is lower-value than LSB, thusly priority MSB holds bit missmatch position 24
+ *     and chip_id LSB holds missmatch position 1. Note that receiving NO
+ *     missmatch must also be recorded as missmatch position 0.
+ *   - Any node with a bit-missmatch in priority MSB (position 24) MUST stop
+ *     transmitting and MAY enter receive mode.
+ *   - All other nodes MUST fill collision_map with ~(1<< missmatch),
+ *     and must continue sending their arbitration package up to and including
+ *     _latency_b.
+ *   - All nodes MUST receive the collision_map, and must compute the lowest
+ *     missmatch of all nodes. Only the node with the lowest missmatch position
+ *     (this being 0 if no collission was detected) MAY continue transmission,
+ *     all other nodes MUST stop and switch to receiving mode!
+ *   - Only the now successful node MAY continue transmitting its data, encoded
+ *     in modified SLIP encoding. It MUST send a 0x00 to signal end of packet,
+ *     and MUST also send a second 0x00 to indicate start of arbitration should
+ *     it wish to transmit again.
+ */
+#pragma pack(1)
+struct arbitration_package_t {
+	uint8_t  priority;	/*!< Priority of this package.
+								     Computed as: (priority + 64) << 1 | 1 */
+	uint16_t chip_id;		/*!< Chip ID.
+									  Computed as:
+									  0x1 | 0x100 | ((chip_id & 0xEF) << 9) | ((chip_id >> 6) & 0xEF); */
+	uint8_t  _latency_a;	//!< Latency byte. Must always be 0xFF!
+	uint8_t  collision_map[3]; /*!< Collission map.
+											  Contains a bitmap of detected collissions of
+											  arbitration participating nodes. See struct explanation. */
+	uint8_t  _latency_b;	//!< Latency byte. Must always be 0xFF.
+};
+#pragma pack(0)
+
+/*! \brief Buffers of a Protocol_Core.
+ *  \details Handed to the Protocol_Core constructor, usually by a
+ *   Handler_Storage, which also checks the sizes.
+ */
+struct handler_storage_t {
+	rx_buffer_t *rx_buffers;   //!< RX buffer descriptors, rx_buffer_count of them.
+	int rx_buffer_count;       //!< Number of RX buffers, a power of two.
+	char *rx_data;             //!< Data of all RX buffers, rx_buffer_count * (frame_length + 1) bytes.
+	uint16_t *rx_ready;        //!< Ready queue of the RX_Pool, rx_buffer_count entries.
+	size_t frame_length;       //!< Longest frame that is received or sent, in decoded bytes.
+	uint8_t *tx_data;          //!< Ring storage of all TX queues, PRIO_CLASS_NUM * tx_queue_size bytes, 8-byte aligned.
+	uint32_t tx_queue_size;    //!< Size of every TX queue, a power of two.
+	uint8_t *tx_batch_buffer;  //!< Batch frame staging buffer, 2 * frame_length + 1 bytes.
+};
+
+/*! \brief Statically sized buffers of a Protocol_Core.
+ *  \details Holds all memory a handler needs, sized at compile time, so
+ *   that nodes with little RAM can trim the buffers and busy gateways can
+ *   enlarge them, per handler. Meant to be inherited by platform handlers
+ *   ahead of Protocol_Core, see LL_Handler.
+ *
+ * @tparam RX_BUFFER_NUM Number of RX buffers, a power of two. Frames
+ *  that arrive while all of them wait for the receiver thread or are
+ *  loaned out are dropped, see Protocol_Core::loan_rx().
+ * @tparam FRAME_LENGTH Longest frame, in decoded bytes, that is received or
+ *  sent, at most FURCOM_MAX_PACKET_LENGTH. Longer frames of other nodes
+ *  are cut off, and counted in bus_stats_t::rx_truncated.
+ * @tparam TX_QUEUE_SIZE Size of the TX queue of every priority class, in
+ *  bytes, a power of two.
+ */
+template<int RX_BUFFER_NUM = FURCOM_RX_BUFFER_NUM,
+		size_t FRAME_LENGTH = FURCOM_MAX_PACKET_LENGTH,
+		uint32_t TX_QUEUE_SIZE = FURCOM_TX_QUEUE_SIZE>
+class Handler_Storage {
+private:
+	static_assert(RX_BUFFER_NUM > 0 && (RX_BUFFER_NUM & (RX_BUFFER_NUM - 1)) == 0,
+			"RX_BUFFER_NUM must be a power of two!");
+	static_assert(RX_BUFFER_NUM < RX_Pool::NONE, "RX_BUFFER_NUM must fit the RX_Pool indices!");
+	static_assert(FRAME_LENGTH >= 32, "FRAME_LENGTH must hold the frame headers!");
+	static_assert(FRAME_LENGTH <= FURCOM_MAX_PACKET_LENGTH, "FRAME_LENGTH must not exceed FURCOM_MAX_PACKET_LENGTH!");
+	static_assert((TX_QUEUE_SIZE & (TX_QUEUE_SIZE - 1)) == 0, "TX_QUEUE_SIZE must be a power of two!");
+	static_assert(TX_QUEUE_SIZE >= 64, "TX_QUEUE_SIZE must hold a small packet!");
+	static_assert(TX_QUEUE_SIZE <= 32768, "TX_QUEUE_SIZE must fit the block header!");
+
+	rx_buffer_t rx_buffers[RX_BUFFER_NUM];
+	std::array<char, RX_BUFFER_NUM * (FRAME_LENGTH + 1)> rx_data;
+	std::array<uint16_t, RX_BUFFER_NUM> rx_ready;
+	alignas(8) std::array<uint8_t, PRIO_CLASS_NUM * TX_QUEUE_SIZE> tx_data;
+	std::array<uint8_t, 2*FRAME_LENGTH + 1> tx_batch_buffer;
+
+protected:
+	//! Return the storage to hand to the Protocol_Core constructor.
+	handler_storage_t get_storage() {
+		return { rx_buffers, RX_BUFFER_NUM, rx_data.data(), rx_ready.data(), FRAME_LENGTH,
+			tx_data.data(), TX_QUEUE_SIZE, tx_batch_buffer.data() };
+	}
+};
+
+/*! \brief Bus statistics of one handler.
+ *  \details Counted by the Protocol_Core ISR, see Protocol_Core::get_stats().
+ *   Counters wrap around, so rates should be taken from the difference
+ *   of two snapshots.
+ */
+struct bus_stats_t {
+	uint32_t frames_sent;     //!< Frames that fully left the wire.
+	uint32_t packets_sent;    //!< Packets in those frames, more than frames_sent with batching.
+	uint32_t frames_received; //!< Frames of other nodes handed to the receiver thread.
+
+	uint32_t arbitration_attempts; //!< Arbitrations this node took part in.
+	uint32_t arbitration_losses;   //!< Arbitrations lost to another node.
+	/*! Lost arbitrations by arbitration_loss_position, i.e. the first bit
+	 *  of this node's header that did not match the bus, from 24 for the
+	 *  priority MSB down to 1 for the chip ID LSB. */
+	uint32_t arbitration_loss_positions[25];
+
+	//! Frames dropped because all RX buffers were still waiting for the receiver thread, or loaned out.
+	uint32_t rx_overruns;
+	//! Frames that filled an RX buffer completely, and were likely cut off.
+	uint32_t rx_truncated;
+	//! Frames with a FURCOM_MARKER_CRC whose CRC did not match, dropped in the ISR.
+	uint32_t rx_crc_errors;
+	//! Frames no subscription wanted, dropped in the ISR, see Protocol_Core::set_rx_filter().
+	uint32_t rx_filtered;
+	/*! Bytes of received frames as they were on the wire, and after SLIP
+	 *  decoding. Their ratio is the escape expansion of the bus traffic. */
+	uint32_t rx_encoded_bytes;
+	uint32_t rx_decoded_bytes; //!< See rx_encoded_bytes.
+
+	//! TX_Queue::get_high_water() of every priority class, in bytes.
+	uint32_t tx_queue_high_water[PRIO_CLASS_NUM];
+	//! Size of every TX queue, in bytes, see TX_Queue::get_size().
+	uint32_t tx_queue_size;
+
+	//! Time spent in every handler_state_t, in trace clock counts.
+	uint64_t state_time[HANDLER_STATE_NUM];
+	//! Trace clock counts per second, to convert state_time and trace timestamps.
+	uint32_t clock_rate;
+};
+
+class Protocol_Core;
+
+/*! \brief Received frame handler.
+ *  \details Called from the receiver thread for every received frame,
+ *   before it is dispatched, see Protocol_Core::set_frame_handler().
+ *
+ * @param context Context pointer given with the handler.
+ * @param handler Handler that received the frame.
+ * @param frame Decoded frame, as it was on the wire. Followed by a NUL.
+ * @param length Length of the frame, in bytes.
+ */
+typedef void (*frame_handler_t)(void *context, Protocol_Core &handler, const char *frame, size_t length);
+
+/*! \brief Timed work of a layer built on the handler.
+ *  \details Called from every Protocol_Core::process_tx(), on the
+ *   receiver thread, see Protocol_Core::add_tx_service(). I.e. RPC clients
+ *   time out their calls from here.
+ *
+ * @param context Context pointer given with the service.
+ * @param now Current platform tick.
+ * @return Ticks until the service wants to run again, or
+ *  Protocol_Core::TX_WAIT_FOREVER.
+ */
+typedef uint32_t (*tx_service_handler_t)(void *context, uint32_t now);
+
+//! Registration of a tx_service_handler_t, see Protocol_Core::add_tx_service().
+struct tx_service_t {
+	tx_service_handler_t handler;
+	void *context;
+	tx_service_t *next; //!< Next service of the same handler, set by add_tx_service().
+};
+
+/*! \brief Hardware-independent FurComs protocol engine.
+ *  \details This class implements everything about a FurComs version 1
+ *   node that does not depend on the platform: the arbitration state machine
+ *   and collision map handling, SLIP encoding and decoding, the TX queues
+ *   and the RX buffer pool. Received frames are dispatched by the inherited
+ *   Packet_Dispatcher.
+ *
+ *   All hardware access goes through a Transport, everything the protocol
+ *   needs from the OS (a millisecond tick, waking the receiver thread,
+ *   locking the packet writer and masking interrupts) is provided by
+ *   implementing the virtual platform functions in a subclass.
+ *   The STM32F4 LL_Handler is one such subclass, the Linux bus simulator
+ *   provides another one.
+ *
+ *   A platform adapter must:
+ *   - Call handle_isr() whenever the transport may have pending events.
+ *   - Call process_rx() from its receiver thread whenever notify_rx()
+ *     was called.
+ *   - Call process_tx() from the same thread whenever notify_tx() was
+ *     called, or the delay returned by the last process_tx() elapsed.
+ *   No periodic polling is needed.
+ */
+class Protocol_Core : public Packet_Dispatcher {
+public:
+	//! process_tx() return value if no further call is needed until notify_tx().
+	static constexpr uint32_t TX_WAIT_FOREVER = 0xFFFFFFFF;
+
+	//! Topic as written into a frame, either string or marker and ID.
+	struct packet_topic_t {
+		const void *data;
+		size_t length;
+		uint8_t id_buffer[4];
+	};
+
+protected:
+	Transport *transport;
+
+	handler_state_t state;
+
+	arbitration_package_t tx_arbitration;
+	int rx_arbitration_counter;
+	uint8_t arbitration_loss_position;
+
+	//! One queue of pre-encoded frames per priority class
+	TX_Queue tx_queues[PRIO_CLASS_NUM];
+	//! Reservation written to between start_packet() and close_packet()
+	tx_reservation_t tx_legacy_reservation;
+	//! Queue whose head frame is currently arbitrated for or sent
+	TX_Queue *tx_active_queue;
+
+	//! Priority steps a packet may gain by losing arbitration, see set_priority_aging()
+	uint8_t tx_aging_max;
+	//! Arbitrations lost by the head packet of every class, up to tx_aging_max.
+	uint8_t tx_aging_rounds[PRIO_CLASS_NUM];
+
+	//! Pack small queued packets into batch frames, see set_batching()
+	bool tx_batching;
+	//! Number of queued packets contained in the frame being sent
+	int tx_batch_count;
+	//! Staging buffer for the encoded batch frame being sent, 2*max_frame_length + 1 bytes
+	uint8_t *tx_batch_buffer;
+
+	//! Raw data pointer used to transmit the tx_arbitration struct.
+	//! \todo Remove this and simply implement it as in-software data loading.
+	const uint8_t *tx_raw_ptr;
+	size_t tx_raw_length;
+
+	//! Remaining data of the frame being sent.
+	const uint8_t *tx_frame_ptr;
+	size_t tx_frame_length;
+
+	//! Buffer the ISR receives into, -1 if none is claimed yet.
+	int rx_buffer_num;
+	//! Buffer being dispatched by process_rx(), -1 outside of it, see loan_rx().
+	int rx_dispatch_num;
+	//! Pre-decoded data received from the bus
+	RX_Pool rx_pool;
+	//! Longest frame received or sent, in decoded bytes, see handler_storage_t::frame_length.
+	size_t max_frame_length;
+
+	//! Bus baudrate, used to convert bit-times into platform ticks.
+	uint32_t baudrate;
+	//! Idle times in bit-times, see set_idle_timeouts()
+	uint32_t idle_reset_bits;
+	uint32_t idle_tx_bits;
+	//! Idle times converted into platform ticks, see update_idle_timing()
+	uint32_t idle_reset_ticks;
+	uint32_t idle_tx_ticks;
+	//! Time between idle_reset_bits and idle_tx_bits, in timer counts.
+	uint32_t idle_tx_counts;
+
+	//! Idle detection is done by the transport's receiver timeout.
+	bool rx_timeout_active;
+	//! Set by TRANSPORT_RX_TIMEOUT, the line has been idle for idle_reset_bits.
+	bool line_stale;
+	//! Set once the line has also been idle for idle_tx_bits.
+	bool line_free;
+	//! Tick at which line_stale was set.
+	uint32_t line_stale_tick;
+	//! Timer count at which the line will have been idle for idle_tx_bits.
+	uint32_t line_free_count;
+	//! Last tick that a byte was received on, without receiver timeout.
+	uint32_t last_active_tick;
+
+	bool had_received_escape;
+
+	//! Read index into the transport's circular RX DMA buffer.
+	size_t rx_dma_read_pos;
+	//! True while received data is collected via DMA instead of per-byte.
+	bool rx_dma_active;
+
+	//! Send packets with a known topic ID in the compact format
+	bool tx_topic_ids;
+	//! Protect every queued packet with a CRC, see set_crc()
+	bool tx_crc;
+
+	//! Raw frame handler, see set_frame_handler()
+	frame_handler_t frame_handler;
+	void *frame_context;
+
+	//! Set while a frame is received for which no RX buffer was free.
+	bool rx_dropping;
+
+	//! Services run from process_tx(), see add_tx_service()
+	tx_service_t *tx_services;
+
+	//! Drop unwanted frames in the ISR, see set_rx_filter()
+	bool rx_filter_enabled;
+	//! Set while the topic of the frame being received is still matched.
+	bool rx_filtering;
+	//! Set if rx_dropping was set by the filter, not for lack of a buffer.
+	bool rx_filtered;
+	//! Next received byte to feed to the filter.
+	const char *rx_filter_pos;
+	//! Frame header bytes still to be skipped before the topic.
+	uint8_t rx_filter_skip;
+	topic_filter_t rx_filter;
+
+	//! Statistics, see get_stats()
+	bus_stats_t stats;
+	//! Trace clock count of the last state change.
+	uint32_t state_enter_time;
+	//! Optional record of state changes, see set_trace()
+	Trace_Ring *trace;
+
+	void start_crc(tx_reservation_t &reservation, bool with_crc);
+	bool check_rx_crc(const rx_buffer_t &buffer);
+
+	int get_missmatch_pos(uint8_t a, uint8_t b);
+
+	/*! \brief Change the handler state.
+	 *  \details All state changes go through here to keep the state times
+	 *   and the trace. Must be called from the ISR or with interrupts masked.
+	 * @param detail Recorded in the trace, see trace_entry_t::detail.
+	 */
+	void set_state(handler_state_t new_state, uint8_t detail = 0);
+
+	void raw_start_tx(const void *data, size_t length);
+
+	void handle_stop_char();
+	void rx_byte(uint8_t c);
+	void rx_single(uint8_t c);
+	void rx_span(const uint8_t *data, size_t length);
+	void filter_rx(const rx_buffer_t &buffer);
+	void tx_single();
+
+	int get_tx_pending() const;
+	uint8_t get_aged_priority(int prio_class) const;
+	bool select_tx_queue();
+	void load_frame();
+	bool build_batch();
+	void start_frame_tx();
+	void finish_frame();
+	void tx_dma_done();
+
+	void process_rx_dma();
+	void update_rx_mode();
+
+	void update_idle_timing();
+	void mark_line_active();
+
+	bool start_tx();
+	void kick_tx();
+	uint32_t get_tx_delay();
+
+	/*! \brief Return a free-running, fine-grained timer count.
+	 *  \details Used to time the remainder of the TX idle time after the
+	 *   receiver timeout fired, independent of the tick rate. May wrap.
+	 *   Defaults to get_tick().
+	 */
+	virtual uint32_t get_timer_count() { return get_tick(); }
+	//! Return the number of get_timer_count() counts per second.
+	virtual uint32_t get_timer_rate() { return get_tick_rate(); }
+	/*! \brief Return the trace clock count.
+	 *  \details Timestamps state changes for the statistics and the
+	 *   Trace_Ring, and is read from the ISR on every state change. Should
+	 *   be as fine-grained as is cheap to read, i.e. a CPU cycle counter.
+	 *   May wrap. Defaults to get_timer_count().
+	 */
+	virtual uint32_t get_trace_time() { return get_timer_count(); }
+	//! Return the number of get_trace_time() counts per second.
+	virtual uint32_t get_trace_rate() { return get_timer_rate(); }
+	/*! \brief Return the frame CRC of a received frame.
+	 *  \details Called from the ISR at the STOP of every frame that
+	 *   carries a CRC, so it should be fast. Platforms with a CRC unit
+	 *   override this, as it is only ever used from the ISR, the unit needs
+	 *   no locking. Defaults to compute_crc().
+	 */
+	virtual uint32_t compute_rx_crc(const void *data, size_t length) { return compute_crc(data, length); }
+	/*! \brief Wake the receiver thread.
+	 *  \details Called from ISR context once a buffer has been filled. The
+	 *   platform must make sure process_rx() is called soon after.
+	 */
+	virtual void notify_rx() = 0;
+	//! Lock the packet writer, called from start_packet(). Must block until available.
+	virtual void lock_tx() {}
+	//! Unlock the packet writer, called from close_packet().
+	virtual void unlock_tx() {}
+	/*! \brief Mask interrupts.
+	 *  \details Used to keep the ISR out while thread code hands off state to it.
+	 * @return Opaque state to be passed to exit_critical().
+	 */
+	virtual uint32_t enter_critical() { return 0; }
+	//! Restore interrupts masked by enter_critical().
+	virtual void exit_critical(uint32_t saved) { (void)saved; }
+	//! Wake up wait_tx_space(), called from ISR context whenever a frame was released.
+	virtual void notify_tx_space() {}
+
+	/*! \brief Construct the protocol core.
+	 *  \details The transport is only stored, it will not be accessed
+	 *   until start() is called, so it may be a not-yet-constructed
+	 *   member of the subclass.
+	 *
+	 * @param storage Buffers to use, usually from a Handler_Storage the
+	 *  subclass inherits ahead of Protocol_Core. Must stay valid.
+	 */
+	Protocol_Core(Transport &transport, const handler_storage_t &storage);
+
+	/*! \brief Start reception.
+	 *  \details Must be called by the platform's init code once the platform
+	 *   is ready to service handle_isr() and notify_rx().
+	 */
+	void start();
+
+	/*! \brief Receiver thread work.
+	 *  \details Hands out all filled RX buffers to subscriptions and on_rx,
+	 *   and frees them afterwards unless they were loaned, see loan_rx().
+	 */
+	void process_rx();
+	/*! \brief Transmission kick-off.
+	 *  \details Starts arbitration if packets are pending and the bus is
+	 *   idle. Otherwise returns how long until the bus will have been idle
+	 *   for the TX idle time, if nothing else is received until then.
+	 *   Also runs the services added with add_tx_service(), and returns
+	 *   early enough for the next one to run.
+	 *
+	 * @return Ticks until process_tx() should be called again, or
+	 *  TX_WAIT_FOREVER if notify_tx() will be called when needed.
+	 */
+	uint32_t process_tx();
+
+public:
+	virtual ~Protocol_Core() {}
+
+	/*! \brief Return the current platform tick. */
+	virtual uint32_t get_tick() = 0;
+	//! Return the number of get_tick() ticks per second.
+	virtual uint32_t get_tick_rate() { return 1000; }
+	/*! \brief Wake the receiver thread to start transmission.
+	 *  \details Called from any context when queued packets could not be
+	 *   started right away, or a service added with add_tx_service() needs
+	 *   to run earlier. The platform must make sure process_tx() is
+	 *   called soon after.
+	 */
+	virtual void notify_tx() = 0;
+	/*! \brief Wait until TX queue space may have been freed.
+	 *  \details Used by send_packet_wait(). Spurious wakeups are fine.
+	 *   The default implementation cannot block and returns false.
+	 * @param timeout Maximum time to wait, in ticks.
+	 * @return false if the timeout elapsed.
+	 */
+	virtual bool wait_tx_space(uint32_t timeout) { (void)timeout; return false; }
+
+	/*! \brief Handle pending transport events.
+	 *  \details This function MUST be called from the transport's interrupt
+	 *    in order to properly receive and send data. No transmission will be
+	 *    possible without it.
+	 */
+	void handle_isr();
+
+	//! Return the current state of the bus transceiver.
+	handler_state_t get_state() const { return state; }
+
+	/*! \brief Copy the bus statistics.
+	 *  \details The time spent in the current state so far is added to
+	 *   the state times. State times of a state that lasts longer than
+	 *   the trace clock takes to wrap are undercounted, so this should be
+	 *   called at least that often, i.e. every 25s for a 168 MHz cycle counter.
+	 *   May be called from any thread.
+	 */
+	void get_stats(bus_stats_t &out);
+	//! Return a snapshot of the statistics, see get_stats(bus_stats_t&).
+	bus_stats_t get_stats() {
+		bus_stats_t stats;
+		get_stats(stats);
+		return stats;
+	}
+	//! Reset all statistics, including the TX queue high-water marks.
+	void reset_stats();
+
+	/*! \brief Record state changes into a Trace_Ring.
+	 *  \details Every change of the handler state is recorded from then on,
+	 *   with a get_trace_time() timestamp. Pass nullptr to stop recording.
+	 *   The ring must stay valid until then.
+	 */
+	void set_trace(Trace_Ring *ring);
+
+	//! Encode a priority (-60 to 60) into its arbitration_package_t::priority byte.
+	static uint8_t encode_priority(int8_t priority);
+	//! Encode a 14-bit chip ID into its arbitration_package_t::chip_id field.
+	static uint16_t encode_chip_id(uint16_t chip_id);
+
+	/*! \brief Set chip ID
+	 *  \details This will configure the Chip ID used during arbitration phase.
+	 *  Note that lower chip IDs may get access to the bus more often, so
+	 *  for busy lines, a good chip ID distribution can be helpful.
+	 *
+	 *  \note It is recommended that all chips have a unique Chip ID to
+	 *   prevent data collissions in busy bus conditions.
+	 *
+	 * @param id 14-bit ID used for identification of this node.
+	 */
+	void set_chip_id(uint16_t id);
+
+	/*! \brief Set the priority of this chip.
+	 *  \details This is the first byte sent over the bus, and thusly has
+	 *   the highest weight during arbitration. Lower numbers will be preferred,
+	 *   allowing reliable transmission of important messages during higher-load
+	 *   conditions.
+	 *
+	 *   This sets the priority of the PRIO_NORMAL class, which is used by
+	 *   default for start_packet().
+	 *
+	 * @param prio The priority value, allowed range is from -60 to 60
+	 */
+	void set_priority(int8_t prio);
+	/*! \brief Set the arbitration priority of a priority class.
+	 *  \details Same as set_priority(int8_t), but for the given class.
+	 *   Classes should keep their order, i.e. PRIO_URGENT should always
+	 *   have a lower value than PRIO_HIGH.
+	 *
+	 * @param prio The priority value, allowed range is from -60 to 60
+	 * @param prio_class The class to configure.
+	 */
+	void set_priority(int8_t prio, tx_priority_t prio_class);
+
+	/*! \brief Enable priority aging.
+	 *  \details Without aging, a node that lost arbitration competes again
+	 *   with the same header at the next START, so on a busy bus the lowest
+	 *   chip IDs keep winning and other nodes may starve.
+	 *   With aging, every lost arbitration raises the priority of the
+	 *   packet at the head of its class by one step, up to max_steps, and
+	 *   the packet is back at the class priority once it was sent.
+	 *
+	 *   A step clears the lowest set bit of the raw priority byte, leaving
+	 *   bit 0 set. Each step is thusly a bit-subset of the ones before, so
+	 *   the most aged of several contending nodes matches the wired-AND of
+	 *   the bus in the priority byte. This also makes it rare for two
+	 *   nodes to win the same arbitration, which the collision map cannot
+	 *   rule out once three or more nodes of equal priority contend.
+	 *
+	 *   An aged packet always stays behind the priority of the next more
+	 *   urgent class, so it never overtakes packets of a higher class. This
+	 *   holds bus-wide as long as all nodes configure the same class
+	 *   priorities. Only the priority byte of the arbitration header
+	 *   changes, so nodes with and without aging can share a bus.
+	 *
+	 * @param max_steps Steps a packet may gain. There are at most seven,
+	 *  fewer if the next class is close; 8 allows all of them. 0 disables
+	 *  aging, which is the default.
+	 */
+	void set_priority_aging(uint8_t max_steps);
+
+	/*!\brief Returns if the bus is free at the moment.
+	 * \details This function returns true if the bus is currently free.
+	 *   A free bus is either in 'IDLE' state, or the last received
+	 *   byte has been the TX idle time or longer ago, in which case the former
+	 *   transmission is assumed to have aborted.
+	 */
+	bool is_idle();
+
+	/*! \brief Set the baudrate of the bus.
+	 *  \details Only used to convert the idle times of set_idle_timeouts()
+	 *   into platform ticks when the transport has no receiver timeout.
+	 *   Defaults to 250000. The UART itself must still be configured by the user.
+	 */
+	void set_baudrate(uint32_t baudrate);
+	/*! \brief Set the bus idle times.
+	 *  \details Idle times are given in bit-times, and thusly scale with
+	 *   the baudrate and do not depend on the platform tick rate.
+	 *   If the transport has a receiver timeout, the START condition is
+	 *   detected by the hardware, and the remainder of the TX idle time is
+	 *   measured with get_timer_count(). Otherwise the platform tick is used,
+	 *   rounded up to whole ticks.
+	 *
+	 * @param reset_bits Idle time after which a 0x00 counts as START,
+	 *  FURCOM_IDLE_RESET_BITS by default.
+	 * @param tx_bits Idle time after which this node may send a START,
+	 *  FURCOM_IDLE_TX_BITS by default. Must not be shorter than reset_bits.
+	 */
+	void set_idle_timeouts(uint32_t reset_bits, uint32_t tx_bits);
+
+	/*! \brief Return the number of queue bytes a packet will take.
+	 *  \details This is the SLIP-encoded length of topic, separator and
+	 *   payload plus the terminating FURCOM_END, and can be compared
+	 *   against get_tx_free(). Packets sent with a topic ID take less.
+	 */
+	static size_t encoded_packet_size(const char *topic, const void *data_ptr, size_t length);
+	/*! \brief Return the free space of a TX queue.
+	 *  \details Returns the largest encoded_packet_size() that would
+	 *   currently fit into the queue of the given class. Other producers may
+	 *   take the space at any time, so this is meant for pacing only.
+	 */
+	size_t get_tx_free(tx_priority_t priority = PRIO_NORMAL) const;
+
+	/*! \brief Send a complete packet, if there is room for it.
+	 *  \details Encodes topic and data straight into the TX queue of the
+	 *   given priority class and starts transmission. This function takes
+	 *   no locks and may be called from any thread as well as from
+	 *   interrupts, concurrently with all other send functions.
+	 *   Interrupts must not preempt handle_isr() though, i.e. they must not
+	 *   have a higher priority than the transport's interrupt.
+	 *
+	 *   If the queue is full, nothing is queued and false returned; the
+	 *   handler is not called in that case.
+	 *
+	 *  \param topic Topic to send this message under. Must be a valid string, null-terminated.
+	 *  \param data_ptr Pointer to the binary payload.
+	 *  \param length Length of the payload, in bytes.
+	 *  \param priority Priority class to queue this packet in.
+	 *  \param handler Optional handler called once the packet has left the wire, see tx_done_handler_t.
+	 *  \param context Context pointer passed to the handler.
+	 *  \return false if the packet did not fit into the queue.
+	 */
+	bool send_packet(const char *topic, const void *data_ptr, size_t length,
+			tx_priority_t priority = PRIO_NORMAL,
+			tx_done_handler_t handler = nullptr, void *context = nullptr);
+	/*! \brief Queue a complete, decoded frame.
+	 *  \details The header and frame are SLIP-encoded into the queue as
+	 *   they are, without adding a topic or CRC, so together they must
+	 *   make up a valid frame of one of the frame_marker_t formats or a
+	 *   plain packet. Meant for bridges such as the Router, which pass on
+	 *   received frames. Same context rules as send_packet().
+	 *
+	 * @param header Optional data to put in front of the frame, i.e. a FURCOM_MARKER_ROUTED header.
+	 * @param header_length Length of the header, may be 0.
+	 * @return false if the frame is too long, or did not fit into the queue.
+	 */
+	bool send_frame(const void *header, size_t header_length,
+			const void *frame, size_t length, tx_priority_t priority = PRIO_NORMAL);
+
+	/*! \brief Send a complete packet, waiting for queue space.
+	 *  \details Same as send_packet(), but if the queue is full, waits for
+	 *   up to timeout ticks for frames to leave the queue. Must not be
+	 *   called from interrupts. Fails immediately for packets that could
+	 *   never fit into the queue.
+	 *
+	 *  \param timeout Maximum time to wait, in ticks.
+	 *  \return false if the packet could not be queued in time.
+	 */
+	bool send_packet_wait(const char *topic, const void *data_ptr, size_t length,
+			uint32_t timeout, tx_priority_t priority = PRIO_NORMAL,
+			tx_done_handler_t handler = nullptr, void *context = nullptr);
+
+	/*! \brief Reserve queue space for a packet.
+	 *  \details Lock-free alternative to start_packet(), for packets that
+	 *   are assembled from several pieces. Space for the topic and up to
+	 *   max_length bytes of (unescaped) payload is reserved and the topic
+	 *   written; payload is then appended with add_packet_data(tx_reservation_t&)
+	 *   and the packet sent with commit_packet().
+	 *   Other producers may keep queueing packets meanwhile, but will not
+	 *   be sent before this one is committed, so reservations should be
+	 *   short-lived. May be called from interrupts.
+	 *
+	 *  \param reservation Reservation to fill.
+	 *  \param topic Topic to send this message under. Must be a valid string, null-terminated.
+	 *  \param max_length Maximum payload length.
+	 *  \param priority Priority class to queue this packet in.
+	 *  \param handler Optional handler called once the packet has left the wire, see tx_done_handler_t.
+	 *  \param context Context pointer passed to the handler.
+	 *  \return false if not enough queue space was available.
+	 */
+	bool reserve_packet(tx_reservation_t &reservation, const char *topic, size_t max_length,
+			tx_priority_t priority = PRIO_NORMAL,
+			tx_done_handler_t handler = nullptr, void *context = nullptr);
+	//! Append payload to a reservation made with reserve_packet().
+	void add_packet_data(tx_reservation_t &reservation, const void *data_ptr, size_t length);
+	//! Send the packet of a reservation made with reserve_packet().
+	void commit_packet(tx_reservation_t &reservation);
+
+	/*! \brief Begin writing a packet into the FurComs buffer.
+	 *  \details This function MUST be called before any data may be written
+	 *   into the buffer for transmission. It appends the given topic to the
+	 *   buffer and adds a proper separator, and will additionally lock the
+	 *   platform's packet mutex to avoid concurrent buffer access.
+	 *   As the final packet length is not known, as much queue space as a
+	 *   maximum length packet could need is reserved, and unused space
+	 *   returned in close_packet(). If not even the topic fits, the packet
+	 *   is dropped.
+	 *   Prefer send_packet() or reserve_packet(), which do not need the mutex
+	 *   and can be used from interrupts.
+	 *
+	 *	\attention close_packet() MUST be called after start_packet() and add_packet_data()
+	 *	 have been used. Ignoring this WILL cause a deadlock, as the mutex used for buffer
+	 *	 access will never be released!
+	 *
+	 *  Every priority class has its own queue, and the handler will always
+	 *  arbitrate for the bus with the oldest packet of the highest-priority
+	 *  class that has packets pending, using that class' arbitration priority.
+	 *
+	 *  \param topic Topic to send this message under. Must be a valid string, null-terminated.
+	 *  \param priority Priority class to queue this packet in.
+	 */
+	void start_packet(const char *topic, tx_priority_t priority = PRIO_NORMAL);
+
+	/*! \brief Append data to the packet.
+	 *  \details Append the given 'length' bytes of data from 'data_ptr' to
+	 *    the internal buffer. Data will be appropriately escaped according
+	 *    to the modified SLIP encoding, and can thusly be binary.
+	 *    start_packet() MUST have been called before this function to
+	 *    properly configure the buffer
+	 *    Note that maximum packet length is 256 bytes including
+	 *    topic but excluding escape characters!
+	 *
+	 *  \param data_ptr Pointer to the data to be copied into the buffer.
+	 *  \param length Length, in bytes, of the data to be copied.
+	 */
+	void add_packet_data(const void *data_ptr, size_t length);
+	/*! \brief Begin sending a packet.
+	 *  \details This will release the transmit buffer mutex, and will
+	 *   start transmission of this packet.
+	 */
+	void close_packet();
+
+	/*! \brief Enable batch frames.
+	 *  \details When enabled, the handler packs queued packets of up to
+	 *   FURCOM_BATCH_RECORD_MAX bytes into one frame of the
+	 *   FURCOM_MARKER_BATCH format, as long as they are of the same
+	 *   priority class and fit into the handler's frame length together.
+	 *   This saves the START, arbitration header and STOP of every
+	 *   packet but the first, which dominate the bus time of small packets.
+	 *
+	 *   Receiving batch frames is always supported, but all nodes on the bus
+	 *   must be able to decode them before any node enables batching.
+	 */
+	void set_batching(bool enabled);
+
+	/*! \brief Set a handler for raw received frames.
+	 *  \details The handler sees every frame received on this bus as it
+	 *   is, straight from the RX buffer, before the frame is dispatched to
+	 *   subscriptions and on_rx. It runs on the receiver thread, and must
+	 *   be set before init(). Used by the Router.
+	 */
+	void set_frame_handler(frame_handler_t handler, void *context = nullptr);
+
+	/*! \brief Protect sent packets with a CRC.
+	 *  \details When enabled, every packet is queued in the
+	 *   FURCOM_MARKER_CRC format, with a CRC-32 of its content. This adds
+	 *   FURCOM_CRC_OVERHEAD bytes, which are taken from the maximum
+	 *   packet length. The CRC is computed while the packet is encoded into
+	 *   the queue, outside of the ISR. Packets keep their CRC when they are
+	 *   packed into a batch frame.
+	 *
+	 *   Receiving CRC frames is always supported: frames with a wrong CRC
+	 *   are dropped from the ISR before they take up an RX buffer, and
+	 *   counted in bus_stats_t::rx_crc_errors. Frames without CRC are still
+	 *   accepted, so nodes with and without CRC can share a bus, but
+	 *   receivers that predate the CRC format cannot decode these frames.
+	 */
+	void set_crc(bool enabled);
+
+	/*! \brief Drop frames nobody subscribed to from the ISR.
+	 *  \details When enabled, the topic of every received frame is matched
+	 *   against the subscriptions while it arrives, see
+	 *   Subscription_Table::filter_step(). Once its NUL separator came in,
+	 *   a frame that matches no subscription is abandoned: the rest is
+	 *   skipped up to the STOP, it takes up no RX buffer and the receiver
+	 *   thread is not woken. This keeps busy buses from filling the RX
+	 *   buffers with unwanted frames, and it is counted in
+	 *   bus_stats_t::rx_filtered.
+	 *
+	 *   Routed and CRC headers are looked past. Frames of the other
+	 *   formats (batches, topic IDs, fragments) always pass. Nothing is
+	 *   filtered while on_rx or a frame handler is set, as they want every frame.
+	 */
+	void set_rx_filter(bool enabled);
+
+	/*! \brief Run a service from process_tx().
+	 *  \details For layers built on the handler that need to act at
+	 *   certain times, i.e. RPC_Client. The service must stay valid.
+	 *  \attention Same restrictions as subscribe() apply.
+	 */
+	void add_tx_service(tx_service_t &service);
+
+	//! Return true if queued packets get a CRC, see set_crc().
+	bool get_crc() const { return tx_crc; }
+	//! Return true if queued packets use topic IDs, see set_topic_ids().
+	bool get_topic_ids() const { return tx_topic_ids; }
+	/*! \brief Return the TX queue of a priority class.
+	 *  \details For layers that write frames into the queue themselves,
+	 *   i.e. to reopen() them, see State_Publisher. Frames must be
+	 *   committed with commit_packet(), so that transmission starts.
+	 */
+	TX_Queue &get_tx_queue(tx_priority_t priority) { return tx_queues[priority]; }
+	//! Return the longest packet that fits into a frame, topic included, in decoded bytes.
+	size_t get_max_packet_length(bool with_crc) const;
+	/*! \brief Write a topic as it goes into a frame.
+	 *  \details Either the topic string with its separator, or the topic
+	 *   ID marker and ID if topic IDs are enabled and the topic has one.
+	 */
+	void prepare_topic(const char *topic, packet_topic_t &out);
+	/*! \brief Queue a packet behind a frame header.
+	 *  \details Implements send_packet(). The prefix is put in front of
+	 *   the topic, inside the CRC if there is one, i.e. a
+	 *   FURCOM_MARKER_FRAGMENT header. The payload header is put in front
+	 *   of the payload, i.e. the correlation ID of an RPC.
+	 */
+	bool queue_packet(const void *prefix, size_t prefix_length,
+			const char *topic, const void *payload_header, size_t header_length,
+			const void *data_ptr, size_t length,
+			tx_priority_t priority, tx_done_handler_t handler, void *context);
+
+	/*! \brief Keep received data beyond its receive handler.
+	 *  \details Data handed to subscriptions and on_rx lies in an RX
+	 *   buffer, which is reused once the handler returned. Called from the
+	 *   handler, this instead keeps the buffer out of use until the loan is
+	 *   handed back with return_rx(), so the data can be processed by
+	 *   another thread without copying it first. Any data of the frame
+	 *   being dispatched may be loaned, any number of times.
+	 *
+	 *   Reception goes on with the remaining RX buffers meanwhile. To keep
+	 *   at least one of them for reception, a loan is refused once all
+	 *   other buffers are loaned. Handlers should then copy the data, as
+	 *   before. Nodes that loan buffers for longer than a frame time want
+	 *   more of them, see Handler_Storage.
+	 *
+	 * @param data Data handed to the receive handler, or part of it.
+	 * @param length Length of that data.
+	 * @param loan Output loan, to be passed to return_rx().
+	 * @return false if not called from a receive handler of this handler,
+	 *  the data does not lie in the frame, or too many buffers are loaned.
+	 */
+	bool loan_rx(const void *data, size_t length, rx_loan_t &loan);
+	/*! \brief Hand back a loan taken with loan_rx().
+	 *  \details The loaned data must not be accessed anymore. Safe to call
+	 *   from any thread and from interrupts. Does nothing for loans that
+	 *   were already returned or refused.
+	 */
+	void return_rx(rx_loan_t &loan);
+	//! Return the number of RX buffer loans not yet returned.
+	int get_rx_loans() const { return rx_pool.get_loans(); }
+
+	/*! \brief Send packets with numeric topic IDs.
+	 *  \details When enabled, every packet whose topic has an ID in the
+	 *   dictionary is sent in the FURCOM_MARKER_TOPIC_ID format, replacing
+	 *   the topic string and separator with one to four bytes.
+	 *   IDs are added with add_topic_id(), add_topic_ids() or by receiving
+	 *   an announcement, see announce_topic_id().
+	 *
+	 *   Receiving ID packets is always supported. Receivers must know the
+	 *   ID to dispatch the packet by topic, see on_rx_id otherwise.
+	 */
+	void set_topic_ids(bool enabled);
+	/*! \brief Announce a topic ID on the bus.
+	 *  \details Sends the ID and its topic on FURCOM_TOPIC_ID_ANNOUNCE.
+	 *   All receiving nodes add it to their dictionary.
+	 * @return false if the ID is unknown, or the packet could not be queued.
+	 */
+	bool announce_topic_id(topic_id_t id, tx_priority_t priority = PRIO_NORMAL);
+
+	/*! \brief Drop all queued packets of a priority class.
+	 *  \details Completion handlers of dropped packets are called with
+	 *   sent set to false. A packet that is already being arbitrated for or
+	 *   sent is not dropped. Packets still being written are not affected,
+	 *   but queued ones behind them are.
+	 *
+	 * @return Number of dropped packets.
+	 */
+	int flush_tx(tx_priority_t priority);
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_PROTOCOLCORE_H_ */
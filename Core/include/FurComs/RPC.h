@@ -0,0 +1,228 @@
+/*!
+ * \file RPC.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_RPC_H_
+#define FURCOMS_RPC_H_
+
+#include <FurComs/ProtocolCore.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#ifndef FURCOM_RPC_PENDING_NUM
+//! Calls one RPC_Client can have outstanding at once.
+#define FURCOM_RPC_PENDING_NUM 8
+#endif
+
+#ifndef FURCOM_RPC_REPLY_LENGTH
+//! Longest result an RPC_Method can reply with, in bytes.
+#define FURCOM_RPC_REPLY_LENGTH 64
+#endif
+
+//! Topic all RPC replies are sent on.
+#define FURCOM_RPC_REPLY_TOPIC "rpc/reply"
+
+/*! Length of the header leading the payload of an RPC request.
+ *  It is the correlation ID of the call: the client ID as two bytes
+ *  little-endian, then the call ID of that client. The arguments follow. */
+#define FURCOM_RPC_REQUEST_HEADER_LENGTH 3
+/*! Length of the header leading the payload of an RPC reply.
+ *  It is the correlation ID of the request, then an rpc_status_t byte.
+ *  The result follows. */
+#define FURCOM_RPC_REPLY_HEADER_LENGTH 4
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Status of a completed RPC call.
+ *  \details Methods may return their own codes, between RPC_ERROR and
+ *   RPC_TIMEOUT.
+ */
+enum rpc_status_t : uint8_t {
+	RPC_OK = 0,         //!< The method succeeded.
+	RPC_ERROR = 1,      //!< The method failed.
+	RPC_TIMEOUT = 0xFF, //!< No reply came in before the deadline, set by the client.
+};
+
+/*! \brief RPC completion handler.
+ *  \details Called exactly once per call that RPC_Client::call() accepted,
+ *   from the handler's receiver thread, once the reply came in or the
+ *   call timed out. May start new calls.
+ *
+ * @param context Context pointer given with the call.
+ * @param status Status byte of the reply, see rpc_status_t.
+ * @param data Result of the method, nullptr on RPC_TIMEOUT.
+ * @param length Length of the result, in bytes.
+ */
+typedef void (*rpc_done_handler_t)(void *context, uint8_t status, const void *data, size_t length);
+
+//! Result buffer handed to an rpc_method_t.
+struct rpc_reply_t {
+	uint8_t *data; //!< Buffer to write the result to.
+	size_t size;   //!< Size of the buffer, FURCOM_RPC_REPLY_LENGTH.
+	size_t length; //!< Length of the result written, 0 unless set.
+};
+
+/*! \brief RPC method implementation.
+ *  \details Called from the receiver thread for every request, just
+ *   like a subscription. The reply is sent once it returns.
+ *
+ * @param context Context pointer given with the RPC_Method.
+ * @param args Arguments of the call.
+ * @param length Length of the arguments, in bytes.
+ * @param reply Buffer to write the result to.
+ * @return Status to reply with, see rpc_status_t.
+ */
+typedef uint8_t (*rpc_method_t)(void *context, const void *args, size_t length, rpc_reply_t &reply);
+
+/*! \brief Caller of RPC methods on other nodes.
+ *  \details Sends requests on the topic of a method, with a correlation
+ *   ID made of this client's ID and a call ID leading the payload, see
+ *   FURCOM_RPC_REQUEST_HEADER_LENGTH. Every RPC_Method replies on
+ *   FURCOM_RPC_REPLY_TOPIC with the same correlation ID, so replies are
+ *   told apart even with several calls outstanding, and client IDs only
+ *   need to be unique among the nodes that call methods.
+ *
+ *   Up to FURCOM_RPC_PENDING_NUM calls can be outstanding at once. Calls
+ *   are pipelined: requests are queued right away, and replies may come
+ *   back in any order.
+ *
+ *   Once attach()ed, replies complete their calls from the receiver
+ *   thread, and Protocol_Core::process_tx(), which runs on the same
+ *   thread, times out calls that are past their deadline through a
+ *   tx_service_t. Completion handlers are thusly never called concurrently.
+ */
+class RPC_Client {
+private:
+	enum call_state_t : uint8_t {
+		CALL_FREE,
+		CALL_CLAIMED, //!< Being filled by call(), ignored by the receiver thread.
+		CALL_SENDING, //!< Request is being queued, a reply may already come in.
+		CALL_PENDING, //!< Waiting for the reply or the deadline.
+		CALL_REPLIED, //!< Completed while CALL_SENDING, freed by call().
+	};
+
+	struct pending_call_t {
+		std::atomic<uint8_t> state;
+		uint8_t call_id;
+		uint32_t deadline;
+		rpc_done_handler_t handler;
+		void *context;
+	};
+
+	Protocol_Core &handler;
+	uint16_t client_id;
+	//! Times out calls from Protocol_Core::process_tx().
+	tx_service_t service;
+
+	pending_call_t calls[FURCOM_RPC_PENDING_NUM];
+	std::atomic<uint8_t> next_call_id;
+
+	uint32_t completed_count;
+	uint32_t timeout_count;
+
+	static void handle_reply(void *context, const char *topic, const void *data, size_t length);
+	//! Time out calls past their deadline, return ticks until the next one.
+	static uint32_t handle_service(void *context, uint32_t now);
+
+public:
+	/*! \brief Construct a client.
+	 * @param handler Handler to send requests on.
+	 * @param client_id ID of this client, unique among all RPC clients on the bus.
+	 */
+	RPC_Client(Protocol_Core &handler, uint16_t client_id);
+
+	RPC_Client(const RPC_Client&) = delete;
+	RPC_Client &operator=(const RPC_Client&) = delete;
+
+	/*! \brief Attach the client to its handler.
+	 *  \details Subscribes to FURCOM_RPC_REPLY_TOPIC, and adds the service
+	 *   that times out calls, see Protocol_Core::add_tx_service().
+	 *  \attention Same restrictions as Protocol_Core::subscribe() apply.
+	 * @return false if the subscription table is full.
+	 */
+	bool attach();
+
+	/*! \brief Call a method.
+	 *  \details Queues the request and returns right away, the handler is
+	 *   called once the call completed. Safe to call from any thread,
+	 *   including from completion handlers, but not from interrupts.
+	 *
+	 * @param method Topic of the method.
+	 * @param args Arguments to send.
+	 * @param length Length of the arguments, in bytes.
+	 * @param handler Handler to call with the result.
+	 * @param context Context pointer passed to the handler.
+	 * @param timeout Ticks to wait for the reply.
+	 * @param priority Priority class to queue the request in.
+	 * @return false if FURCOM_RPC_PENDING_NUM calls are outstanding, or the
+	 *  request could not be queued. The handler is not called then.
+	 */
+	bool call(const char *method, const void *args, size_t length,
+			rpc_done_handler_t handler, void *context, uint32_t timeout,
+			tx_priority_t priority = PRIO_NORMAL);
+
+	//! Return the number of calls outstanding.
+	int get_pending() const;
+	//! Return the number of calls that received a reply.
+	uint32_t get_completed() const { return completed_count; }
+	//! Return the number of calls that timed out.
+	uint32_t get_timeouts() const { return timeout_count; }
+};
+
+/*! \brief Method served to RPC clients.
+ *  \details Once attach()ed to a handler, every request on the method's
+ *   topic is handed to its rpc_method_t, and the result sent back on
+ *   FURCOM_RPC_REPLY_TOPIC with the correlation ID of the request.
+ *   Results longer than FURCOM_RPC_REPLY_LENGTH are cut off.
+ */
+class RPC_Method {
+private:
+	Protocol_Core *handler;
+	const char *topic;
+	rpc_method_t method;
+	void *context;
+	tx_priority_t priority;
+
+	uint32_t served_count;
+	uint32_t dropped_count;
+
+	static void handle_request(void *context, const char *topic, const void *data, size_t length);
+
+public:
+	/*! \brief Construct a method.
+	 * @param topic Topic of the method. Must stay valid (i.e. a string literal).
+	 * @param method Implementation of the method.
+	 * @param context Context pointer passed to the implementation.
+	 * @param priority Priority class to queue replies in.
+	 */
+	RPC_Method(const char *topic, rpc_method_t method, void *context = nullptr,
+			tx_priority_t priority = PRIO_NORMAL);
+
+	RPC_Method(const RPC_Method&) = delete;
+	RPC_Method &operator=(const RPC_Method&) = delete;
+
+	/*! \brief Serve the method on a handler.
+	 *  \details Subscribes to the method's topic, replies are sent on
+	 *   the same handler.
+	 *  \attention Same restrictions as Protocol_Core::subscribe() apply.
+	 * @return false if the subscription table is full.
+	 */
+	bool attach(Protocol_Core &handler);
+
+	//! Return the number of requests replied to.
+	uint32_t get_served() const { return served_count; }
+	//! Return the number of requests whose reply did not fit into the TX queue.
+	uint32_t get_dropped() const { return dropped_count; }
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_RPC_H_ */
@@ -0,0 +1,149 @@
+/*!
+ * \file RXPool.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_RXPOOL_H_
+#define FURCOMS_RXPOOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief FurComs RX Buffer.
+ *  \details A buffer for exactly one received packet. Packet length is
+ *    limited to the handler's frame length, at most 256 bytes, to ease
+ *    storing. Each packet is stored in its own continuous buffer, ensuring
+ *    easy handling at the cost of slight memory inefficiency.
+ *
+ *    Buffers are handed around by an RX_Pool, see there.
+ */
+struct rx_buffer_t {
+	char * raw_data;  //!< Data of the packet, one frame length and a terminator long.
+	char * data_end;  //!< Pointer to the end of data.
+
+	/*! Holders of the buffer: the ISR or, once filled, the receiver
+	 *  thread, and every loan. Back in the free list once 0. */
+	std::atomic<uint16_t> refs;
+	//! Next buffer in the free list, RX_Pool::NONE for the last.
+	std::atomic<uint16_t> next_free;
+};
+
+/*! \brief Handle of a loaned RX buffer.
+ *  \details Handed out by Protocol_Core::loan_rx(), and handed back to
+ *   Protocol_Core::return_rx(). Keeps the received data valid meanwhile.
+ */
+struct rx_loan_t {
+	int buffer;       //!< Index of the loaned buffer, -1 if none.
+	const void *data; //!< Data that was loaned, as passed to loan_rx().
+	size_t length;    //!< Length of that data, in bytes.
+};
+
+/*! \brief Pool of RX buffers, shared between the ISR and any number of threads.
+ *  \details Free buffers sit in a lock-free free list (a Treiber stack).
+ *   The ISR claims one at the start of every frame, and hands it to the
+ *   receiver thread through an SPSC ready queue once the frame is
+ *   complete. The receiver thread dispatches it, and releases it back
+ *   into the free list afterwards.
+ *
+ *   A receive handler may take a loan on the buffer it is handed, see
+ *   Protocol_Core::loan_rx(), which keeps it out of the free list until
+ *   the loan is returned, from whichever thread. Frames no longer need to
+ *   be copied to be processed elsewhere, and the receiver thread moves on
+ *   to the next buffer meanwhile, so the ISR only runs out of buffers
+ *   once all of them are loaned or waiting.
+ *
+ *   Buffers are counted by references, so several handlers may take loans
+ *   on the same frame. The free list head holds a tag next to the index
+ *   of the top buffer, counted up on every change, so that a claim() can
+ *   not succeed on a stale next link, even if the buffer it looked at was
+ *   taken and returned meanwhile.
+ *
+ *   The buffers themselves are supplied with set_storage(), usually by a
+ *   Handler_Storage, so their number is chosen per handler.
+ */
+class RX_Pool {
+public:
+	//! Index standing for no buffer.
+	static constexpr uint16_t NONE = 0xFFFF;
+
+private:
+	rx_buffer_t *buffers;
+	//! Ready queue of buffer indices, buffer_count of them.
+	uint16_t *ready;
+	int buffer_count;
+
+	//! Tag in the upper, index of the top buffer in the lower 16 bits.
+	std::atomic<uint32_t> free_head;
+
+	//! Written by the ISR only, see push_ready().
+	std::atomic<uint32_t> ready_head;
+	//! Written by the receiver thread only, see pop_ready().
+	std::atomic<uint32_t> ready_tail;
+
+	//! Loans not yet returned.
+	std::atomic<int> loan_count;
+
+	void push_free(int index);
+
+public:
+	RX_Pool();
+
+	/*! \brief Hand the pool its buffers.
+	 *  \details Must be called once, before the pool is used. All buffers
+	 *   start out free.
+	 *
+	 * @param buffers Buffer descriptors, count of them.
+	 * @param ready Ready queue storage, count entries.
+	 * @param count Number of buffers, a power of two below NONE.
+	 * @param data Data of all buffers, count * (frame_length + 1) bytes.
+	 * @param frame_length Longest frame a buffer holds. Every buffer has
+	 *  one more byte, for the terminator added by the receiver thread.
+	 */
+	void set_storage(rx_buffer_t *buffers, uint16_t *ready, int count,
+			char *data, size_t frame_length);
+
+	//! Return the number of buffers.
+	int get_count() const { return buffer_count; }
+	//! Return a buffer by index.
+	rx_buffer_t &operator[](int index) { return buffers[index]; }
+
+	/*! \brief Take a buffer from the free list, for the ISR.
+	 *  \details The buffer starts out empty, with one reference.
+	 * @return Index of the buffer, -1 if none is free.
+	 */
+	int claim();
+	/*! \brief Hand a filled buffer to the receiver thread, for the ISR.
+	 *  \details The reference of claim() moves along with it.
+	 */
+	void push_ready(int index);
+	/*! \brief Take the oldest filled buffer, for the receiver thread.
+	 * @return Index of the buffer, -1 if none is waiting.
+	 */
+	int pop_ready();
+
+	/*! \brief Add a reference to a buffer.
+	 *  \details Only valid while the caller holds one already.
+	 * @param loan Count the reference as a loan, see get_loans().
+	 */
+	void retain(int index, bool loan = false);
+	/*! \brief Drop a reference to a buffer, which is freed with the last.
+	 *  \details Safe to call from any thread and from interrupts.
+	 * @param loan Reference was counted as a loan.
+	 */
+	void release(int index, bool loan = false);
+
+	//! Return the number of loans not yet returned.
+	int get_loans() const { return loan_count.load(std::memory_order_relaxed); }
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_RXPOOL_H_ */
@@ -0,0 +1,144 @@
+/*!
+ * \file Router.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_ROUTER_H_
+#define FURCOMS_ROUTER_H_
+
+#include <FurComs/ProtocolCore.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#ifndef FURCOM_ROUTER_PORT_NUM
+//! Maximum number of buses a Router connects.
+#define FURCOM_ROUTER_PORT_NUM 4
+#endif
+#ifndef FURCOM_ROUTER_ROUTE_NUM
+//! Maximum number of routes of a Router.
+#define FURCOM_ROUTER_ROUTE_NUM 16
+#endif
+#ifndef FURCOM_ROUTER_MAX_HOPS
+//! Default number of routers a frame may pass, see Router::set_max_hops().
+#define FURCOM_ROUTER_MAX_HOPS 4
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Forwarding counters of a Router, see Router::get_stats(). */
+struct router_stats_t {
+	uint32_t forwarded;      //!< Frames or records queued on another bus.
+	uint32_t dropped_loop;   //!< Frames that came back to this router, or passed too many routers.
+	uint32_t dropped_queue;  //!< Frames that were too long for the extra header, or did not fit into the destination queue.
+};
+
+/*! \brief Forwards frames between several FurComs buses.
+ *  \details Every bus is one port, handled by its own Protocol_Core, i.e.
+ *   one LL_Handler per UART. Routes select by topic which frames are
+ *   passed from which ports to which others.
+ *
+ *   Frames are taken straight from the receiving handler's RX buffer, on
+ *   its receiver thread, and SLIP-encoded into the destination's TX queue
+ *   in one pass with Protocol_Core::send_frame(). Payloads are thusly never
+ *   copied, parsed or re-assembled, and no extra thread is involved.
+ *   Topic IDs, CRCs and other frame formats are passed on unchanged; the
+ *   CRC of a frame is checked end-to-end by its final receivers. Batch
+ *   frames are split, and their records routed one by one.
+ *
+ *   Forwarded frames are put into the FURCOM_MARKER_ROUTED format, which
+ *   carries the number of routers passed and the ID of the first router.
+ *   A router drops frames that carry its own ID, or that have passed
+ *   set_max_hops() routers, so frames cannot circle forever if routers
+ *   form a loop. Buses connected by several paths still see one copy
+ *   per path.
+ *
+ *   The router may be used from all receiver threads at once; routes
+ *   must be set up before the handlers are started.
+ */
+class Router {
+private:
+	struct route_t {
+		const char *pattern;    //!< Topic, or prefix if is_prefix is set.
+		size_t pattern_length;
+		bool is_prefix;
+		uint32_t from_ports;    //!< Bitmask of ports this route takes frames from.
+		uint32_t to_ports;      //!< Bitmask of ports this route forwards to.
+		tx_priority_t priority;
+	};
+
+	Protocol_Core *ports[FURCOM_ROUTER_PORT_NUM];
+	int port_count;
+
+	route_t routes[FURCOM_ROUTER_ROUTE_NUM];
+	int route_count;
+
+	uint16_t router_id;
+	uint8_t max_hops;
+
+	std::atomic<uint32_t> forwarded;
+	std::atomic<uint32_t> dropped_loop;
+	std::atomic<uint32_t> dropped_queue;
+
+	static void handle_frame(void *context, Protocol_Core &handler, const char *frame, size_t length);
+
+	void route_packet(int port, const char *packet, size_t length);
+	bool get_topic(int port, const char *packet, size_t length,
+			const char *&topic, size_t &topic_length) const;
+
+public:
+	/*! \brief Construct a router.
+	 * @param router_id ID put into forwarded frames for loop prevention.
+	 *  Must be unique among the routers of the connected buses, using
+	 *  the router's chip ID is a good choice.
+	 */
+	Router(uint16_t router_id);
+
+	Router(const Router&) = delete;
+	Router &operator=(const Router&) = delete;
+
+	/*! \brief Connect a bus.
+	 *  \details Installs the router as the handler's frame handler, see
+	 *   Protocol_Core::set_frame_handler(). Must be called before the
+	 *   handler is started.
+	 * @return Port number of the bus, for add_route(), or -1 if all ports are taken.
+	 */
+	int add_port(Protocol_Core &handler);
+
+	/*! \brief Add a route.
+	 *  \details Frames received on one of from_ports whose topic matches
+	 *   the pattern are queued on all of to_ports but the one they came
+	 *   from. A frame matching several routes is forwarded to the union of
+	 *   their ports, in the most urgent of their priority classes.
+	 *
+	 *   Packets with a topic ID are matched by the topic the receiving
+	 *   handler has in its dictionary. IDs it does not know only match
+	 *   the catch-all pattern "*". Note that all buses must use the same
+	 *   IDs for forwarded packets to be understood.
+	 *
+	 * @param pattern Topic or topic prefix ending in '*', as for
+	 *  Packet_Dispatcher::subscribe(). Must stay valid (i.e. a string literal).
+	 * @param from_ports Bitmask of ports, bit n for the port add_port() returned n for.
+	 * @param to_ports Bitmask of ports to forward to.
+	 * @param priority Priority class forwarded frames are queued in.
+	 * @return false if the route table is full.
+	 */
+	bool add_route(const char *pattern, uint32_t from_ports, uint32_t to_ports,
+			tx_priority_t priority = PRIO_NORMAL);
+
+	//! Set the number of routers a frame may pass, FURCOM_ROUTER_MAX_HOPS by default.
+	void set_max_hops(uint8_t hops) { max_hops = hops; }
+
+	//! Copy the forwarding counters.
+	void get_stats(router_stats_t &out) const;
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_ROUTER_H_ */
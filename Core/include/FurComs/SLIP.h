@@ -0,0 +1,77 @@
+/*!
+ * \file SLIP.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_SLIP_H_
+#define FURCOMS_SLIP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Special FURCOMS characters.
+ *  \details This enum defines the special characters used in Furcoms encoding.
+ *   Encoding is performed in the same manner as for SLIP encoding (RFC 1055),
+ *   however with the END character modified to be 0x00. This ensures that
+ *   END is a dominant character on a CAN-Bus line, and that it can thusly
+ *   overwrite messages.
+ * \see https://tools.ietf.org/html/rfc1055
+ */
+enum fur_coms_chars_t {
+	FURCOM_END = 0x00,
+	FURCOM_ESCAPE = 0xDB,
+	FURCOM_ESC_END = 0xDC,
+	FURCOM_ESC_ESC = 0xDD
+};
+
+/*! \brief Return the SLIP-encoded length of the given data.
+ *  \details Every FURCOM_END and FURCOM_ESCAPE takes two bytes, all other
+ *   bytes one. The terminating FURCOM_END is not included.
+ */
+size_t slip_encoded_length(const void *data, size_t length);
+/*! \brief SLIP-encode data into a buffer.
+ *  \details Same encoding as TX_Queue::add_data(). No FURCOM_END is appended.
+ *
+ * @param dst Output buffer, must have room for slip_encoded_length() bytes.
+ * @return Number of bytes written.
+ */
+size_t slip_encode(const void *src, size_t length, uint8_t *dst);
+/*! \brief Return the decoded length of SLIP-encoded data.
+ *  \details The data must be a valid encoding without FURCOM_END, i.e.
+ *   every FURCOM_ESCAPE is followed by its escaped character.
+ */
+size_t slip_decoded_length(const uint8_t *encoded, size_t length);
+
+/*! \brief Decode a span of SLIP-encoded bytes.
+ *  \details Unescapes bytes from src into dst, stopping either at the
+ *   first FURCOM_END (which is NOT consumed) or at the end of the span.
+ *   Clean runs without special characters are copied in bulk.
+ *
+ *   Semantics are identical to decoding byte by byte: an escape followed by
+ *   anything but FURCOM_ESC_END or FURCOM_ESC_ESC is dropped, and once dst
+ *   reaches dst_end all further bytes up to the next FURCOM_END are
+ *   discarded without touching had_escape.
+ *
+ *   This function has no hardware dependencies, and can thusly be
+ *   used on the host for testing and benchmarking.
+ *
+ * @param src Encoded input bytes.
+ * @param length Number of input bytes available.
+ * @param dst Output write pointer, advanced past all written bytes.
+ * @param dst_end End of the output buffer, no bytes will be written here or after.
+ * @param had_escape Escape state, carried over between calls.
+ * @return Number of consumed input bytes.
+ */
+size_t slip_decode_span(const uint8_t *src, size_t length,
+		char *&dst, const char *dst_end, bool &had_escape);
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_SLIP_H_ */
@@ -0,0 +1,370 @@
+/*!
+ * \file Schema.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_SCHEMA_H_
+#define FURCOMS_SCHEMA_H_
+
+#include <FurComs/ProtocolCore.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+/*! \brief Declare a field of a message schema.
+ *  \details Declares a tag type NAME, carrying the field's type and its
+ *   name for generated decoders, see Schema_Fields. TYPE is one of the
+ *   fixed-width integers, bool, float, double, or an array of uint8_t or
+ *   char, i.e. `char[16]`.
+ */
+#define FURCOM_SCHEMA_FIELD(NAME, TYPE) \
+	struct NAME : TEF::FurComs::Schema_Field<TYPE> { \
+		static constexpr const char *field_name() { return #NAME; } \
+	}
+
+namespace TEF {
+namespace FurComs {
+
+//! Read a little-endian unsigned integer, regardless of alignment.
+template<typename U>
+inline U schema_read_le(const uint8_t *data) {
+	U value = 0;
+	for(size_t i = 0; i < sizeof(U); i++)
+		value |= U(data[i]) << (8*i);
+
+	return value;
+}
+
+//! Write a little-endian unsigned integer, regardless of alignment.
+template<typename U>
+inline void schema_write_le(uint8_t *data, U value) {
+	for(size_t i = 0; i < sizeof(U); i++)
+		data[i] = uint8_t(value >> (8*i));
+}
+
+/*! \brief Wire format of one field type.
+ *  \details Specialised for every supported type. Each has the value type
+ *   handed out, its SIZE on the wire, read() and write(), and the Ruby
+ *   pack() directive (ruby_pack() and RUBY_COUNT) and ruby_kind() for
+ *   generated decoders, see schema_write_ruby().
+ */
+template<typename T>
+struct schema_type;
+
+//! Integer types, as little-endian two's complement.
+template<typename T, typename U>
+struct schema_int_type {
+	typedef T value_t;
+	static constexpr size_t SIZE = sizeof(T);
+	static constexpr size_t RUBY_COUNT = 0;
+
+	static value_t read(const uint8_t *data) {
+		return value_t(schema_read_le<U>(data));
+	}
+	static void write(uint8_t *data, value_t value) {
+		schema_write_le<U>(data, U(value));
+	}
+	static constexpr const char *ruby_kind() { return "int"; }
+};
+
+template<> struct schema_type<uint8_t> : schema_int_type<uint8_t, uint8_t> {
+	static constexpr const char *ruby_pack() { return "C"; }
+};
+template<> struct schema_type<int8_t> : schema_int_type<int8_t, uint8_t> {
+	static constexpr const char *ruby_pack() { return "c"; }
+};
+template<> struct schema_type<uint16_t> : schema_int_type<uint16_t, uint16_t> {
+	static constexpr const char *ruby_pack() { return "S<"; }
+};
+template<> struct schema_type<int16_t> : schema_int_type<int16_t, uint16_t> {
+	static constexpr const char *ruby_pack() { return "s<"; }
+};
+template<> struct schema_type<uint32_t> : schema_int_type<uint32_t, uint32_t> {
+	static constexpr const char *ruby_pack() { return "L<"; }
+};
+template<> struct schema_type<int32_t> : schema_int_type<int32_t, uint32_t> {
+	static constexpr const char *ruby_pack() { return "l<"; }
+};
+template<> struct schema_type<uint64_t> : schema_int_type<uint64_t, uint64_t> {
+	static constexpr const char *ruby_pack() { return "Q<"; }
+};
+template<> struct schema_type<int64_t> : schema_int_type<int64_t, uint64_t> {
+	static constexpr const char *ruby_pack() { return "q<"; }
+};
+
+//! One byte, 0 or 1. Anything but 0 reads as true.
+template<>
+struct schema_type<bool> {
+	typedef bool value_t;
+	static constexpr size_t SIZE = 1;
+	static constexpr size_t RUBY_COUNT = 0;
+
+	static value_t read(const uint8_t *data) { return data[0] != 0; }
+	static void write(uint8_t *data, value_t value) { data[0] = value ? 1 : 0; }
+
+	static constexpr const char *ruby_pack() { return "C"; }
+	static constexpr const char *ruby_kind() { return "bool"; }
+};
+
+//! IEEE 754 floats, in the byte order of the integers.
+template<typename T, typename U>
+struct schema_float_type {
+	static_assert(sizeof(T) == sizeof(U), "Float size does not match its integer!");
+
+	typedef T value_t;
+	static constexpr size_t SIZE = sizeof(T);
+	static constexpr size_t RUBY_COUNT = 0;
+
+	static value_t read(const uint8_t *data) {
+		U bits = schema_read_le<U>(data);
+		value_t value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+	static void write(uint8_t *data, value_t value) {
+		U bits;
+		memcpy(&bits, &value, sizeof(bits));
+		schema_write_le<U>(data, bits);
+	}
+	static constexpr const char *ruby_kind() { return "float"; }
+};
+
+template<> struct schema_type<float> : schema_float_type<float, uint32_t> {
+	static constexpr const char *ruby_pack() { return "e"; }
+};
+template<> struct schema_type<double> : schema_float_type<double, uint64_t> {
+	static constexpr const char *ruby_pack() { return "E"; }
+};
+
+/*! \brief Fixed-length byte arrays.
+ *  \details Read as a pointer into the payload, without a copy.
+ */
+template<size_t N>
+struct schema_type<uint8_t[N]> {
+	typedef const uint8_t *value_t;
+	static constexpr size_t SIZE = N;
+	static constexpr size_t RUBY_COUNT = N;
+
+	static value_t read(const uint8_t *data) { return data; }
+	static void write(uint8_t *data, value_t value) { memcpy(data, value, N); }
+
+	static constexpr const char *ruby_pack() { return "a"; }
+	static constexpr const char *ruby_kind() { return "bytes"; }
+};
+
+/*! \brief Fixed-length strings, padded with NULs.
+ *  \details Read as a pointer into the payload, without a copy. A string
+ *   filling the whole field has no terminating NUL, so read it with
+ *   a length limit, i.e. strnlen(value, N). Longer strings are cut off
+ *   when written.
+ */
+template<size_t N>
+struct schema_type<char[N]> {
+	typedef const char *value_t;
+	static constexpr size_t SIZE = N;
+	static constexpr size_t RUBY_COUNT = N;
+
+	static value_t read(const uint8_t *data) { return reinterpret_cast<const char*>(data); }
+	static void write(uint8_t *data, value_t value) {
+		size_t length = 0;
+		while(length < N && value[length] != 0)
+			length++;
+
+		memcpy(data, value, length);
+		memset(data + length, 0, N - length);
+	}
+
+	static constexpr const char *ruby_pack() { return "Z"; }
+	static constexpr const char *ruby_kind() { return "string"; }
+};
+
+//! Base of field tags, see FURCOM_SCHEMA_FIELD().
+template<typename T>
+struct Schema_Field {
+	typedef schema_type<T> type;
+};
+
+/*! \brief Layout of a message schema.
+ *  \details Fields are packed in the given order, without padding, each
+ *   in little-endian byte order. Fields are only ever appended to a
+ *   schema, so that older and newer nodes keep understanding each other,
+ *   see Schema_View::get().
+ *
+ * @tparam F Field tags, declared with FURCOM_SCHEMA_FIELD().
+ */
+template<typename... F>
+struct Schema_Fields;
+
+template<>
+struct Schema_Fields<> {
+	static constexpr size_t LENGTH = 0;
+	static constexpr size_t COUNT = 0;
+
+	//! Offset of a field, past any payload if it is not part of the schema.
+	template<typename G>
+	static constexpr size_t offset_of() { return SIZE_MAX / 2; }
+
+	//! Call visit(F()) for every field, in order.
+	template<typename V>
+	static void for_each(V &&visit) { (void)visit; }
+};
+
+template<typename F, typename... REST>
+struct Schema_Fields<F, REST...> {
+	static constexpr size_t LENGTH = F::type::SIZE + Schema_Fields<REST...>::LENGTH;
+	static constexpr size_t COUNT = 1 + sizeof...(REST);
+
+	template<typename G>
+	static constexpr size_t offset_of() {
+		return std::is_same<F, G>::value ? 0 : F::type::SIZE + Schema_Fields<REST...>::template offset_of<G>();
+	}
+
+	template<typename V>
+	static void for_each(V &&visit) {
+		visit(F());
+		Schema_Fields<REST...>::for_each(visit);
+	}
+};
+
+/*! \brief Typed, read-only view of a received message.
+ *  \details Wraps the payload as handed to a receive handler, which still
+ *   lies in the RX buffer, and reads fields straight from it: no copy
+ *   into a struct, and no parsing of text. Every access is checked
+ *   against the received length, and converted from the wire's byte
+ *   order, so the same code works on any platform and alignment.
+ *
+ *   A schema is a struct with a TOPIC and the list of its fields:
+ *
+ *       struct Battery_Status {
+ *           static constexpr const char *TOPIC = "power/battery";
+ *
+ *           FURCOM_SCHEMA_FIELD(voltage_mv, uint16_t);
+ *           FURCOM_SCHEMA_FIELD(current_ma, int16_t);
+ *           FURCOM_SCHEMA_FIELD(charging, bool);
+ *
+ *           typedef Schema_Fields<voltage_mv, current_ma, charging> fields;
+ *       };
+ *
+ *   And is read in its receive handler with:
+ *
+ *       Schema_View<Battery_Status> status(data, length);
+ *       uint16_t voltage = status.get<Battery_Status::voltage_mv>();
+ *
+ * @tparam S Schema of the message.
+ */
+template<typename S>
+class Schema_View {
+private:
+	const uint8_t *data;
+	size_t length;
+
+public:
+	typedef typename S::fields fields;
+	//! Length of a message with all fields.
+	static constexpr size_t LENGTH = fields::LENGTH;
+
+	/*! \brief Construct a view.
+	 * @param data Payload of the message, must stay valid while the view is used.
+	 * @param length Length of the payload, in bytes.
+	 */
+	Schema_View(const void *data, size_t length) :
+			data(reinterpret_cast<const uint8_t*>(data)), length(length) {
+	}
+
+	//! Return true if the message has all fields of the schema.
+	bool valid() const { return length >= LENGTH; }
+
+	//! Return true if the message has the given field.
+	template<typename F>
+	bool has() const {
+		return fields::template offset_of<F>() + F::type::SIZE <= length;
+	}
+
+	/*! \brief Read a field.
+	 *  \details Fields the message is too short for, i.e. because it was
+	 *   sent with an older version of the schema, read as 0, false or
+	 *   nullptr.
+	 */
+	template<typename F>
+	typename F::type::value_t get() const {
+		constexpr size_t offset = fields::template offset_of<F>();
+		static_assert(offset + F::type::SIZE <= LENGTH, "Field is not part of this schema!");
+
+		if(offset + F::type::SIZE > length)
+			return typename F::type::value_t();
+
+		return F::type::read(data + offset);
+	}
+
+	//! Return the raw payload.
+	const void *get_data() const { return data; }
+	//! Return the length of the raw payload.
+	size_t get_length() const { return length; }
+};
+
+/*! \brief Message to send, kept in its wire format.
+ *  \details set() converts a field into the payload right away, so
+ *   send() hands the payload to Protocol_Core::send_packet() as it is,
+ *   which escapes it straight into the TX queue. There is no packing
+ *   step, and no intermediate buffer.
+ *
+ * @tparam S Schema of the message, see Schema_View.
+ */
+template<typename S>
+class Schema_Message {
+public:
+	typedef typename S::fields fields;
+	static constexpr size_t LENGTH = fields::LENGTH;
+
+private:
+	static_assert(LENGTH > 0, "Schema has no fields!");
+
+	uint8_t payload[LENGTH];
+
+public:
+	//! Construct a message with all fields 0.
+	Schema_Message() : payload() {
+	}
+
+	//! Write a field.
+	template<typename F>
+	void set(typename F::type::value_t value) {
+		constexpr size_t offset = fields::template offset_of<F>();
+		static_assert(offset + F::type::SIZE <= LENGTH, "Field is not part of this schema!");
+
+		F::type::write(payload + offset, value);
+	}
+
+	//! Read back a field.
+	template<typename F>
+	typename F::type::value_t get() const {
+		return view().template get<F>();
+	}
+
+	//! Return a view of the payload.
+	Schema_View<S> view() const { return Schema_View<S>(payload, LENGTH); }
+
+	//! Return the payload, in wire format.
+	const void *get_data() const { return payload; }
+	//! Return the payload length, which is fixed.
+	size_t get_length() const { return LENGTH; }
+
+	/*! \brief Send the message on the schema's topic.
+	 *  \details Same as Protocol_Core::send_packet(), and may be called from
+	 *   the same contexts.
+	 */
+	bool send(Protocol_Core &handler, tx_priority_t priority = PRIO_NORMAL,
+			tx_done_handler_t done_handler = nullptr, void *context = nullptr) const {
+		return handler.send_packet(S::TOPIC, payload, LENGTH, priority, done_handler, context);
+	}
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_SCHEMA_H_ */
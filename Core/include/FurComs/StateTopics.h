@@ -0,0 +1,191 @@
+/*!
+ * \file StateTopics.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_STATETOPICS_H_
+#define FURCOMS_STATETOPICS_H_
+
+#include <FurComs/ProtocolCore.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Sender of a state topic, conflating updates.
+ *  \details State topics, such as a brightness, a mode or a battery
+ *   level, only ever need their newest value on the bus. send_packet()
+ *   queues every update, so a burst of updates is sent in full, each
+ *   value outdated by the one queued behind it.
+ *
+ *   publish() instead rewrites the frame of its last update in place, see
+ *   TX_Queue::reopen(), for as long as that frame waits in the queue, lost
+ *   arbitrations included. Only once the handler started to send it, a
+ *   new frame is queued. A burst thusly costs at most two frames on the bus, the last
+ *   of them carrying the newest value.
+ *
+ *   Should the new value not fit into the block of the old frame, i.e.
+ *   because it needs more escapes, it is queued as a new frame behind
+ *   the old one.
+ *
+ *   publish() must not be called concurrently, i.e. it should be called
+ *   from one thread. The handler may be used by others meanwhile.
+ */
+class State_Publisher {
+private:
+	Protocol_Core &handler;
+	const char *topic;
+	tx_priority_t priority;
+
+	//! Frames of this publisher not yet released by the handler.
+	std::atomic<int> in_flight;
+	//! tx_reservation_t::start of the newest frame.
+	uint32_t last_position;
+
+	uint32_t published_count;
+	uint32_t replaced_count;
+
+	static void handle_done(void *context, bool sent);
+
+public:
+	/*! \brief Construct a publisher.
+	 * @param handler Handler to queue on.
+	 * @param topic Topic to publish. Must stay valid (i.e. a string literal).
+	 * @param priority Priority class to queue in.
+	 */
+	State_Publisher(Protocol_Core &handler, const char *topic, tx_priority_t priority = PRIO_NORMAL);
+
+	State_Publisher(const State_Publisher&) = delete;
+	State_Publisher &operator=(const State_Publisher&) = delete;
+
+	/*! \brief Publish a new value.
+	 *  \details Replaces the value still waiting in the queue, if there is
+	 *   one, or queues a new packet. Topic IDs and CRCs are applied as set
+	 *   on the handler. May be called from interrupts.
+	 *
+	 * @return false if the packet did not fit into the queue, or is too long
+	 *  for the handler's frame length.
+	 */
+	bool publish(const void *data, size_t length);
+	/*! \brief Publish a new value, copied as it is in memory.
+	 *  \details I.e. a number or a plain struct, in the byte order of the platform.
+	 */
+	template<typename T>
+	bool publish(const T &value) {
+		return publish(&value, sizeof(T));
+	}
+
+	//! Return the number of successful publish() calls.
+	uint32_t get_published() const { return published_count; }
+	//! Return how many of them replaced a queued value instead of queueing a packet.
+	uint32_t get_replaced() const { return replaced_count; }
+};
+
+/*! \brief Last received value of a state topic.
+ *  \details Keeps a copy of the newest message on one topic, once added
+ *   with Packet_Dispatcher::add_state_cache(), so it can be read at any
+ *   time with read() instead of every node keeping its own copy from a
+ *   receive handler.
+ *
+ *   The value is double-buffered: a message is written into the buffer
+ *   not currently read, then published by counting up the update number.
+ *   read() copies the current buffer and retries should an update have
+ *   been completed meanwhile. The buffers are kept in atomic words, so
+ *   that a read racing with the writer stays well-defined. It never waits for the receiver thread, so
+ *   it may be called from any thread and from interrupts.
+ *
+ *   Messages longer than the cache are dropped and counted, see
+ *   get_dropped(). Storage is part of the State_Cache template, see there.
+ */
+class State_Cache_Base {
+private:
+	friend Packet_Dispatcher;
+
+	const char *topic;
+
+	//! Two buffers of buffer_size bytes each, stored in buffer_words words.
+	std::atomic<uint32_t> *buffers;
+	size_t buffer_size;
+	size_t buffer_words;
+	std::atomic<size_t> lengths[2];
+
+	//! Number of values received, the current one is in buffer update_count & 1.
+	std::atomic<uint32_t> update_count;
+	uint32_t dropped_count;
+
+	static void handle_message(void *context, const char *topic, const void *data, size_t length);
+
+protected:
+	/*! \brief Construct a cache on the given storage.
+	 *  \details Storage is only stored, it is not accessed before the first
+	 *   message, so it may be a not-yet-constructed member of the subclass.
+	 *
+	 * @param topic Exact topic to keep. Must stay valid (i.e. a string literal).
+	 * @param buffers Storage of 2*words(size) words.
+	 * @param size Longest value, in bytes.
+	 */
+	State_Cache_Base(const char *topic, std::atomic<uint32_t> *buffers, size_t size);
+
+	//! Return the number of words a buffer of size bytes takes.
+	static constexpr size_t words(size_t size) { return (size + 3) / 4; }
+
+public:
+	State_Cache_Base(const State_Cache_Base&) = delete;
+	State_Cache_Base &operator=(const State_Cache_Base&) = delete;
+
+	/*! \brief Copy out the newest value.
+	 * @param data Buffer to copy to.
+	 * @param size Size of the buffer, longer values are cut off.
+	 * @param update Optional output of the update number of the value, see get_updates().
+	 * @return Length of the value, which may be more than size. 0 if none was received yet.
+	 */
+	size_t read(void *data, size_t size, uint32_t *update = nullptr) const;
+	/*! \brief Copy out the newest value into a number or a plain struct.
+	 * @return false if no value was received yet, or it is not exactly sizeof(T) long.
+	 */
+	template<typename T>
+	bool read(T &value) const {
+		return read(&value, sizeof(T)) == sizeof(T);
+	}
+
+	//! Return true once a value was received.
+	bool has_value() const { return update_count.load(std::memory_order_acquire) != 0; }
+	//! Return the number of values received, e.g. to tell whether the value changed since the last read().
+	uint32_t get_updates() const { return update_count.load(std::memory_order_acquire); }
+	//! Return the number of messages dropped for being too long.
+	uint32_t get_dropped() const { return dropped_count; }
+};
+
+/*! \brief State cache with its own storage.
+ *  \details See State_Cache_Base. Takes twice LENGTH bytes of RAM,
+ *   rounded up to whole words.
+ *
+ * @tparam LENGTH Longest value, in bytes.
+ */
+template<size_t LENGTH>
+class State_Cache : public State_Cache_Base {
+private:
+	static_assert(LENGTH > 0, "LENGTH must not be zero!");
+
+	std::atomic<uint32_t> buffer_data[2*words(LENGTH)];
+
+public:
+	/*! \brief Construct a cache.
+	 * @param topic Exact topic to keep. Must stay valid (i.e. a string literal).
+	 */
+	State_Cache(const char *topic) :
+			State_Cache_Base(topic, buffer_data, LENGTH),
+			buffer_data() {
+	}
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_STATETOPICS_H_ */
@@ -0,0 +1,158 @@
+/*!
+ * \file Subscriptions.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_SUBSCRIPTIONS_H_
+#define FURCOMS_SUBSCRIPTIONS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+#ifndef FURCOM_SUBSCRIPTION_NUM
+#define FURCOM_SUBSCRIPTION_NUM 64
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+typedef uint32_t topic_hash_t;
+
+//! Initial value of the FNV-1a topic hash
+constexpr topic_hash_t FURCOM_TOPIC_HASH_SEED = 2166136261u;
+
+//! Add a single character to a running FNV-1a topic hash.
+constexpr topic_hash_t topic_hash_step(topic_hash_t hash, char c) {
+	return (hash ^ uint8_t(c)) * 16777619u;
+}
+
+/*! \brief Compute the hash of a topic string.
+ *  \details FNV-1a hash over all characters of the topic, excluding the
+ *   terminating null. Can be evaluated at compile time, i.e.
+ *   `constexpr auto h = topic_hash("Led/Brightness");`
+ */
+constexpr topic_hash_t topic_hash(const char *topic, topic_hash_t hash = FURCOM_TOPIC_HASH_SEED) {
+	return (*topic == 0) ? hash : topic_hash(topic + 1, topic_hash_step(hash, *topic));
+}
+
+/*! \brief Topic receive handler.
+ *  \details Called for every received message that matches the subscription.
+ *   The data is only valid until the handler returns, unless it is loaned,
+ *   see Protocol_Core::loan_rx().
+ *
+ * @param context Context pointer given at subscription time.
+ * @param topic Topic string of the message, null-terminated.
+ * @param data Pointer to the received binary data.
+ * @param length Length of the received data, in bytes.
+ */
+typedef void (*rx_handler_t)(void *context, const char *topic, const void *data, size_t length);
+
+//! Result of Subscription_Table::filter_step().
+enum topic_filter_result_t {
+	TOPIC_FILTER_PENDING, //!< No decision yet, feed the next character.
+	TOPIC_FILTER_PASS,    //!< A subscription may match the topic.
+	TOPIC_FILTER_REJECT,  //!< No subscription matches the topic.
+};
+
+//! Running state of Subscription_Table::filter_step().
+struct topic_filter_t {
+	topic_hash_t hash;
+	size_t position;
+};
+
+/*! \brief Hash-indexed topic subscription table.
+ *  \details This table maps topics to receive handlers. Subscriptions may
+ *   either be exact topic strings, or prefixes ending in a '*' wildcard.
+ *   A pattern of "Led/" plus the wildcard matches "Led/Brightness" as well
+ *   as "Led/Mode", a single "*" matches everything.
+ *
+ *   Lookup is done via open addressing on the FNV-1a hash of the topic.
+ *   For prefix subscriptions, the hash of the incoming topic is computed
+ *   incrementally, and only at lengths for which a prefix is registered
+ *   will the table be probed. Dispatch thusly costs a single pass over the
+ *   topic string plus one probe per matching prefix length, independent of
+ *   the number of subscriptions.
+ *
+ *   \attention The table is not locked. Subscriptions must either be made
+ *    before LL_Handler::init() is called, or from within a receive handler.
+ *   \note Patterns are not copied and must thusly stay valid, which
+ *    string literals do.
+ */
+class Subscription_Table {
+private:
+	struct entry_t {
+		topic_hash_t hash;
+		const char *pattern;
+		uint8_t prefix_length; //!< Length of the prefix, or 0xFF for an exact subscription.
+		rx_handler_t handler;  //!< Handler, nullptr for an unused or removed entry.
+		void *context;
+	};
+
+	static constexpr size_t TABLE_SIZE = FURCOM_SUBSCRIPTION_NUM;
+	static_assert((TABLE_SIZE & (TABLE_SIZE - 1)) == 0, "FURCOM_SUBSCRIPTION_NUM must be a power of two!");
+
+	std::array<entry_t, TABLE_SIZE> entries;
+	//! Entries that are not free, subscriptions and removed ones alike.
+	size_t used_entries;
+	//! Entries holding a subscription.
+	size_t live_entries;
+
+	//! Bitmap of registered prefix lengths, bit N set for a prefix of length N.
+	uint64_t prefix_lengths;
+
+	int dispatch_entries(topic_hash_t hash, uint8_t prefix_length, const char *topic,
+			const void *data, size_t length) const;
+	bool has_entry(topic_hash_t hash, uint8_t prefix_length) const;
+	void update_prefix_lengths();
+
+public:
+	Subscription_Table();
+
+	/*! \brief Add a subscription.
+	 *
+	 * @param pattern Exact topic, or prefix ending in '*'. Prefixes are
+	 *   limited to 63 characters.
+	 * @param handler Handler to call for matching messages.
+	 * @param context Context pointer passed to the handler.
+	 * @return false if the table is full or the pattern is invalid.
+	 */
+	bool subscribe(const char *pattern, rx_handler_t handler, void *context = nullptr);
+	/*! \brief Remove a subscription.
+	 *  \details Removes the first subscription matching all three arguments.
+	 *   Its entry is reused by later subscriptions.
+	 * @return true if a subscription was removed.
+	 */
+	bool unsubscribe(const char *pattern, rx_handler_t handler, void *context = nullptr);
+
+	/*! \brief Call all handlers matching the topic.
+	 * @return Number of handlers that were called.
+	 */
+	int dispatch(const char *topic, const void *data, size_t length) const;
+
+	//! Start matching a new topic with filter_step().
+	static void filter_start(topic_filter_t &filter) {
+		filter.hash = FURCOM_TOPIC_HASH_SEED;
+		filter.position = 0;
+	}
+	/*! \brief Match a topic one character at a time.
+	 *  \details Checks whether any subscription could match a topic as it
+	 *   is being received, i.e. from an ISR, without the topic having to
+	 *   be complete or stored. Feed the characters of the topic and then
+	 *   its terminating NUL until a decision is returned.
+	 *
+	 *   Subscriptions are only compared by hash, so a topic sharing the
+	 *   hash of a subscription passes as well; dispatch() sorts it out.
+	 *   The table is read without locking, a topic that arrives while a
+	 *   subscription is being added may still be matched without it.
+	 */
+	topic_filter_result_t filter_step(topic_filter_t &filter, char c) const;
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_SUBSCRIPTIONS_H_ */
@@ -0,0 +1,346 @@
+/*!
+ * \file TXQueue.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_TXQUEUE_H_
+#define FURCOMS_TXQUEUE_H_
+
+#include <FurComs/CRC.h>
+#include <FurComs/SLIP.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#ifndef FURCOM_TX_QUEUE_SIZE
+//! Default size of every TX_Queue, in bytes, see Handler_Storage.
+#define FURCOM_TX_QUEUE_SIZE 512
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Transmit priority classes.
+ *  \details Every class has its own TX_Queue, and the handler will always
+ *   arbitrate with the frame at the head of the highest-priority non-empty
+ *   class. This prevents urgent messages from waiting behind bulk data.
+ */
+enum tx_priority_t {
+	PRIO_URGENT = 0, //!< E-Stop and similar, default arbitration priority -60
+	PRIO_HIGH,       //!< Important messages, default arbitration priority -30
+	PRIO_NORMAL,     //!< Default class, arbitration priority set by set_priority()
+	PRIO_BULK,       //!< Telemetry and other bulk data, lowest arbitration priority
+	PRIO_CLASS_NUM,
+};
+
+class TX_Queue;
+
+/*! \brief Packet completion handler.
+ *  \details Called once a packet has either fully left the wire, or has
+ *   been dropped from the queue by Protocol_Core::flush_tx().
+ *   Called from the transport interrupt, so it must be short; setting a
+ *   flag or releasing a semaphore is fine, sending another packet with
+ *   Protocol_Core::send_packet() is as well.
+ *
+ * @param context Context pointer given when the packet was queued.
+ * @param sent true if the packet was sent, false if it was dropped.
+ */
+typedef void (*tx_done_handler_t)(void *context, bool sent);
+
+/*! \brief Space reserved in a TX_Queue.
+ *  \details Handed out by TX_Queue::reserve(). The producer owns the
+ *   space between data_ptr and data_end until it calls TX_Queue::commit().
+ */
+struct tx_reservation_t {
+	TX_Queue *queue;   //!< Queue this reservation belongs to, nullptr if invalid.
+	uint32_t start;    //!< Queue position of the reserved block.
+	uint8_t *data_ptr; //!< Next byte to write encoded data to.
+	uint8_t *data_end; //!< End of the reserved data space.
+	bool overflow;     //!< Set if data had to be dropped because the reservation was full.
+	bool has_crc;      //!< Set by TX_Queue::start_crc(), commit() appends the trailer.
+	uint32_t crc;      //!< CRC of the data added since TX_Queue::start_crc().
+	bool reopened;     //!< Set by TX_Queue::reopen(), the frame is queued already.
+};
+
+/*! \brief Lock-free queue of pre-encoded frames waiting for transmission.
+ *  \details A ring buffer of SLIP-encoded frames, each terminated with
+ *   FURCOM_END. Any number of producers, including interrupts, may write
+ *   frames concurrently; the handler's ISR is the only consumer.
+ *
+ *   Writing a frame is done in three steps:
+ *   - reserve() atomically claims a contiguous block of worst-case size
+ *     by advancing the reservation head with a compare-and-swap.
+ *   - add_data() SLIP-encodes data straight into the reservation.
+ *   - commit() terminates the frame, returns unused space if no other
+ *     producer reserved behind it, and publishes the block by storing
+ *     its queue position into the block header.
+ *
+ *   The consumer walks the blocks in order and stops at the first one that
+ *   is not yet committed. Blocks never wrap around the end of the ring; if
+ *   the remaining space is too small, it is filled with a padding block.
+ *   Frames are thusly always contiguous, which suits DMA transmission.
+ *
+ *   The ring itself is supplied with set_storage(), usually by a
+ *   Handler_Storage, so its size is chosen per handler.
+ *
+ *   A committed frame the consumer has not started to send yet can be
+ *   rewritten with reopen(). The consumer claims every frame before it
+ *   sends or drops it, by setting a flag in the block tag with a compare-and-swap,
+ *   and reopen() flags the tag with the same, so only one of them wins.
+ */
+class TX_Queue {
+private:
+	struct block_header_t {
+		std::atomic<uint32_t> tag; //!< Queue position of this block once committed.
+		//! Size of the block, including this header, ORed with block flags.
+		std::atomic<uint16_t> block_size;
+		uint16_t length;           //!< Encoded frame length, or PADDING_LENGTH.
+	};
+	//! Stored behind the block header if a completion handler was given.
+	struct block_callback_t {
+		tx_done_handler_t handler;
+		void *context;
+	};
+
+	//! Block sizes are multiples of 8, the low bits hold flags.
+	enum block_flags_t : uint16_t {
+		BLOCK_HAS_CALLBACK = 1,
+		BLOCK_DROPPED = 2,
+		BLOCK_FLAGS = 7,
+	};
+	//! Block positions are multiples of 8 as well, the low bits of a tag are flags.
+	enum tag_flags_t : uint32_t {
+		TAG_REOPENED = 1, //!< Being rewritten, see reopen(). Not committed meanwhile.
+		TAG_CLAIMED = 2,  //!< Seen by the consumer, can no longer be reopened.
+		TAG_RESERVED = 4, //!< Being written for the first time, block_size is valid.
+		//! Reserved, and walked past by drop_frames(), so its size must not change.
+		TAG_PINNED = TAG_RESERVED | TAG_CLAIMED,
+		//! Reserved, and being shrunk by commit(), so drop_frames() stops there.
+		TAG_COMMITTING = TAG_RESERVED | TAG_REOPENED,
+		TAG_FLAGS = 7,
+	};
+
+	static constexpr uint32_t HEADER_SIZE = sizeof(block_header_t);
+	static constexpr uint16_t PADDING_LENGTH = 0xFFFF;
+	static constexpr uint32_t CALLBACK_SIZE = (sizeof(block_callback_t) + 7) & ~uint32_t(7);
+
+	static_assert(HEADER_SIZE == 8, "Block headers must be 8 bytes!");
+
+	//! Position up to which space has been handed out to producers.
+	std::atomic<uint32_t> reserve_head;
+	//! Position of the oldest block not yet released by the consumer.
+	std::atomic<uint32_t> tail;
+	//! Number of committed frames, neither released nor dropped.
+	std::atomic<int> packet_count;
+	//! Most bytes of the ring ever in use, see get_high_water().
+	std::atomic<uint32_t> high_water;
+
+	//! Block returned by peek_frame()
+	uint32_t peek_block;
+	//! Block last returned by peek_frame() or peek_next()
+	uint32_t peek_cursor;
+	//! peek_cursor before the last peek_next(), see unpeek_next()
+	uint32_t peek_previous;
+
+	//! Ring storage, see set_storage().
+	uint8_t *data;
+	uint32_t queue_size;
+	//! queue_size - 1, queue positions are wrapped with it.
+	uint32_t size_mask;
+
+	static uint32_t align_block(uint32_t size) {
+		return (size + 7) & ~uint32_t(7);
+	}
+	block_header_t &header_at(uint32_t position) {
+		return *reinterpret_cast<block_header_t*>(data + (position & size_mask));
+	}
+	const block_header_t &header_at(uint32_t position) const {
+		return *reinterpret_cast<const block_header_t*>(data + (position & size_mask));
+	}
+	static block_callback_t &callback_of(block_header_t &header) {
+		return *reinterpret_cast<block_callback_t*>(reinterpret_cast<uint8_t*>(&header) + HEADER_SIZE);
+	}
+	static uint8_t *frame_of(block_header_t &header) {
+		return reinterpret_cast<uint8_t*>(&header) + HEADER_SIZE
+				+ ((header.block_size & BLOCK_HAS_CALLBACK) ? CALLBACK_SIZE : 0);
+	}
+
+	void publish(uint32_t position, uint16_t length);
+	//! Claim a committed frame for the consumer, false if it is being reopened.
+	static bool claim(block_header_t &header, uint32_t position);
+	/*! Find the oldest committed frame, without claiming it. Padding and
+	 *  dropped frames are released on the way. */
+	bool find_head(uint32_t &position);
+	/*! Move an empty queue from the given tail position to the start of
+	 *  the ring, so that frames of up to max_reservation() fit again. */
+	void rewind(uint32_t position);
+
+public:
+	//! Raw priority byte to use in arbitration_package_t when sending this class.
+	uint8_t arbitration_priority;
+
+	TX_Queue();
+
+	/*! \brief Hand the queue its ring storage.
+	 *  \details Must be called once, before the queue is used.
+	 *
+	 * @param data Storage, 8-byte aligned. Must stay valid as long as the queue.
+	 * @param size Size of the storage, in bytes. Must be a power of two of
+	 *  at least 64 and at most 32768, see Handler_Storage.
+	 */
+	void set_storage(uint8_t *data, uint32_t size);
+	//! Return the size of the ring, in bytes.
+	uint32_t get_size() const { return queue_size; }
+
+	/*! \brief Reserve space for a frame.
+	 *  \details Claims a contiguous block with room for at least min_length
+	 *   and at most max_length encoded bytes, plus the terminating FURCOM_END.
+	 *   Safe to call from any thread and from interrupts.
+	 *
+	 * @param reservation Output reservation, to be passed to add_data() and commit().
+	 * @param min_length Minimum number of encoded bytes that must fit.
+	 * @param max_length Number of encoded bytes to reserve if space allows.
+	 * @param handler Optional completion handler, see tx_done_handler_t.
+	 * @param context Context pointer passed to the handler.
+	 * @return false if not even min_length bytes are available.
+	 */
+	bool reserve(tx_reservation_t &reservation, size_t min_length, size_t max_length,
+			tx_done_handler_t handler = nullptr, void *context = nullptr);
+
+	/*! \brief SLIP-encode and append data to a reservation.
+	 *  \details Data that does not fit is dropped, and the reservation's
+	 *   overflow flag set.
+	 */
+	static void add_data(tx_reservation_t &reservation, const void *data_ptr, size_t length);
+	/*! \brief Append already SLIP-encoded data to a reservation.
+	 *  \details Copied as is, so it must not contain FURCOM_END, and is
+	 *   not fed into a CRC started with start_crc(). Data that does not fit
+	 *   is dropped, and the reservation's overflow flag set.
+	 */
+	static void add_encoded(tx_reservation_t &reservation, const void *data_ptr, size_t length);
+	/*! \brief Protect the rest of a reservation with a CRC trailer.
+	 *  \details All data added from now on is also fed into the frame CRC,
+	 *   see crc_update(), and commit() appends the CRC big-endian and SLIP
+	 *   encoded before the FURCOM_END. Room for the encoded trailer is kept
+	 *   back right away, so the reservation must have at least
+	 *   2*FURCOM_CRC_LENGTH bytes left.
+	 *   Data that was dropped for lack of space is not part of the CRC.
+	 *
+	 * @return false if there was no room for the trailer.
+	 */
+	static bool start_crc(tx_reservation_t &reservation);
+
+	/*! \brief Rewrite a frame that is still waiting in the queue.
+	 *  \details Hands out the block of the frame committed at the given
+	 *   position as a reservation, to be filled with add_data() and
+	 *   committed as usual. The frame keeps its place in the queue and its
+	 *   completion handler. cancel() drops the frame instead.
+	 *
+	 *   Fails once the consumer has seen the frame, i.e. because it is
+	 *   being sent or has been released, and if the block can not hold
+	 *   length encoded bytes. The frame is then left as it is.
+	 *   A frame must only be reopened by one producer at a time.
+	 *
+	 * @param position tx_reservation_t::start of the frame's reservation.
+	 *  Should only be passed while the frame's completion handler has not
+	 *  been called, the block may hold any other data afterwards.
+	 * @param length Number of encoded bytes that must fit.
+	 * @return false if the frame could not be reopened.
+	 */
+	bool reopen(tx_reservation_t &reservation, uint32_t position, size_t length);
+
+	//! Terminate the reserved frame and hand it to the consumer.
+	void commit(tx_reservation_t &reservation);
+	//! Discard a reservation without sending anything. Reopened frames are dropped.
+	void cancel(tx_reservation_t &reservation);
+
+	//! Return the number of frames committed and neither sent nor dropped.
+	int get_packet_count() const { return packet_count.load(); }
+	//! Return the largest frame, in encoded bytes, that could ever be reserved.
+	size_t max_reservation() const { return queue_size - HEADER_SIZE - 1; }
+	/*! \brief Return the largest frame, in encoded bytes, that always fits once the frames ahead of it left.
+	 *  \details Blocks do not wrap, so a frame longer than half the queue
+	 *   may only fit once the queue ran empty, depending on where in the
+	 *   ring the queue stands. Producers that must not get stuck behind
+	 *   their own frames, i.e. those that retry from completion handlers,
+	 *   keep below this.
+	 * @param with_handler Leave room for a completion handler.
+	 */
+	size_t max_safe_reservation(bool with_handler = false) const {
+		return queue_size/2 - HEADER_SIZE - (with_handler ? CALLBACK_SIZE : 0) - 1;
+	}
+	/*! \brief Return the largest frame, in encoded bytes, that could be reserved right now.
+	 *  \details Includes neither the terminating FURCOM_END nor space for a
+	 *   completion handler. Other producers may take the space at any time,
+	 *   so this is only a hint for pacing, reserve() may still fail.
+	 */
+	size_t get_free_space() const;
+
+	/*! \brief Return the most bytes of the ring that were in use at once.
+	 *  \details Sampled whenever a frame is committed, including block
+	 *   headers and padding. Compare against get_size().
+	 */
+	uint32_t get_high_water() const { return high_water.load(std::memory_order_relaxed); }
+	//! Restart the high-water mark from zero.
+	void reset_high_water() { high_water.store(0, std::memory_order_relaxed); }
+
+	/*! \brief Return the encoded frame at the head of the queue.
+	 *  \details The frame is returned including its terminating FURCOM_END,
+	 *   in one piece, as blocks never wrap. Frames marked by drop_frames()
+	 *   are released on the way. Consumer only, i.e. the handler ISR.
+	 *
+	 * @return false if the oldest frame has not been committed yet.
+	 */
+	bool peek_frame(const uint8_t *&ptr, size_t &length);
+	/*! \brief Check whether the oldest frame has been committed.
+	 *  \details Like peek_frame(), but the frame is not claimed, so it may
+	 *   still be reopened, i.e. while it is being arbitrated for. Padding
+	 *   and dropped frames are looked past, not released. Consumer only.
+	 */
+	bool has_frame() const;
+	/*! \brief Release padding and dropped frames at the head of the queue.
+	 *  \details peek_frame() does so on the way to the next frame. This
+	 *   frees their space without taking a frame, i.e. after drop_frames().
+	 *   Consumer only.
+	 */
+	void release_dropped();
+	/*! \brief Return the frame after the one last peeked.
+	 *  \details Used to look ahead of the head frame, i.e. to batch
+	 *   several frames. Stops at frames that are not yet committed or
+	 *   have been dropped. The frame is claimed, so that it can not be
+	 *   reopened while it is being copied. Consumer only.
+	 */
+	bool peek_next(const uint8_t *&ptr, size_t &length);
+	/*! \brief Hand back the frame last returned by peek_next().
+	 *  \details For frames that turn out not to fit, i.e. into a batch.
+	 *   The frame is no longer claimed, so it may be reopened again, and
+	 *   the next peek_next() returns it once more. Consumer only.
+	 */
+	void unpeek_next();
+	/*! \brief Free the frame previously returned by peek_frame(). Consumer only.
+	 *  \details Calls the frame's completion handler, if it has one.
+	 * @param sent Passed on to the completion handler.
+	 */
+	void release_frame(bool sent = true);
+
+	/*! \brief Drop all committed frames.
+	 *  \details Frames are only marked, and are released with a completion
+	 *   of sent == false the next time peek_frame() walks over them. They
+	 *   no longer count as pending right away, see get_packet_count().
+	 *   Blocks still being written are skipped, frames behind them are
+	 *   dropped as well. Must not run concurrently with the consumer.
+	 *
+	 * @param keep_count Number of oldest frames not to drop, i.e. because they are being sent.
+	 * @return Number of frames dropped.
+	 */
+	int drop_frames(int keep_count);
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_TXQUEUE_H_ */
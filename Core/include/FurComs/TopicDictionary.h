@@ -0,0 +1,106 @@
+/*!
+ * \file TopicDictionary.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_TOPICDICTIONARY_H_
+#define FURCOMS_TOPICDICTIONARY_H_
+
+#include <FurComs/Subscriptions.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <atomic>
+
+#ifndef FURCOM_TOPIC_ID_NUM
+#define FURCOM_TOPIC_ID_NUM 32
+#endif
+#ifndef FURCOM_TOPIC_ID_POOL_SIZE
+#define FURCOM_TOPIC_ID_POOL_SIZE 512
+#endif
+
+//! Topic on which topic ID announcements are sent.
+#define FURCOM_TOPIC_ID_ANNOUNCE "FurComs/TopicID"
+
+namespace TEF {
+namespace FurComs {
+
+typedef uint32_t topic_id_t;
+
+//! Largest topic ID, IDs are encoded in at most three varint bytes.
+constexpr topic_id_t FURCOM_TOPIC_ID_MAX = (1 << 21) - 1;
+
+//! Entry of a compile-time topic ID table, see Topic_Dictionary::add_table()
+struct topic_id_def_t {
+	topic_id_t id;
+	const char *topic;
+};
+
+/*! \brief Mapping between topic strings and numeric topic IDs.
+ *  \details Packets with a known topic may be sent with a short numeric
+ *   ID instead of the full topic string, see FURCOM_MARKER_TOPIC_ID.
+ *   Both sides need to agree on the ID, either by sharing a table of
+ *   topic_id_def_t at compile time, or by the sender announcing the ID
+ *   on the FURCOM_TOPIC_ID_ANNOUNCE topic.
+ *
+ *   IDs are encoded as unsigned LEB128 varints, so IDs below 128 take a
+ *   single byte.
+ *
+ *   Entries can only be added, never changed or removed. New entries are
+ *   published atomically, lookups are thusly safe from any context while
+ *   the receiver thread adds announced IDs.
+ *
+ *   \attention Adding is not locked. Topic IDs must either be added
+ *    before LL_Handler::init() is called, or from within a receive handler.
+ */
+class Topic_Dictionary {
+private:
+	struct entry_t {
+		topic_hash_t hash;
+		topic_id_t id;
+		const char *topic;
+	};
+
+	std::array<entry_t, FURCOM_TOPIC_ID_NUM> entries;
+	std::atomic<size_t> entry_count;
+
+	//! Storage for copied topic strings of announced IDs.
+	std::array<char, FURCOM_TOPIC_ID_POOL_SIZE> pool;
+	size_t pool_used;
+
+public:
+	Topic_Dictionary();
+
+	/*! \brief Add a topic ID.
+	 *
+	 * @param id ID to assign, up to FURCOM_TOPIC_ID_MAX.
+	 * @param topic Topic string.
+	 * @param length Length of the topic string, excluding any terminating NUL.
+	 * @param copy Copy the topic into the dictionary's own pool. If false,
+	 *  the string must stay valid (i.e. a string literal) and NUL-terminated.
+	 * @return false if the ID or topic is already assigned differently, or the
+	 *  dictionary is full.
+	 */
+	bool add(topic_id_t id, const char *topic, size_t length, bool copy);
+	//! Add a compile-time table of topic IDs. Returns the number of added entries.
+	int add_table(const topic_id_def_t *table, size_t count);
+
+	//! Return the topic string of the given ID, or nullptr if unknown.
+	const char *find_topic(topic_id_t id) const;
+	//! Look up the ID of a topic. Returns false if the topic has none.
+	bool find_id(const char *topic, topic_id_t &id) const;
+
+	//! Encode an ID into up to three varint bytes. Returns the number of bytes written.
+	static size_t encode_id(topic_id_t id, uint8_t *out);
+	//! Decode a varint ID. Returns the number of bytes used, or 0 if invalid.
+	static size_t decode_id(const uint8_t *data, size_t length, topic_id_t &id);
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_TOPICDICTIONARY_H_ */
@@ -0,0 +1,117 @@
+/*!
+ * \file Transport.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_TRANSPORT_H_
+#define FURCOMS_TRANSPORT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Transport event flags.
+ *  \details Bitmask returned by Transport::poll_events(), describing
+ *   which hardware events are pending for the FurComs handler.
+ */
+enum transport_event_t : uint32_t {
+	TRANSPORT_RX       = 1 << 0, //!< A single byte was received and returned.
+	TRANSPORT_TX_READY = 1 << 1, //!< The transmit register can accept the next byte.
+	TRANSPORT_TX_DONE  = 1 << 2, //!< A DMA transfer has completely left the wire.
+	TRANSPORT_RX_SPAN  = 1 << 3, //!< New data may be available in the RX DMA buffer.
+	TRANSPORT_RX_TIMEOUT = 1 << 4, //!< The line has been idle for the time set with set_rx_timeout().
+};
+
+/*! \brief Byte transport used by the FurComs handler.
+ *  \details This interface hides the register access of the UART (and
+ *   optional DMA) hardware from the protocol logic. The handler only ever
+ *   talks to its transport, which allows replacing the hardware with a
+ *   fake USART/DMA model for testing on a Linux host.
+ *
+ *   A transport that does not support DMA transmission only needs to
+ *   implement the per-byte functions; the handler will then fall back to
+ *   loading one byte per TRANSPORT_TX_READY event.
+ *
+ *   Transports supporting DMA reception stream all received bytes into
+ *   a circular buffer, and report TRANSPORT_RX_SPAN on idle-line or
+ *   half/full transfer events. The handler switches between this and
+ *   per-byte reception using use_rx_dma(), as arbitration requires
+ *   a reaction on every single byte.
+ *
+ *   Transports with a receiver timeout (i.e. the STM32 RTOR) let the
+ *   handler detect an idle line in hardware, measured in bit-times,
+ *   instead of reading the platform tick on every received byte.
+ */
+class Transport {
+public:
+	virtual ~Transport() {}
+
+	/*! \brief Enable reception.
+	 *  \details Called once from LL_Handler::init(). Must enable the receive
+	 *   interrupt so that poll_events() reports TRANSPORT_RX.
+	 */
+	virtual void init() = 0;
+
+	/*! \brief Read and acknowledge pending events.
+	 *  \details Called from the handler's ISR. If a byte was received,
+	 *   TRANSPORT_RX is set and the byte is written to rx_byte.
+	 *   TRANSPORT_TX_READY must only be reported while the TX interrupt is
+	 *   enabled via set_tx_irq(), TRANSPORT_TX_DONE only once after each
+	 *   start_dma_tx().
+	 *
+	 * @param rx_byte Output for the received byte, if any.
+	 * @return Bitmask of transport_event_t flags.
+	 */
+	virtual uint32_t poll_events(uint8_t &rx_byte) = 0;
+
+	//! Load a single byte into the transmit register.
+	virtual void write_byte(uint8_t c) = 0;
+	//! Enable or disable the TRANSPORT_TX_READY event.
+	virtual void set_tx_irq(bool enabled) = 0;
+
+	//! Returns true if start_dma_tx() may be used.
+	virtual bool has_dma_tx() const { return false; }
+	/*! \brief Transmit a continuous block of data using DMA.
+	 *  \details The data must stay valid until TRANSPORT_TX_DONE has been
+	 *   reported, which happens once the last byte has completely been
+	 *   shifted out onto the bus.
+	 */
+	virtual void start_dma_tx(const uint8_t *data, size_t length) {
+		(void)data; (void)length;
+	}
+
+	//! Returns true if circular DMA reception is available.
+	virtual bool has_dma_rx() const { return false; }
+	/*! \brief Switch between DMA and per-byte reception.
+	 *  \details When enabled, received bytes go into the circular buffer
+	 *   and no TRANSPORT_RX events are reported. When disabled, the DMA
+	 *   buffer position stays where it is and TRANSPORT_RX is used again.
+	 */
+	virtual void use_rx_dma(bool enabled) { (void)enabled; }
+	/*! \brief Return the circular RX DMA buffer.
+	 * @param size Output for the size of the buffer, in bytes.
+	 */
+	virtual const uint8_t *rx_dma_buffer(size_t &size) const { size = 0; return nullptr; }
+	//! Return the index in rx_dma_buffer() that the DMA will write to next.
+	virtual size_t rx_dma_position() const { return 0; }
+
+	//! Returns true if set_rx_timeout() may be used.
+	virtual bool has_rx_timeout() const { return false; }
+	/*! \brief Configure and enable the receiver timeout.
+	 *  \details The timeout restarts at the end of every received
+	 *   character. Once the line has stayed idle for the given number of
+	 *   bit-times, TRANSPORT_RX_TIMEOUT is reported once, until the next
+	 *   character has been received.
+	 */
+	virtual void set_rx_timeout(uint32_t bit_times) { (void)bit_times; }
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_TRANSPORT_H_ */
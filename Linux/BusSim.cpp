@@ -0,0 +1,367 @@
+/*
+ * BusSim.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <string.h>
+
+namespace TEF {
+namespace FurComs {
+
+Sim_Transport::Sim_Transport(bool use_dma, bool use_rx_timeout, bool use_dma_rx) :
+		tdr_full(false), tdr(0),
+		shift_full(false), shift(0),
+		tx_irq(false),
+		rx_pending(false), rx_data(0),
+		dma_enabled(use_dma),
+		dma_ptr(nullptr), dma_length(0),
+		dma_busy(false), dma_done(false),
+		dma_rx_enabled(use_dma_rx), dma_rx_active(false),
+		dma_rx_buffer(), dma_rx_position(0), dma_rx_mark(false),
+		rx_line_busy(false), rx_idle_pending(false),
+		rx_timeout_enabled(use_rx_timeout), rx_timeout_chars(0),
+		rx_idle_chars(0), rx_timeout_pending(false) {
+}
+
+void Sim_Transport::init() {
+}
+
+uint32_t Sim_Transport::poll_events(uint8_t &rx_byte) {
+	uint32_t events = 0;
+
+	if(rx_pending) {
+		rx_byte = rx_data;
+		rx_pending = false;
+		events |= TRANSPORT_RX;
+	}
+
+	if(dma_rx_mark || rx_idle_pending) {
+		dma_rx_mark = false;
+		rx_idle_pending = false;
+		events |= TRANSPORT_RX_SPAN;
+	}
+
+	if(tx_irq && !tdr_full)
+		events |= TRANSPORT_TX_READY;
+
+	if(dma_done) {
+		dma_done = false;
+		events |= TRANSPORT_TX_DONE;
+	}
+
+	if(rx_timeout_pending) {
+		rx_timeout_pending = false;
+		events |= TRANSPORT_RX_TIMEOUT;
+	}
+
+	return events;
+}
+
+void Sim_Transport::write_byte(uint8_t c) {
+	tdr = c;
+	tdr_full = true;
+}
+
+void Sim_Transport::set_tx_irq(bool enabled) {
+	tx_irq = enabled;
+}
+
+bool Sim_Transport::has_dma_tx() const {
+	return dma_enabled;
+}
+
+void Sim_Transport::start_dma_tx(const uint8_t *data, size_t length) {
+	dma_ptr = data;
+	dma_length = length;
+	dma_busy = true;
+}
+
+bool Sim_Transport::has_dma_rx() const {
+	return dma_rx_enabled;
+}
+
+void Sim_Transport::use_rx_dma(bool enabled) {
+	dma_rx_active = enabled;
+}
+
+const uint8_t *Sim_Transport::rx_dma_buffer(size_t &size) const {
+	size = sizeof(dma_rx_buffer);
+	return dma_rx_buffer;
+}
+
+size_t Sim_Transport::rx_dma_position() const {
+	return dma_rx_position;
+}
+
+void Sim_Transport::receive(uint8_t c) {
+	rx_line_busy = true;
+
+	if(!dma_rx_active) {
+		rx_data = c;
+		rx_pending = true;
+		return;
+	}
+
+	dma_rx_buffer[dma_rx_position++] = c;
+	if(dma_rx_position == sizeof(dma_rx_buffer))
+		dma_rx_position = 0;
+
+	if(dma_rx_position == 0 || dma_rx_position == sizeof(dma_rx_buffer) / 2)
+		dma_rx_mark = true;
+}
+
+bool Sim_Transport::has_rx_timeout() const {
+	return rx_timeout_enabled;
+}
+
+void Sim_Transport::set_rx_timeout(uint32_t bit_times) {
+	rx_timeout_chars = (bit_times + 9) / 10;
+	if(rx_timeout_chars == 0)
+		rx_timeout_chars = 1;
+}
+
+Sim_Node_Base::Sim_Node_Base(Bus_Sim &bus, const handler_storage_t &storage,
+		uint16_t chip_id, bool use_dma, bool use_rx_timeout, bool use_dma_rx) :
+		Protocol_Core(sim_transport, storage),
+		sim_transport(use_dma, use_rx_timeout, use_dma_rx),
+		bus(bus),
+		thread_pending(false), rx_wake_step(0), rx_delay_steps(0),
+		tx_notified(false),
+		tx_wait_start(0), tx_wait_ticks(TX_WAIT_FOREVER),
+		tx_space_pending(false),
+		tx_poll_ticks(0),
+		rx_frames(0), rx_bytes(0), rx_dma_bytes(0) {
+
+	set_chip_id(chip_id);
+	set_baudrate(bus.get_baudrate());
+	subscribe("*", Sim_Node_Base::count_rx, this);
+
+	bus.nodes.push_back(this);
+
+	start();
+}
+
+void Sim_Node_Base::count_rx(void *context, const char *topic, const void *data, size_t length) {
+	auto node = reinterpret_cast<Sim_Node_Base*>(context);
+	(void)data;
+
+	node->rx_frames++;
+	node->rx_bytes += strlen(topic) + 1 + length;
+}
+
+void Sim_Node_Base::set_rx_counting(bool enabled) {
+	unsubscribe("*", Sim_Node_Base::count_rx, this);
+	if(enabled)
+		subscribe("*", Sim_Node_Base::count_rx, this);
+}
+
+void Sim_Node_Base::set_tx_polling(bool enabled, uint32_t period_ms) {
+	tx_poll_ticks = 0;
+	if(enabled) {
+		tx_poll_ticks = period_ms * bus.get_tick_rate() / 1000;
+		if(tx_poll_ticks == 0)
+			tx_poll_ticks = 1;
+	}
+
+	// Re-arm the wait, which may be TX_WAIT_FOREVER by now.
+	thread_pending = true;
+}
+
+void Sim_Node_Base::set_rx_delay(uint32_t steps) {
+	rx_delay_steps = steps;
+}
+
+uint32_t Sim_Node_Base::get_tick() {
+	return bus.get_tick();
+}
+uint32_t Sim_Node_Base::get_tick_rate() {
+	return bus.get_tick_rate();
+}
+// The simulation runs in bit-times, which is the finest timer there is.
+uint32_t Sim_Node_Base::get_timer_count() {
+	return bus.get_step() * 10;
+}
+uint32_t Sim_Node_Base::get_timer_rate() {
+	return bus.get_baudrate();
+}
+
+void Sim_Node_Base::notify_rx() {
+	if(!thread_pending)
+		rx_wake_step = bus.get_step() + rx_delay_steps;
+	thread_pending = true;
+}
+void Sim_Node_Base::notify_tx() {
+	if(tx_poll_ticks == 0)
+		tx_notified = true;
+}
+
+bool Sim_Node_Base::wait_tx_space(uint32_t timeout) {
+	// While this node blocks, the rest of the bus keeps running.
+	uint32_t start_tick = bus.get_tick();
+
+	tx_space_pending = false;
+	while(!tx_space_pending && (bus.get_tick() - start_tick) < timeout)
+		bus.step();
+
+	return tx_space_pending;
+}
+
+void Sim_Node_Base::notify_tx_space() {
+	tx_space_pending = true;
+}
+
+Bus_Sim::Bus_Sim(uint32_t baudrate, uint32_t tick_rate) :
+		nodes(),
+		baudrate(baudrate), tick_rate(tick_rate),
+		current_step(0),
+		stop_loss_interval(0), stop_count(0),
+		busy_steps(0), contended_steps(0), lost_stops(0) {
+}
+
+void Bus_Sim::set_stop_loss(uint32_t interval) {
+	stop_loss_interval = interval;
+	stop_count = 0;
+}
+
+void Bus_Sim::step() {
+	// TDR moves into the shift register, DMA refills TDR, TXE fires.
+	for(auto node : nodes) {
+		Sim_Transport &t = node->sim_transport;
+
+		if(!t.shift_full && t.tdr_full) {
+			t.shift = t.tdr;
+			t.shift_full = true;
+			t.tdr_full = false;
+		}
+
+		if(t.dma_busy && !t.tdr_full && t.dma_length) {
+			t.tdr = *(t.dma_ptr++);
+			t.tdr_full = true;
+			t.dma_length--;
+		}
+
+		node->handle_isr();
+	}
+
+	// Wired-AND of all transmitting nodes.
+	int transmitting = 0;
+	uint8_t bus_value = 0xFF;
+
+	for(auto node : nodes) {
+		Sim_Transport &t = node->sim_transport;
+		if(!t.shift_full)
+			continue;
+
+		bus_value &= t.shift;
+		t.shift_full = false;
+		transmitting++;
+	}
+
+	if(transmitting > 0)
+		busy_steps++;
+	if(transmitting > 1)
+		contended_steps++;
+
+	bool lost = false;
+	if(transmitting > 0 && bus_value == FURCOM_END && stop_loss_interval
+			&& ++stop_count % stop_loss_interval == 0) {
+		lost = true;
+		lost_stops++;
+	}
+
+	// Reception, and TC for finished DMA transfers.
+	for(auto node : nodes) {
+		Sim_Transport &t = node->sim_transport;
+
+		if(lost) {
+			// Noise still counts as line activity.
+			t.rx_line_busy = true;
+			t.rx_idle_chars = 0;
+		}
+		else if(transmitting > 0) {
+			if(t.dma_rx_active)
+				node->rx_dma_bytes++;
+			t.receive(bus_value);
+			t.rx_idle_chars = 0;
+		}
+		else {
+			if(t.rx_line_busy) {
+				t.rx_line_busy = false;
+				t.rx_idle_pending = t.dma_rx_enabled;
+			}
+			if(t.rx_timeout_chars && ++t.rx_idle_chars == t.rx_timeout_chars)
+				t.rx_timeout_pending = true;
+		}
+
+		if(t.dma_busy && !t.dma_length && !t.tdr_full && !t.shift_full) {
+			t.dma_busy = false;
+			t.dma_done = true;
+		}
+
+		node->handle_isr();
+	}
+
+	current_step++;
+
+	// Emulated receiver threads, see LL_Handler::_run_thread()
+	for(auto node : nodes) {
+		bool rx_due = node->thread_pending && current_step >= node->rx_wake_step;
+		bool wake = rx_due || node->tx_notified;
+		if(node->tx_wait_ticks != Sim_Node_Base::TX_WAIT_FOREVER
+				&& (get_tick() - node->tx_wait_start) >= node->tx_wait_ticks)
+			wake = true;
+
+		if(!wake)
+			continue;
+
+		node->tx_notified = false;
+		if(rx_due) {
+			node->thread_pending = false;
+			node->process_rx();
+		}
+
+		node->tx_wait_start = get_tick();
+		node->tx_wait_ticks = node->process_tx();
+		if(node->tx_poll_ticks)
+			node->tx_wait_ticks = node->tx_poll_ticks;
+	}
+}
+
+void Bus_Sim::run(uint64_t steps) {
+	while(steps--)
+		step();
+}
+
+bool Bus_Sim::run_until_idle(uint64_t max_steps) {
+	while(max_steps--) {
+		step();
+
+		bool idle = true;
+		for(auto node : nodes) {
+			if(node->get_tx_pending() > 0 || node->state != IDLE)
+				idle = false;
+		}
+
+		if(idle)
+			return true;
+	}
+
+	return false;
+}
+
+double Bus_Sim::get_goodput() const {
+	if(nodes.size() < 2 || current_step == 0)
+		return 0;
+
+	uint64_t total_bytes = 0;
+	for(auto node : nodes)
+		total_bytes += node->rx_bytes;
+
+	return double(total_bytes) / (nodes.size() - 1) / current_step;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
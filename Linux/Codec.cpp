@@ -0,0 +1,225 @@
+/*
+ * Codec.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/Codec.h>
+
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+static inline size_t find_special_scalar(const uint8_t *data, size_t length) {
+	size_t pos = 0;
+
+	// Word-at-a-time: a byte of (v - 0x01..) & ~v & 0x80.. is set for the
+	// lowest zero byte of v. Bytes above it may be flagged falsely, but
+	// the lowest flagged byte is always exact.
+	constexpr uint64_t ONES = 0x0101010101010101ULL;
+	constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+	constexpr uint64_t ESCAPES = ONES * FURCOM_ESCAPE;
+
+	for(; pos + 8 <= length; pos += 8) {
+		uint64_t v;
+		memcpy(&v, data + pos, 8);
+
+		uint64_t e = v ^ ESCAPES;
+		uint64_t mask = ((v - ONES) & ~v & HIGHS) | ((e - ONES) & ~e & HIGHS);
+		if(mask == 0)
+			continue;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		return pos + (__builtin_ctzll(mask) >> 3);
+#else
+		break;
+#endif
+	}
+
+	for(; pos < length; pos++) {
+		if(data[pos] == FURCOM_END || data[pos] == FURCOM_ESCAPE)
+			return pos;
+	}
+
+	return length;
+}
+
+namespace {
+
+//! Entry s of a slice table shifted by one more zero byte.
+constexpr uint32_t crc_slice_next(uint32_t s) {
+	return (s << 8) ^ crc_table_entry(s >> 24);
+}
+
+//! CRC of byte i followed by k zero bytes.
+constexpr uint32_t crc_slice(int k, uint32_t i) {
+	return (k == 0) ? crc_table_entry(i) : crc_slice_next(crc_slice(k - 1, i));
+}
+
+#define CRC_SLICE_4(k, i) crc_slice(k, i), crc_slice(k, i + 1), crc_slice(k, i + 2), crc_slice(k, i + 3)
+#define CRC_SLICE_16(k, i) CRC_SLICE_4(k, i), CRC_SLICE_4(k, i + 4), CRC_SLICE_4(k, i + 8), CRC_SLICE_4(k, i + 12)
+#define CRC_SLICE_64(k, i) CRC_SLICE_16(k, i), CRC_SLICE_16(k, i + 16), CRC_SLICE_16(k, i + 32), CRC_SLICE_16(k, i + 48)
+#define CRC_SLICE(k) { CRC_SLICE_64(k, 0), CRC_SLICE_64(k, 64), CRC_SLICE_64(k, 128), CRC_SLICE_64(k, 192) }
+
+//! Table k holds the CRC of a byte followed by k zero bytes.
+constexpr uint32_t crc_slices[8][256] = {
+	CRC_SLICE(0), CRC_SLICE(1), CRC_SLICE(2), CRC_SLICE(3),
+	CRC_SLICE(4), CRC_SLICE(5), CRC_SLICE(6), CRC_SLICE(7)
+};
+
+#undef CRC_SLICE
+#undef CRC_SLICE_64
+#undef CRC_SLICE_16
+#undef CRC_SLICE_4
+
+}
+
+size_t codec_find_special(const uint8_t *data, size_t length) {
+	size_t pos = 0;
+
+#if defined(__AVX2__)
+	const __m256i ends = _mm256_setzero_si256();
+	const __m256i escapes = _mm256_set1_epi8(char(FURCOM_ESCAPE));
+
+	for(; pos + 32 <= length; pos += 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+		__m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(v, ends), _mm256_cmpeq_epi8(v, escapes));
+
+		uint32_t mask = _mm256_movemask_epi8(hits);
+		if(mask)
+			return pos + __builtin_ctz(mask);
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128i ends_128 = _mm_setzero_si128();
+	const __m128i escapes_128 = _mm_set1_epi8(char(FURCOM_ESCAPE));
+
+	for(; pos + 16 <= length; pos += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+		__m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, ends_128), _mm_cmpeq_epi8(v, escapes_128));
+
+		uint32_t mask = _mm_movemask_epi8(hits);
+		if(mask)
+			return pos + __builtin_ctz(mask);
+	}
+#endif
+
+	return pos + find_special_scalar(data + pos, length - pos);
+}
+
+size_t codec_encode(const void *src, size_t length, uint8_t *dst) {
+	const uint8_t *pos = reinterpret_cast<const uint8_t*>(src);
+	const uint8_t *end = pos + length;
+	uint8_t *out = dst;
+
+	while(pos < end) {
+		// Stretches of special characters are escaped without scanning.
+		// The product is zero exactly for FURCOM_END and FURCOM_ESCAPE, testing
+		// it takes one well-predicted branch instead of two random ones.
+		while(uint32_t(*pos) * (*pos ^ FURCOM_ESCAPE) == 0) {
+			static_assert(FURCOM_ESC_ESC == FURCOM_ESC_END + 1, "Branch-free escaping needs adjacent escape codes!");
+
+			*(out++) = FURCOM_ESCAPE;
+			*(out++) = FURCOM_ESC_END + (*pos != FURCOM_END);
+
+			if(++pos == end)
+				return out - dst;
+		}
+
+		size_t run = codec_find_special(pos, end - pos);
+
+		memcpy(out, pos, run);
+		out += run;
+		pos += run;
+	}
+
+	return out - dst;
+}
+
+uint32_t codec_crc(uint32_t crc, const void *data, size_t length) {
+	const uint8_t *pos = reinterpret_cast<const uint8_t*>(data);
+	const auto &t = crc_slices;
+
+	for(; length >= 8; length -= 8) {
+		// The CRC is MSB first, so the first four bytes are XORed in big-endian.
+		uint32_t high = crc ^ ((uint32_t(pos[0]) << 24) | (uint32_t(pos[1]) << 16)
+				| (uint32_t(pos[2]) << 8) | pos[3]);
+
+		crc = t[7][high >> 24] ^ t[6][(high >> 16) & 0xFF]
+				^ t[5][(high >> 8) & 0xFF] ^ t[4][high & 0xFF]
+				^ t[3][pos[4]] ^ t[2][pos[5]] ^ t[1][pos[6]] ^ t[0][pos[7]];
+
+		pos += 8;
+	}
+
+	while(length--)
+		crc = (crc << 8) ^ t[0][(crc >> 24) ^ *(pos++)];
+
+	return crc;
+}
+
+size_t codec_decode(const uint8_t *src, size_t length,
+		char *&dst, const char *dst_end, bool &had_escape) {
+	const uint8_t *pos = src;
+	const uint8_t *end = src + length;
+
+	while(pos < end) {
+		if(dst >= dst_end) {
+			// Buffer full, discard everything up to the STOP.
+			const uint8_t *stop = reinterpret_cast<const uint8_t*>(memchr(pos, FURCOM_END, end - pos));
+			pos = (stop != nullptr) ? stop : end;
+			break;
+		}
+
+		if(had_escape) {
+			if(*pos == FURCOM_END)
+				break;
+
+			uint8_t c = *pos;
+			if(c == FURCOM_ESC_ESC || c == FURCOM_ESC_END)
+				*(dst++) = char((c == FURCOM_ESC_ESC) ? FURCOM_ESCAPE : FURCOM_END);
+
+			had_escape = false;
+			pos++;
+			continue;
+		}
+
+		if(*pos == FURCOM_END)
+			break;
+		if(*pos == FURCOM_ESCAPE) {
+			// Decode complete escape pairs right away.
+			if(pos + 1 < end && pos[1] != FURCOM_END) {
+				uint8_t c = pos[1];
+				if((c == FURCOM_ESC_ESC) | (c == FURCOM_ESC_END))
+					*(dst++) = char((c == FURCOM_ESC_ESC) ? FURCOM_ESCAPE : FURCOM_END);
+
+				pos += 2;
+				continue;
+			}
+
+			had_escape = true;
+			pos++;
+			continue;
+		}
+
+		size_t max_run = dst_end - dst;
+		if(size_t(end - pos) < max_run)
+			max_run = end - pos;
+
+		size_t run = codec_find_special(pos, max_run);
+
+		memcpy(dst, pos, run);
+		dst += run;
+		pos += run;
+	}
+
+	return pos - src;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
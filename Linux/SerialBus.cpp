@@ -0,0 +1,467 @@
+/*
+ * SerialBus.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/SerialBus.h>
+#include <FurComs/Codec.h>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+// termios2 is needed for arbitrary baudrates, and clashes with <termios.h>
+#include <asm/termbits.h>
+
+namespace TEF {
+namespace FurComs {
+
+Serial_Bus::Serial_Bus() :
+		fd(-1),
+		rx_read_buffer(), rx_frames(), rx_frame_count(0),
+		rx_synced(false), rx_header_count(0), rx_had_escape(false),
+		tx_mutex(), tx_buffer(),
+		poller(nullptr), poll_out(false),
+		tx_crc(false), tx_transfer_id(0) {
+
+	start_frame();
+}
+
+Serial_Bus::~Serial_Bus() {
+	close();
+}
+
+bool Serial_Bus::open(const char *device, uint32_t baudrate) {
+	close();
+
+	int new_fd = ::open(device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if(new_fd < 0)
+		return false;
+
+	struct termios2 tio;
+	if(ioctl(new_fd, TCGETS2, &tio) < 0) {
+		::close(new_fd);
+		return false;
+	}
+
+	tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY);
+	tio.c_oflag &= ~OPOST;
+	tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+	tio.c_cflag &= ~(CSIZE | PARENB | CSTOPB | CRTSCTS | CBAUD | (CBAUD << IBSHIFT));
+	tio.c_cflag |= CS8 | CREAD | CLOCAL | BOTHER | (BOTHER << IBSHIFT);
+	tio.c_ispeed = baudrate;
+	tio.c_ospeed = baudrate;
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+
+	if(ioctl(new_fd, TCSETS2, &tio) < 0) {
+		::close(new_fd);
+		return false;
+	}
+
+	// Drop whatever the driver collected before we were listening.
+	ioctl(new_fd, TCFLSH, TCIFLUSH);
+
+	fd = new_fd;
+
+	rx_frame_count = 0;
+	rx_synced = false;
+	start_frame();
+
+	std::lock_guard<std::mutex> lock(tx_mutex);
+	tx_buffer.clear();
+
+	return true;
+}
+
+void Serial_Bus::close() {
+	if(poller != nullptr)
+		poller->remove(*this);
+
+	if(fd >= 0)
+		::close(fd);
+	fd = -1;
+}
+
+void Serial_Bus::start_frame() {
+	rx_header_count = 0;
+	rx_had_escape = false;
+
+	rx_frames[rx_frame_count].data_end = rx_frames[rx_frame_count].raw_data.data();
+}
+
+void Serial_Bus::end_frame() {
+	rx_frame_t &frame = rx_frames[rx_frame_count];
+
+	if(frame.data_end != frame.raw_data.data()) {
+		if(++rx_frame_count == rx_frames.size())
+			dispatch_frames();
+	}
+
+	start_frame();
+}
+
+uint32_t Serial_Bus::compute_crc(const void *data, size_t length) {
+	return codec_crc(FURCOM_CRC_INIT, data, length);
+}
+
+void Serial_Bus::dispatch_frames() {
+	for(size_t i = 0; i < rx_frame_count; i++) {
+		rx_frame_t &frame = rx_frames[i];
+		dispatch_frame(frame.raw_data.data(), frame.data_end - frame.raw_data.data());
+	}
+
+	// Move the frame still being received to the front of the pool.
+	if(rx_frame_count > 0 && rx_frame_count < rx_frames.size()) {
+		rx_frame_t &current = rx_frames[rx_frame_count];
+		size_t partial = current.data_end - current.raw_data.data();
+
+		memcpy(rx_frames[0].raw_data.data(), current.raw_data.data(), partial);
+		rx_frames[0].data_end = rx_frames[0].raw_data.data() + partial;
+	}
+
+	rx_frame_count = 0;
+}
+
+void Serial_Bus::rx_span(const uint8_t *data, size_t length) {
+	while(length) {
+		if(!rx_synced) {
+			auto stop = reinterpret_cast<const uint8_t*>(memchr(data, FURCOM_END, length));
+			if(stop == nullptr)
+				return;
+
+			length -= stop + 1 - data;
+			data = stop + 1;
+
+			rx_synced = true;
+			start_frame();
+			continue;
+		}
+
+		// The arbitration header is sent raw, it never contains a FURCOM_END.
+		if(rx_header_count < sizeof(arbitration_package_t)) {
+			uint8_t c = *(data++);
+			length--;
+
+			if(c == FURCOM_END)
+				start_frame();
+			else
+				rx_header_count++;
+			continue;
+		}
+
+		if(*data == FURCOM_END) {
+			end_frame();
+
+			data++;
+			length--;
+			continue;
+		}
+
+		// Keep one byte free for the terminator added by dispatch_frame()
+		rx_frame_t &frame = rx_frames[rx_frame_count];
+		size_t consumed = codec_decode(data, length, frame.data_end,
+				frame.raw_data.data() + frame.raw_data.size() - 1, rx_had_escape);
+
+		data += consumed;
+		length -= consumed;
+	}
+}
+
+bool Serial_Bus::read_available() {
+	if(fd < 0)
+		return false;
+
+	bool alive = true;
+
+	while(true) {
+		ssize_t result = ::read(fd, rx_read_buffer.data(), rx_read_buffer.size());
+
+		if(result > 0) {
+			rx_span(rx_read_buffer.data(), result);
+
+			// A short read means the driver buffer is drained.
+			if(size_t(result) < rx_read_buffer.size())
+				break;
+			continue;
+		}
+
+		if(result < 0 && errno == EINTR)
+			continue;
+		if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+
+		alive = false;
+		break;
+	}
+
+	dispatch_frames();
+
+	return alive;
+}
+
+void Serial_Bus::encode_frame(const arbitration_package_t &header,
+		const uint8_t *prefix, size_t prefix_length,
+		const char *topic, size_t topic_length,
+		const uint8_t *payload_header, size_t header_length,
+		const void *data_ptr, size_t length, bool with_crc) {
+	size_t start = tx_buffer.size();
+	tx_buffer.resize(start + get_max_frame_size(prefix_length + topic_length + header_length + length, with_crc));
+	uint8_t *out = tx_buffer.data() + start;
+
+	*(out++) = FURCOM_END;
+	memcpy(out, &header, sizeof(header));
+	out += sizeof(header);
+
+	if(with_crc)
+		*(out++) = FURCOM_MARKER_CRC;
+
+	out += codec_encode(prefix, prefix_length, out);
+	out += codec_encode(topic, topic_length, out);
+	out += codec_encode(payload_header, header_length, out);
+	out += codec_encode(data_ptr, length, out);
+
+	if(with_crc) {
+		uint32_t crc = codec_crc(FURCOM_CRC_INIT, prefix, prefix_length);
+		crc = codec_crc(crc, topic, topic_length);
+		crc = codec_crc(crc, payload_header, header_length);
+
+		uint8_t trailer[FURCOM_CRC_LENGTH];
+		crc_write_trailer(codec_crc(crc, data_ptr, length), trailer);
+
+		out += codec_encode(trailer, FURCOM_CRC_LENGTH, out);
+	}
+
+	*(out++) = FURCOM_END;
+
+	tx_buffer.resize(out - tx_buffer.data());
+}
+
+size_t Serial_Bus::get_max_frame_size(size_t length, bool with_crc) {
+	return 1 + sizeof(arbitration_package_t) + 2*length + 1
+			+ (with_crc ? 1 + 2*FURCOM_CRC_LENGTH : 0);
+}
+
+bool Serial_Bus::send_message(const char *topic, const void *data_ptr, size_t length,
+		int8_t priority, uint16_t chip_id) {
+	size_t topic_length = strlen(topic) + 1;
+	bool with_crc = tx_crc;
+	size_t max_length = FURCOM_MAX_PACKET_LENGTH - (with_crc ? FURCOM_CRC_OVERHEAD : 0);
+
+	size_t fragment_overhead = FURCOM_FRAGMENT_HEADER_LENGTH + FURCOM_FRAGMENT_TOTAL_LENGTH;
+	if(topic_length + fragment_overhead >= max_length)
+		return false;
+
+	// Longer messages are sent in fragments, see FURCOM_MARKER_FRAGMENT.
+	bool fragmented = (topic_length + length > max_length);
+	size_t fragment_length = max_length - topic_length - fragment_overhead;
+	size_t fragment_count = (length + fragment_length - 1) / fragment_length;
+	if(fragmented && fragment_count > FURCOM_FRAGMENT_SEQUENCE_MAX + 1)
+		return false;
+
+	arbitration_package_t header;
+	header.priority = Protocol_Core::encode_priority(priority);
+	header.chip_id  = Protocol_Core::encode_chip_id(chip_id);
+	header._latency_a = 0xFF;
+	// No collision, see arbitration_package_t
+	header.collision_map[0] = 0xFE;
+	header.collision_map[1] = 0xFF;
+	header.collision_map[2] = 0xFF;
+	header._latency_b = 0xFF;
+
+	bool was_empty;
+	{
+		std::lock_guard<std::mutex> lock(tx_mutex);
+
+		size_t start = tx_buffer.size();
+		size_t max_size = fragmented
+				? fragment_count * get_max_frame_size(fragment_overhead + topic_length + fragment_length, with_crc)
+				: get_max_frame_size(topic_length + length, with_crc);
+		if(start + max_size > FURCOM_SERIAL_TX_MAX)
+			return false;
+
+		was_empty = (start == 0);
+
+		if(!fragmented)
+			encode_frame(header, nullptr, 0, topic, topic_length, nullptr, 0, data_ptr, length, with_crc);
+		else {
+			auto data = reinterpret_cast<const uint8_t*>(data_ptr);
+			tx_transfer_id++;
+
+			for(size_t i = 0; i < fragment_count; i++) {
+				size_t offset = i * fragment_length;
+				size_t chunk = (length - offset < fragment_length) ? (length - offset) : fragment_length;
+
+				bool last = (i + 1 == fragment_count);
+				uint16_t sequence = i | (last ? FURCOM_FRAGMENT_LAST : 0);
+				uint8_t fragment_header[FURCOM_FRAGMENT_HEADER_LENGTH] = {
+					FURCOM_MARKER_FRAGMENT, tx_transfer_id, uint8_t(sequence), uint8_t(sequence >> 8)
+				};
+				uint8_t total_field[FURCOM_FRAGMENT_TOTAL_LENGTH] = {
+					uint8_t(length), uint8_t(length >> 8), uint8_t(length >> 16), uint8_t(length >> 24)
+				};
+
+				encode_frame(header, fragment_header, sizeof(fragment_header),
+						topic, topic_length, total_field, last ? sizeof(total_field) : 0,
+						data + offset, chunk, with_crc);
+			}
+		}
+	}
+
+	if(poller == nullptr)
+		flush();
+	else if(was_empty)
+		poller->wake();
+
+	return true;
+}
+
+bool Serial_Bus::flush() {
+	std::lock_guard<std::mutex> lock(tx_mutex);
+
+	if(fd < 0)
+		return tx_buffer.empty();
+
+	size_t written = 0;
+	while(written < tx_buffer.size()) {
+		ssize_t result = ::write(fd, tx_buffer.data() + written, tx_buffer.size() - written);
+
+		if(result < 0) {
+			if(errno == EINTR)
+				continue;
+			break;
+		}
+
+		written += result;
+	}
+
+	tx_buffer.erase(tx_buffer.begin(), tx_buffer.begin() + written);
+
+	return tx_buffer.empty();
+}
+
+bool Serial_Bus::has_tx_pending() {
+	std::lock_guard<std::mutex> lock(tx_mutex);
+
+	return !tx_buffer.empty();
+}
+
+Serial_Poller::Serial_Poller() :
+		epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+		wake_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+		buses() {
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.ptr = nullptr;
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+}
+
+Serial_Poller::~Serial_Poller() {
+	for(auto bus : buses)
+		bus->poller = nullptr;
+
+	::close(wake_fd);
+	::close(epoll_fd);
+}
+
+void Serial_Poller::wake() {
+	uint64_t count = 1;
+	ssize_t result = ::write(wake_fd, &count, sizeof(count));
+	(void)result;
+}
+
+bool Serial_Poller::add(Serial_Bus &bus) {
+	if(!bus.is_open() || bus.poller != nullptr)
+		return false;
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.ptr = &bus;
+
+	if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, bus.fd, &event) < 0)
+		return false;
+
+	bus.poller = this;
+	bus.poll_out = false;
+	buses.push_back(&bus);
+
+	handle_output(bus);
+
+	return true;
+}
+
+void Serial_Poller::remove(Serial_Bus &bus) {
+	if(bus.poller != this)
+		return;
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, bus.fd, nullptr);
+
+	for(auto it = buses.begin(); it != buses.end(); it++) {
+		if(*it == &bus) {
+			buses.erase(it);
+			break;
+		}
+	}
+
+	bus.poller = nullptr;
+}
+
+void Serial_Poller::set_poll_out(Serial_Bus &bus, bool enabled) {
+	if(bus.poll_out == enabled)
+		return;
+
+	epoll_event event = {};
+	event.events = enabled ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+	event.data.ptr = &bus;
+
+	if(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, bus.fd, &event) == 0)
+		bus.poll_out = enabled;
+}
+
+void Serial_Poller::handle_output(Serial_Bus &bus) {
+	set_poll_out(bus, !bus.flush());
+}
+
+int Serial_Poller::poll(int timeout_ms) {
+	std::array<epoll_event, 16> events;
+
+	int count = epoll_wait(epoll_fd, events.data(), events.size(), timeout_ms);
+	if(count < 0)
+		return (errno == EINTR) ? 0 : -1;
+
+	for(int i = 0; i < count; i++) {
+		auto bus = reinterpret_cast<Serial_Bus*>(events[i].data.ptr);
+
+		if(bus == nullptr) {
+			uint64_t wakeups;
+			ssize_t result = ::read(wake_fd, &wakeups, sizeof(wakeups));
+			(void)result;
+
+			for(size_t j = 0; j < buses.size(); j++)
+				handle_output(*buses[j]);
+			continue;
+		}
+
+		bool alive = true;
+		if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+			alive = bus->read_available();
+
+		if(alive && (events[i].events & EPOLLOUT))
+			handle_output(*bus);
+
+		if(!alive)
+			bus->close();
+	}
+
+	return count;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
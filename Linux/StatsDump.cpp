@@ -0,0 +1,114 @@
+/*
+ * StatsDump.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/StatsDump.h>
+
+#include <inttypes.h>
+
+namespace TEF {
+namespace FurComs {
+
+static const char *const state_names[HANDLER_STATE_NUM] = {
+		"IDLE",
+		"PARTICIPATING_ARBITRATION",
+		"WAITING_ARBITRATION",
+		"RECEIVING",
+		"SENDING",
+		"SENDING_COMPLETE",
+};
+
+static const char *const priority_names[PRIO_CLASS_NUM] = {
+		"urgent", "high", "normal", "bulk",
+};
+
+const char *get_state_name(int state) {
+	if(state < 0 || state >= HANDLER_STATE_NUM)
+		return "?";
+
+	return state_names[state];
+}
+
+static double percent(uint64_t part, uint64_t total) {
+	return (total == 0) ? 0 : 100.0 * part / total;
+}
+
+void dump_stats(FILE *out, const bus_stats_t &stats) {
+	fprintf(out, "frames sent %" PRIu32 " (%" PRIu32 " packets), received %" PRIu32 "\n",
+			stats.frames_sent, stats.packets_sent, stats.frames_received);
+
+	fprintf(out, "arbitration: %" PRIu32 " attempts, %" PRIu32 " lost (%.1f%%)\n",
+			stats.arbitration_attempts, stats.arbitration_losses,
+			percent(stats.arbitration_losses, stats.arbitration_attempts));
+	for(int i = 24; i >= 0; i--) {
+		if(stats.arbitration_loss_positions[i] == 0)
+			continue;
+
+		fprintf(out, "  lost at bit %2d: %" PRIu32 "\n", i, stats.arbitration_loss_positions[i]);
+	}
+
+	fprintf(out, "rx: %" PRIu32 " overruns, %" PRIu32 " truncated, %" PRIu32 " CRC errors, %" PRIu32 " filtered, escape expansion %.4f\n",
+			stats.rx_overruns, stats.rx_truncated, stats.rx_crc_errors, stats.rx_filtered,
+			(stats.rx_decoded_bytes == 0) ? 1.0 : double(stats.rx_encoded_bytes) / stats.rx_decoded_bytes);
+
+	fprintf(out, "tx queue high water:");
+	for(int i = 0; i < PRIO_CLASS_NUM; i++)
+		fprintf(out, " %s %" PRIu32, priority_names[i], stats.tx_queue_high_water[i]);
+	fprintf(out, " of %" PRIu32 " bytes\n", stats.tx_queue_size);
+
+	uint64_t total_time = 0;
+	for(auto time : stats.state_time)
+		total_time += time;
+
+	fprintf(out, "state time:\n");
+	for(int i = 0; i < HANDLER_STATE_NUM; i++) {
+		double ms = (stats.clock_rate == 0) ? 0 : 1000.0 * stats.state_time[i] / stats.clock_rate;
+
+		fprintf(out, "  %-25s %12.3f ms (%5.1f%%)\n", state_names[i],
+				ms, percent(stats.state_time[i], total_time));
+	}
+}
+
+size_t dump_trace(FILE *out, const Trace_Ring &ring, uint32_t &cursor, uint32_t clock_rate) {
+	trace_entry_t entries[16];
+	size_t printed = 0;
+
+	bool has_previous = false;
+	uint32_t previous = 0;
+
+	while(true) {
+		uint32_t lost = 0;
+		size_t count = ring.read(cursor, entries, 16, &lost);
+
+		if(lost) {
+			fprintf(out, "  ... %" PRIu32 " entries lost\n", lost);
+			has_previous = false;
+		}
+		if(count == 0)
+			break;
+
+		for(size_t i = 0; i < count; i++) {
+			auto &entry = entries[i];
+			double scale = (clock_rate == 0) ? 0 : 1000000.0 / clock_rate;
+
+			fprintf(out, "%14.1f us %+10.1f us  %s -> %s", entry.timestamp * scale,
+					has_previous ? uint32_t(entry.timestamp - previous) * scale : 0.0,
+					get_state_name(entry.from_state), get_state_name(entry.to_state));
+			if(entry.detail)
+				fprintf(out, " (bit %d)", entry.detail);
+			fprintf(out, "\n");
+
+			has_previous = true;
+			previous = entry.timestamp;
+		}
+
+		printed += count;
+	}
+
+	return printed;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,299 @@
+/*!
+ * \file BusSim.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_BUSSIM_H_
+#define FURCOMS_BUSSIM_H_
+
+#include <FurComs/ProtocolCore.h>
+
+#include <stdint.h>
+#include <vector>
+
+#ifndef FURCOM_SIM_RX_DMA_SIZE
+//! Size of the circular RX DMA buffer of a Sim_Transport, in bytes.
+#define FURCOM_SIM_RX_DMA_SIZE 64
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+class Bus_Sim;
+
+/*! \brief Simulated UART of a Sim_Node.
+ *  \details Models a USART with a one-byte transmit holding register (TDR)
+ *   in front of the shift register, a TXE interrupt and, optionally, a DMA
+ *   channel feeding TDR. One shift register byte is put onto the bus per
+ *   simulation step.
+ *
+ *   DMA reception, if enabled, writes received bytes into a circular
+ *   buffer of FURCOM_SIM_RX_DMA_SIZE bytes. TRANSPORT_RX_SPAN is reported
+ *   on the half and full transfer marks, and on idle-line, one character
+ *   time after the last reception, like the STM32 IDLE flag.
+ *
+ *   The receiver timeout is modelled in whole character times of 10 bits,
+ *   rounding the configured bit-times up.
+ */
+class Sim_Transport : public Transport {
+private:
+	friend Bus_Sim;
+
+	bool tdr_full;
+	uint8_t tdr;
+	bool shift_full;
+	uint8_t shift;
+
+	bool tx_irq;
+
+	bool rx_pending;
+	uint8_t rx_data;
+
+	bool dma_enabled;
+	const uint8_t *dma_ptr;
+	size_t dma_length;
+	bool dma_busy;
+	bool dma_done;
+
+	bool dma_rx_enabled;
+	//! Set by use_rx_dma(), received bytes go into dma_rx_buffer.
+	bool dma_rx_active;
+	uint8_t dma_rx_buffer[FURCOM_SIM_RX_DMA_SIZE];
+	size_t dma_rx_position;
+	//! Half or full transfer mark passed.
+	bool dma_rx_mark;
+	//! Set on reception, cleared by the first idle character time.
+	bool rx_line_busy;
+	bool rx_idle_pending;
+
+	bool rx_timeout_enabled;
+	//! Receiver timeout in character times, 0 while disarmed.
+	uint32_t rx_timeout_chars;
+	//! Character times since the last reception.
+	uint32_t rx_idle_chars;
+	bool rx_timeout_pending;
+
+	//! Put a byte from the bus into RDR or the RX DMA buffer.
+	void receive(uint8_t c);
+
+public:
+	Sim_Transport(bool use_dma = false, bool use_rx_timeout = false, bool use_dma_rx = false);
+
+	void init();
+	uint32_t poll_events(uint8_t &rx_byte);
+
+	void write_byte(uint8_t c);
+	void set_tx_irq(bool enabled);
+
+	bool has_dma_tx() const;
+	void start_dma_tx(const uint8_t *data, size_t length);
+
+	bool has_dma_rx() const;
+	void use_rx_dma(bool enabled);
+	const uint8_t *rx_dma_buffer(size_t &size) const;
+	size_t rx_dma_position() const;
+
+	bool has_rx_timeout() const;
+	void set_rx_timeout(uint32_t bit_times);
+};
+
+/*! \brief Simulated FurComs node, without buffers.
+ *  \details Protocol_Core running on a Sim_Transport, with the platform
+ *   clock taken from the Bus_Sim. The receiver thread is emulated like the
+ *   LL_Handler thread: it runs right after the simulation step in which
+ *   notify_rx() or notify_tx() was called, and once the delay returned by
+ *   the last process_tx() elapsed.
+ *
+ *   Received frames are counted, other than that the node behaves like
+ *   any other Protocol_Core, i.e. it may subscribe() and send packets.
+ *   Counting subscribes to "*", see set_rx_counting().
+ *
+ *   Nodes are usually created as Sim_Node, which brings its own buffers.
+ */
+class Sim_Node_Base : public Protocol_Core {
+private:
+	friend Bus_Sim;
+
+	Sim_Transport sim_transport;
+	Bus_Sim &bus;
+
+	bool thread_pending;
+	//! Step from which on the thread may run for thread_pending, see set_rx_delay().
+	uint64_t rx_wake_step;
+	uint32_t rx_delay_steps;
+	bool tx_notified;
+	//! Tick of the last process_tx() call, and the delay it returned.
+	uint32_t tx_wait_start;
+	uint32_t tx_wait_ticks;
+
+	bool tx_space_pending;
+
+	//! Polling period of set_tx_polling(), in ticks, 0 while event-driven.
+	uint32_t tx_poll_ticks;
+
+	static void count_rx(void *context, const char *topic, const void *data, size_t length);
+
+protected:
+	uint32_t get_tick();
+	uint32_t get_tick_rate();
+	uint32_t get_timer_count();
+	uint32_t get_timer_rate();
+	void notify_rx();
+	void notify_tx();
+
+	/*! \brief Block in send_packet_wait().
+	 *  \details Runs the bus simulation until a frame of this node was
+	 *   released, or the timeout elapsed. Must thusly not be used from
+	 *   within the simulation, i.e. from receive handlers.
+	 */
+	bool wait_tx_space(uint32_t timeout);
+	void notify_tx_space();
+
+public:
+	//! Number of frames this node has received and dispatched.
+	uint32_t rx_frames;
+	//! Number of topic, separator and payload bytes this node has received.
+	//! Packets received with a topic ID count with their full topic.
+	uint64_t rx_bytes;
+	//! Number of bus bytes this node received through its RX DMA buffer.
+	uint64_t rx_dma_bytes;
+
+	/*! \brief Create a new node and attach it to the bus.
+	 * @param bus Bus to attach to, must outlive the node.
+	 * @param storage Buffers of the node, see Protocol_Core::Protocol_Core().
+	 * @param chip_id Chip ID of this node.
+	 * @param use_dma Use the DMA transmit path instead of per-byte TXE.
+	 * @param use_rx_timeout Detect bus idle with the receiver timeout.
+	 * @param use_dma_rx Receive through circular DMA while idle, see Sim_Transport.
+	 */
+	Sim_Node_Base(Bus_Sim &bus, const handler_storage_t &storage,
+			uint16_t chip_id, bool use_dma = false, bool use_rx_timeout = false,
+			bool use_dma_rx = false);
+
+	/*! \brief Count received packets into rx_frames and rx_bytes.
+	 *  \details Enabled by default. The "*" subscription used for counting
+	 *   matches every topic, so it must be disabled for set_rx_filter() to
+	 *   drop anything.
+	 */
+	void set_rx_counting(bool enabled);
+
+	/*! \brief Emulate the polling receiver thread of older LL_Handler versions.
+	 *  \details That thread woke up on received frames and otherwise every
+	 *   100 ms, from osThreadFlagsWait(0b1, 0, 100), and never on new
+	 *   packets. While enabled, notify_tx() is ignored and the delay returned
+	 *   by process_tx() is replaced by period_ms, so a packet that finds the
+	 *   bus busy waits for the next frame or poll. Meant as a baseline for
+	 *   latency measurements.
+	 */
+	void set_tx_polling(bool enabled, uint32_t period_ms = 100);
+
+	/*! \brief Delay the emulated receiver thread after notify_rx().
+	 *  \details The thread then runs the given number of character times
+	 *   after a frame was received, as if higher priority work kept it from
+	 *   running. Frames received meanwhile queue up in the RX buffers.
+	 */
+	void set_rx_delay(uint32_t steps);
+};
+
+/*! \brief Simulated FurComs node with statically sized buffers.
+ *  \details See Sim_Node_Base, and Handler_Storage for the parameters.
+ *   Nodes of different buffer sizes may share a bus, i.e. to check that a
+ *   trimmed-down configuration still keeps up.
+ */
+template<int RX_BUFFER_NUM = FURCOM_RX_BUFFER_NUM,
+		size_t FRAME_LENGTH = FURCOM_MAX_PACKET_LENGTH,
+		uint32_t TX_QUEUE_SIZE = FURCOM_TX_QUEUE_SIZE>
+class Sim_Node : private Handler_Storage<RX_BUFFER_NUM, FRAME_LENGTH, TX_QUEUE_SIZE>,
+		public Sim_Node_Base {
+public:
+	//! See Sim_Node_Base::Sim_Node_Base().
+	Sim_Node(Bus_Sim &bus, uint16_t chip_id, bool use_dma = false, bool use_rx_timeout = false,
+			bool use_dma_rx = false) :
+			Sim_Node_Base(bus, this->get_storage(), chip_id, use_dma, use_rx_timeout, use_dma_rx) {
+	}
+};
+
+/*! \brief Deterministic FurComs bus simulator.
+ *  \details Simulates any number of Sim_Node instances on a shared,
+ *   wired-AND bus line (i.e. a CAN transceiver, where 0 bits are dominant).
+ *
+ *   The simulation is stepped in units of one UART character time.
+ *   During each step:
+ *   - Every node moves its TDR into the shift register, triggering TXE,
+ *     which lets the handler load the next byte.
+ *   - The bus value is the AND of all shift registers that hold data.
+ *     If no node is transmitting, the bus is idle and nothing is received.
+ *   - Every node receives the bus value, including the transmitting ones,
+ *     either into its RX register or its RX DMA buffer.
+ *   - Emulated receiver threads run.
+ *
+ *   As the simulation contains no randomness, arbitration races such as
+ *   equal chip IDs or simultaneous STARTs can be reproduced exactly.
+ */
+class Bus_Sim {
+private:
+	friend Sim_Node_Base;
+
+	std::vector<Sim_Node_Base*> nodes;
+
+	uint32_t baudrate;
+	uint32_t tick_rate;
+	uint64_t current_step;
+
+	//! See set_stop_loss(), 0 while disabled.
+	uint32_t stop_loss_interval;
+	uint32_t stop_count;
+
+public:
+	//! Number of steps during which at least one node was transmitting.
+	uint64_t busy_steps;
+	//! Number of steps during which more than one node was transmitting.
+	uint64_t contended_steps;
+	//! Number of STOP characters lost through set_stop_loss().
+	uint64_t lost_stops;
+
+	/*! \brief Construct a new, empty bus.
+	 * @param baudrate Baudrate of the simulated bus, used to convert
+	 *  character times into platform ticks (10 bits per character).
+	 * @param tick_rate Platform ticks per second of all nodes.
+	 */
+	Bus_Sim(uint32_t baudrate = 250000, uint32_t tick_rate = 1000);
+
+	/*! \brief Lose every n-th STOP character on the bus, as from line noise.
+	 *  \details No node receives the lost character, so receivers only
+	 *   leave the cut off frame through the idle reset. 0 disables the loss.
+	 */
+	void set_stop_loss(uint32_t interval);
+
+	//! Run a single character time.
+	void step();
+	//! Run the given number of character times.
+	void run(uint64_t steps);
+	//! Run until no node has data pending, or max_steps have passed.
+	//! \return true if the bus went idle.
+	bool run_until_idle(uint64_t max_steps);
+
+	//! Return the current step count.
+	uint64_t get_step() const { return current_step; }
+	//! Return the current platform tick.
+	uint32_t get_tick() const { return current_step * 10 * tick_rate / baudrate; }
+	//! Return the number of platform ticks per second.
+	uint32_t get_tick_rate() const { return tick_rate; }
+	//! Return the baudrate of the bus.
+	uint32_t get_baudrate() const { return baudrate; }
+
+	/*! \brief Return the bus goodput.
+	 *  \details Topic and payload bytes received per simulated character
+	 *   time. As every frame is received by all nodes but its sender,
+	 *   the received byte count is averaged over all but one node.
+	 */
+	double get_goodput() const;
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_BUSSIM_H_ */
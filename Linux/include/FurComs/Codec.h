@@ -0,0 +1,68 @@
+/*!
+ * \file Codec.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_CODEC_H_
+#define FURCOMS_CODEC_H_
+
+#include <FurComs/CRC.h>
+#include <FurComs/SLIP.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Find the first FURCOM_END or FURCOM_ESCAPE.
+ *  \details Scans 32 bytes per step with AVX2, 16 with SSE2, or 8 with
+ *   a portable word-at-a-time test, depending on what the compiler
+ *   targets (i.e. -mavx2). Clean runs in encoded or raw data are thusly
+ *   skipped at memory speed instead of byte by byte.
+ *
+ * @return Index of the first special character, or length if there is none.
+ */
+size_t codec_find_special(const uint8_t *data, size_t length);
+
+/*! \brief SLIP-encode data.
+ *  \details Same encoding as TX_Queue::add_data(): FURCOM_END and
+ *   FURCOM_ESCAPE are escaped, everything else is copied, in bulk.
+ *   No FURCOM_END is appended.
+ *
+ * @param src Raw data.
+ * @param length Number of raw bytes.
+ * @param dst Output buffer, must have room for 2*length bytes.
+ * @return Number of bytes written.
+ */
+size_t codec_encode(const void *src, size_t length, uint8_t *dst);
+
+/*! \brief Decode a span of SLIP-encoded bytes.
+ *  \details Drop-in replacement for slip_decode_span() with identical
+ *   semantics, including handling of invalid escapes, full output
+ *   buffers and escape state carried over between calls, but using
+ *   codec_find_special() to locate special characters.
+ *
+ * @return Number of consumed input bytes. Decoding stops before the
+ *  first FURCOM_END, which is not consumed.
+ */
+size_t codec_decode(const uint8_t *src, size_t length,
+		char *&dst, const char *dst_end, bool &had_escape);
+
+/*! \brief Continue the frame CRC over more data.
+ *  \details Drop-in replacement for crc_update(), computing the same
+ *   CRC-32/MPEG-2 with slicing-by-8: eight 1kB tables let one step fold
+ *   in eight bytes with independent lookups, instead of one byte per
+ *   dependent lookup. Tables are built at compile time.
+ *
+ * @param crc FURCOM_CRC_INIT, or the result of the previous call.
+ */
+uint32_t codec_crc(uint32_t crc, const void *data, size_t length);
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_CODEC_H_ */
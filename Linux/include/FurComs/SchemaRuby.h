@@ -0,0 +1,54 @@
+/*!
+ * \file SchemaRuby.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_SCHEMARUBY_H_
+#define FURCOMS_SCHEMARUBY_H_
+
+#include <FurComs/Schema.h>
+
+#include <stdio.h>
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief Print the Ruby decoder of a schema.
+ *  \details Prints a constant definition of a TEF::FurComs::Schema,
+ *   from the Ruby gem, with the topic and fields of the C++ schema, i.e.
+ *
+ *       BatteryStatus = TEF::FurComs::Schema.new('power/battery',
+ *           [:voltage_mv, 'S<', :int],
+ *           ...
+ *       )
+ *
+ *   A host tool that includes the schema headers prints all of them into
+ *   a Ruby file, so that both sides are generated from one declaration.
+ *
+ * @tparam S Schema to print, see Schema_View.
+ * @param name Name of the Ruby constant.
+ * @param indent Prefix of every line, i.e. tabs for a surrounding module.
+ */
+template<typename S>
+void schema_write_ruby(FILE *out, const char *name, const char *indent = "") {
+	fprintf(out, "%s%s = TEF::FurComs::Schema.new('%s',\n", indent, name, S::TOPIC);
+
+	S::fields::for_each([&](auto field) {
+		typedef typename decltype(field)::type type;
+
+		fprintf(out, "%s\t[:%s, '%s", indent, field.field_name(), type::ruby_pack());
+		if(type::RUBY_COUNT != 0)
+			fprintf(out, "%zu", size_t(type::RUBY_COUNT));
+		fprintf(out, "', :%s],\n", type::ruby_kind());
+	});
+
+	fprintf(out, "%s)\n", indent);
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_SCHEMARUBY_H_ */
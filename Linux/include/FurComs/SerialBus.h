@@ -0,0 +1,225 @@
+/*!
+ * \file SerialBus.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_SERIALBUS_H_
+#define FURCOMS_SERIALBUS_H_
+
+#include <FurComs/PacketDispatcher.h>
+#include <FurComs/ProtocolCore.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#ifndef FURCOM_SERIAL_READ_SIZE
+//! Bytes requested per read() from the serial port.
+#define FURCOM_SERIAL_READ_SIZE 16384
+#endif
+#ifndef FURCOM_SERIAL_FRAME_NUM
+//! Number of decoded frames collected before they are dispatched.
+#define FURCOM_SERIAL_FRAME_NUM 32
+#endif
+#ifndef FURCOM_SERIAL_TX_MAX
+//! Maximum number of encoded bytes waiting to be written.
+#define FURCOM_SERIAL_TX_MAX 65536
+#endif
+
+namespace TEF {
+namespace FurComs {
+
+class Serial_Poller;
+
+/*! \brief FurComs connection through a USB-to-UART adapter.
+ *  \details Native counterpart of the Ruby Serial class, meant for gateway
+ *   hosts. Frames use the same START, arbitration_package_t header,
+ *   modified SLIP body and STOP as the LL_Handler, and are dispatched by
+ *   the same Packet_Dispatcher, i.e. batch frames and topic IDs are
+ *   understood and subscribe() works as on the bus nodes.
+ *
+ *   The port is opened non-blocking. Every read_available() drains the
+ *   port with large reads, decodes the data in bulk using
+ *   codec_decode() into a fixed pool of frame buffers and only then hands
+ *   all collected frames to the handlers, so a busy bus costs one wakeup per
+ *   driver buffer instead of one per byte or frame.
+ *
+ *   Sent messages are encoded straight into one output buffer and written
+ *   with as few write() calls as possible, see send_message().
+ *
+ *   Frames with a CRC are checked with codec_crc() while dispatching,
+ *   those that do not match are dropped and counted, see get_crc_errors().
+ *
+ *   Receiving, and thusly all handlers, run on the thread calling
+ *   read_available(), normally the one running Serial_Poller::poll().
+ *
+ *  \note A plain UART adapter cannot take part in arbitration, so sent
+ *   frames may collide on a busy bus. Prefer an STM32 bridge there.
+ */
+class Serial_Bus : public Packet_Dispatcher {
+private:
+	friend Serial_Poller;
+
+	int fd;
+
+	//! One decoded frame, filled by rx_span().
+	struct rx_frame_t {
+		//! Longest frame, and the terminator added by dispatch_frame().
+		std::array<char, FURCOM_MAX_PACKET_LENGTH + 1> raw_data;
+		char *data_end;
+	};
+
+	std::array<uint8_t, FURCOM_SERIAL_READ_SIZE> rx_read_buffer;
+	std::array<rx_frame_t, FURCOM_SERIAL_FRAME_NUM> rx_frames;
+	//! Number of completed frames in rx_frames, the next one is being filled.
+	size_t rx_frame_count;
+
+	//! Skip data until the first FURCOM_END after opening the port.
+	bool rx_synced;
+	//! Arbitration header bytes of the current frame seen so far.
+	size_t rx_header_count;
+	bool rx_had_escape;
+
+	std::mutex tx_mutex;
+	//! Encoded frames waiting to be written, guarded by tx_mutex.
+	std::vector<uint8_t> tx_buffer;
+
+	Serial_Poller *poller;
+	//! EPOLLOUT is currently requested by the poller.
+	bool poll_out;
+
+	//! Protect sent messages with a CRC, see set_crc()
+	std::atomic<bool> tx_crc;
+	//! Transfer ID of the last fragmented message, guarded by tx_mutex.
+	uint8_t tx_transfer_id;
+
+	void rx_span(const uint8_t *data, size_t length);
+	void start_frame();
+	void end_frame();
+	void dispatch_frames();
+
+	static size_t get_max_frame_size(size_t length, bool with_crc);
+	//! Append one frame to tx_buffer, tx_mutex must be held.
+	void encode_frame(const arbitration_package_t &header,
+			const uint8_t *prefix, size_t prefix_length,
+			const char *topic, size_t topic_length,
+			const uint8_t *payload_header, size_t header_length,
+			const void *data_ptr, size_t length, bool with_crc);
+
+protected:
+	uint32_t compute_crc(const void *data, size_t length);
+
+public:
+	Serial_Bus();
+	~Serial_Bus();
+
+	Serial_Bus(const Serial_Bus&) = delete;
+	Serial_Bus &operator=(const Serial_Bus&) = delete;
+
+	/*! \brief Open and configure a serial port.
+	 *  \details Sets raw 8N1 mode and the given baudrate, which need
+	 *   not be one of the standard rates.
+	 * @return false if the port could not be opened or configured, see errno.
+	 */
+	bool open(const char *device, uint32_t baudrate = 115200);
+	//! Close the port, removing it from its Serial_Poller.
+	void close();
+
+	bool is_open() const { return fd >= 0; }
+	int get_fd() const { return fd; }
+
+	/*! \brief Read and dispatch all data that is available.
+	 *  \details Never blocks. Handlers are called from within this function.
+	 * @return false if the port was closed on the other end or failed.
+	 */
+	bool read_available();
+
+	/*! \brief Queue a message for sending.
+	 *  \details The frame is encoded into the output buffer. If the bus is
+	 *   registered with a Serial_Poller, the poller is woken up and writes
+	 *   everything queued until then at once; otherwise flush() is called
+	 *   right away. May be called from any thread.
+	 *
+	 *   Messages too long for one frame are split into FURCOM_MARKER_FRAGMENT
+	 *   frames, which are queued together. Receivers need a Fragment_Receiver
+	 *   for the topic to take them.
+	 *
+	 * @param topic Topic to send this message under. Must be a valid string, null-terminated.
+	 * @param data_ptr Pointer to the binary payload.
+	 * @param length Length of the payload, in bytes.
+	 * @param priority Arbitration priority, -60 to 60.
+	 * @param chip_id Chip ID put into the arbitration header.
+	 * @return false if the topic is too long, or the output buffer is full.
+	 */
+	bool send_message(const char *topic, const void *data_ptr, size_t length,
+			int8_t priority = 0, uint16_t chip_id = 0);
+
+	/*! \brief Protect sent messages with a CRC.
+	 *  \details Same format as Protocol_Core::set_crc(), the maximum
+	 *   message length shrinks by FURCOM_CRC_OVERHEAD bytes.
+	 */
+	void set_crc(bool enabled) { tx_crc = enabled; }
+
+	/*! \brief Write as much queued output as the port accepts.
+	 *  \details Never blocks.
+	 * @return false if output is still left in the buffer.
+	 */
+	bool flush();
+	//! Return true if queued output is waiting to be written.
+	bool has_tx_pending();
+};
+
+/*! \brief Event loop for any number of Serial_Bus instances.
+ *  \details Waits on all registered ports with a single epoll instance,
+ *   so one thread can serve every adapter of a gateway while sleeping
+ *   whenever the buses are quiet. Write interest is only requested while a
+ *   bus has output left that the port did not take at once.
+ *
+ *   Buses whose port fails or is closed on the other end are removed
+ *   and closed.
+ */
+class Serial_Poller {
+private:
+	friend Serial_Bus;
+
+	int epoll_fd;
+	//! eventfd used by Serial_Bus::send_message() to wake up poll().
+	int wake_fd;
+
+	std::vector<Serial_Bus*> buses;
+
+	void wake();
+	void handle_output(Serial_Bus &bus);
+	void set_poll_out(Serial_Bus &bus, bool enabled);
+
+public:
+	Serial_Poller();
+	~Serial_Poller();
+
+	Serial_Poller(const Serial_Poller&) = delete;
+	Serial_Poller &operator=(const Serial_Poller&) = delete;
+
+	/*! \brief Register an open bus.
+	 *  \attention add() and remove() must be called from the polling thread,
+	 *   or while poll() is not running.
+	 */
+	bool add(Serial_Bus &bus);
+	void remove(Serial_Bus &bus);
+
+	/*! \brief Wait for and handle bus events.
+	 * @param timeout_ms Maximum time to wait, -1 to wait forever.
+	 * @return Number of handled events, -1 on error.
+	 */
+	int poll(int timeout_ms = -1);
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_SERIALBUS_H_ */
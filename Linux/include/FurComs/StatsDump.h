@@ -0,0 +1,46 @@
+/*!
+ * \file StatsDump.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_STATSDUMP_H_
+#define FURCOMS_STATSDUMP_H_
+
+#include <FurComs/ProtocolCore.h>
+#include <FurComs/BusTrace.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+namespace TEF {
+namespace FurComs {
+
+//! Return the name of a handler_state_t, i.e. "SENDING", or "?" for invalid values.
+const char *get_state_name(int state);
+
+/*! \brief Print bus statistics in readable form.
+ *  \details Prints the counters of a Protocol_Core::get_stats() snapshot,
+ *   along with the arbitration loss rate and bit positions, the escape
+ *   expansion of received frames and the share of time spent per state.
+ */
+void dump_stats(FILE *out, const bus_stats_t &stats);
+
+/*! \brief Print new entries of a Trace_Ring, one transition per line.
+ *  \details Each line holds the timestamp in microseconds, the time
+ *   since the previous entry, and the transition. Lost entries are
+ *   reported as well.
+ *
+ * @param cursor Reader cursor, see Trace_Ring::read().
+ * @param clock_rate Trace clock rate, i.e. bus_stats_t::clock_rate.
+ * @return Number of entries printed.
+ */
+size_t dump_trace(FILE *out, const Trace_Ring &ring, uint32_t &cursor, uint32_t clock_rate);
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_STATSDUMP_H_ */
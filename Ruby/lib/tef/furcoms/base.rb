@@ -1,4 +1,6 @@
 
+require_relative 'rpc.rb'
+require_relative 'schema.rb'
 
 # TheElectricFursuits Ruby namespace.
 # @see https://github.com/TheElectricFursuits/
@@ -16,7 +18,10 @@ module TEF
 		#
 		# @see Serial
 		# @see MQTT
+		# @see RPC
 		class Base
+			include RPC
+
 			# Initialize an empty base class.
 			#
 			# Note that this class cannot be used for communication!
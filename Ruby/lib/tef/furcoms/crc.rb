@@ -0,0 +1,49 @@
+
+module TEF
+	module FurComs
+		# Frame CRC of the FURCOM_MARKER_CRC format.
+		#
+		# A protected frame (or batch record) is the marker byte 0x03,
+		# the frame as it would be sent without CRC, and a big-endian
+		# CRC-32/MPEG-2 of everything between marker and CRC.
+		# Note that Zlib.crc32 is a different, bit-reflected CRC.
+		module CRC
+			# Marker byte of CRC protected frames, see FURCOM_MARKER_CRC
+			MARKER = 0x03
+
+			# @private
+			TABLE = (0..255).map do |i|
+				crc = i << 24
+				8.times do
+					crc = (crc & 0x8000_0000).zero? ? (crc << 1) : ((crc << 1) ^ 0x04C1_1DB7)
+					crc &= 0xFFFF_FFFF
+				end
+				crc
+			end.freeze
+
+			# Compute the CRC of a binary string.
+			def self.compute(data)
+				data.each_byte.reduce(0xFFFF_FFFF) do |crc, b|
+					((crc << 8) & 0xFFFF_FFFF) ^ TABLE[(crc >> 24) ^ b]
+				end
+			end
+
+			# Wrap a frame into the CRC format.
+			def self.wrap(data)
+				data = data.b
+				MARKER.chr + data + [compute(data)].pack('N')
+			end
+
+			# Check and unwrap a frame in the CRC format.
+			# @return [String, nil] The inner frame, or nil if the CRC did not match.
+			def self.unwrap(frame)
+				return nil if frame.bytesize < 5
+
+				data = frame.byteslice(1, frame.bytesize - 5)
+				return nil unless compute(data) == frame.byteslice(-4, 4).unpack1('N')
+
+				data
+			end
+		end
+	end
+end
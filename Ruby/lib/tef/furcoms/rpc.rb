@@ -0,0 +1,148 @@
+module TEF
+	module FurComs
+		# Request/response calls on top of FurComs messages.
+		#
+		# Mixed into {Base}, so every bus connection can call RPC_Method
+		# implementations on bus nodes, and serve methods to RPC_Client
+		# instances itself.
+		#
+		# Requests are sent on the topic of the method, led by a correlation
+		# ID made of the client ID (two bytes, little-endian) and a call ID.
+		# Replies come back on {REPLY_TOPIC}, led by the same correlation ID
+		# and a status byte. See RPC.h for the details.
+		module RPC
+			# Topic all replies are sent on, FURCOM_RPC_REPLY_TOPIC.
+			REPLY_TOPIC = 'rpc/reply'
+
+			# Status of a successful call.
+			OK = 0
+			# Status of a failed call.
+			ERROR = 1
+			# Status of a call that received no reply in time.
+			TIMEOUT = 0xFF
+
+			# Client ID used for calls, unique among all RPC clients on the bus.
+			# Defaults to a random ID in the upper half, to keep out of the way
+			# of IDs given to bus nodes.
+			def rpc_client_id
+				@rpc_client_id ||= 0x8000 + rand(0x8000)
+			end
+
+			attr_writer :rpc_client_id
+
+			# Call a method on a bus node.
+			#
+			# Calls are pipelined: without a block, this waits for the reply
+			# and returns it, with a block it returns right away, and the block
+			# is called once the call completed, from the receiving thread.
+			#
+			# @param topic [String] Topic of the method.
+			# @param args [String] Binary arguments of the call.
+			# @param timeout [Numeric] Seconds to wait for the reply.
+			# @yieldparam status [Integer] Status of the reply, {TIMEOUT} if none came in.
+			# @yieldparam data [String, nil] Result of the method, nil on {TIMEOUT}.
+			# @return [Array(Integer, String), nil] Status and result if no block
+			#   was given, else nil.
+			def rpc_call(topic, args = '', timeout: 1, priority: 0, &block)
+				rpc_setup
+
+				unless block
+					result = Queue.new
+					rpc_call(topic, args, timeout: timeout, priority: priority) do |status, data|
+						result << [status, data]
+					end
+
+					return result.pop
+				end
+
+				call_id = nil
+				@rpc_mutex.synchronize do
+					if @rpc_pending.size >= 256
+						raise ArgumentError, 'Too many RPC calls outstanding!'
+					end
+
+					call_id = @rpc_next_call_id
+					call_id = (call_id + 1) & 0xFF while @rpc_pending.include? call_id
+					@rpc_next_call_id = (call_id + 1) & 0xFF
+
+					@rpc_pending[call_id] = {
+						block: block,
+						deadline: Time.now + timeout
+					}
+					@rpc_deadline_change.signal
+				end
+
+				send_message topic, [rpc_client_id, call_id].pack('vC') + args.b, priority: priority
+
+				nil
+			end
+
+			# Serve a method to RPC clients on the bus.
+			#
+			# The block is called for every request on the topic, its result
+			# sent back as the reply.
+			#
+			# @param topic [String] Topic of the method.
+			# @yieldparam args [String] Binary arguments of the call.
+			# @yieldreturn [String, Array(Integer, String)] Result, or a status and the result.
+			def on_rpc(topic, priority: 0)
+				on_message topic do |data|
+					next if data.length < 3
+
+					result = yield(data[3..-1])
+					status, result = result.is_a?(Array) ? result : [OK, result]
+
+					send_message REPLY_TOPIC, data[0..2] + [status].pack('C') + result.to_s.b, priority: priority
+				end
+			end
+
+			private def rpc_setup
+				return if @rpc_pending
+
+				@rpc_mutex = Mutex.new
+				@rpc_deadline_change = ConditionVariable.new
+				@rpc_pending = {}
+				@rpc_next_call_id = 0
+
+				on_message REPLY_TOPIC do |data|
+					next if data.length < 4
+
+					client_id, call_id, status = data.unpack('vCC')
+					next unless client_id == rpc_client_id
+
+					call = @rpc_mutex.synchronize { @rpc_pending.delete call_id }
+					call[:block].call(status, data[4..-1]) if call
+				end
+
+				@rpc_timeout_thread = Thread.new do
+					loop do
+						rpc_expire
+					end
+				end
+			end
+
+			private def rpc_expire
+				expired = []
+
+				@rpc_mutex.synchronize do
+					now = Time.now
+					expired, = @rpc_pending.partition { |_, call| call[:deadline] <= now }
+					expired.each { |call_id, _| @rpc_pending.delete call_id }
+
+					if expired.empty?
+						next_deadline = @rpc_pending.each_value.map { |call| call[:deadline] }.min
+						@rpc_deadline_change.wait(@rpc_mutex, next_deadline && (next_deadline - now))
+					end
+				end
+
+				expired.each do |_, call|
+					begin
+						call[:block].call(TIMEOUT, nil)
+					rescue => e
+						x_logf("Error in RPC callback #{call[:block]}: #{e}")
+					end
+				end
+			end
+		end
+	end
+end
@@ -0,0 +1,80 @@
+module TEF
+	module FurComs
+		# Binary message layout, generated from a C++ schema.
+		#
+		# Mirrors Schema_Fields from Schema.h: fields are packed in order,
+		# without padding, each in little-endian byte order. Instances are
+		# usually printed by schema_write_ruby() from a host tool, rather than
+		# written by hand.
+		#
+		# @example
+		#   coms_interface.on_message BatteryStatus.topic do |data|
+		#     p BatteryStatus.decode(data)[:voltage_mv]
+		#   end
+		class Schema
+			# @return [String] Topic the messages are sent on.
+			attr_reader :topic
+			# @return [Array<Symbol>] Names of all fields, in order.
+			attr_reader :names
+			# @return [Integer] Length of a message with all fields, in bytes.
+			attr_reader :length
+
+			# @param topic [String] Topic the messages are sent on.
+			# @param fields [Array] Per field its name, its pack() directive,
+			#   and its kind, one of :int, :float, :bool, :bytes or :string.
+			def initialize(topic, *fields)
+				@topic = topic
+				@fields = fields
+				@names = fields.map(&:first)
+
+				@sizes = fields.map { |_, directive, kind| [empty_value(kind)].pack(directive).bytesize }
+				@length = @sizes.sum
+			end
+
+			# Decode a message.
+			#
+			# Fields the message is too short for, i.e. because it was sent
+			# with an older version of the schema, are nil.
+			# @param data [String] Binary payload of the message.
+			# @return [Hash<Symbol, Object>] Value of every field.
+			def decode(data)
+				values = {}
+				offset = 0
+
+				@fields.each_with_index do |(name, directive, kind), i|
+					size = @sizes[i]
+					if offset + size > data.bytesize
+						values[name] = nil
+					else
+						value = data.byteslice(offset, size).unpack1(directive)
+						value = (value != 0) if kind == :bool
+						values[name] = value
+					end
+
+					offset += size
+				end
+
+				values
+			end
+
+			# Encode a message.
+			#
+			# @param values [Hash<Symbol, Object>] Value of every field,
+			#   missing ones are sent as 0.
+			# @return [String] Binary payload, to be sent on {#topic}.
+			def encode(values)
+				@fields.map do |name, directive, kind|
+					value = values[name]
+					value = value ? 1 : 0 if kind == :bool
+					value = empty_value(kind) if value.nil?
+
+					[value].pack(directive)
+				end.join.b
+			end
+
+			private def empty_value(kind)
+				[:bytes, :string].include?(kind) ? '' : 0
+			end
+		end
+	end
+end
@@ -1,5 +1,6 @@
 
 require_relative 'base.rb'
+require_relative 'crc.rb'
 
 require 'serialport'
 require 'xasin_logger'
@@ -25,30 +26,188 @@ module TEF
 			# onto the FurComs bus.
 			# @note This class can not provide full arbitration handling. This may
 			#   cause issues in busy bus conditions!
+			# @param crc [Boolean] Protect sent messages with a CRC, see
+			#   Protocol_Core::set_crc(). Received CRC frames are always checked.
 			# @todo Add graceful handling of controller disconnect/reconnect.
-			def initialize(port = '/dev/ttyACM0', baudrate = 115_200)
+			def initialize(port = '/dev/ttyACM0', baudrate = 115_200, crc: false)
 				super();
 
+				@crc = crc
+				@crc_errors = 0
+
 				@port = SerialPort.new(port);
 				@port.baud = baudrate;
 				@port.sync = true;
 
+				@topic_ids = {}
+				@fragments = {}
+				@fragment_transfer = 0
+
 				start_thread();
 
 				init_x_log("FurComs #{port}")
 				x_logi('Ready!');
 			end
 
+			# @return [Integer] Number of received frames and records that
+			#   were dropped because their CRC did not match.
+			attr_reader :crc_errors
+
 			private def decode_data_string(data)
 				return if data.length() < 9
 
-				payload = data[8..-1]
-				topic, _sep, payload = payload.partition("\0")
+				payload = strip_routed data[8..-1]
+				payload = check_crc(payload) if payload.getbyte(0) == CRC::MARKER
+				return if payload.nil? || payload.empty?
+
+				if payload.getbyte(0) == 0x01 # Batch frame, see FURCOM_MARKER_BATCH
+					decode_batch payload
+				else
+					decode_record payload
+				end
+			end
+
+			# @private
+			# Split a batch frame into its records, each made of a length
+			# byte followed by topic, NUL and payload.
+			private def decode_batch(payload)
+				pos = 1
+				while pos < payload.bytesize
+					record_length = payload.getbyte(pos)
+					pos += 1
+					break if record_length > payload.bytesize - pos
+
+					decode_record payload.byteslice(pos, record_length)
+					pos += record_length
+				end
+			end
+
+			# @private
+			# Unwrap a frame or record in the FURCOM_MARKER_CRC format,
+			# counting it if the CRC does not match.
+			private def check_crc(data)
+				inner = CRC.unwrap(data)
+				@crc_errors += 1 if inner.nil?
+
+				inner
+			end
+
+			# @private
+			# Remove the header a Router puts in front of forwarded
+			# frames and records, see FURCOM_MARKER_ROUTED.
+			private def strip_routed(data)
+				return data unless data.getbyte(0) == 0x04
+
+				data.byteslice(4..-1) || ''
+			end
+
+			private def decode_record(record)
+				record = strip_routed record
+				return if record.empty?
+
+				if record.getbyte(0) == CRC::MARKER
+					record = check_crc(record)
+					return if record.nil?
+				end
+
+				if record.getbyte(0) == 0x05 # Fragment, see FURCOM_MARKER_FRAGMENT
+					decode_fragment record
+					return
+				end
+
+				topic, payload = split_packet record
+				return if topic.nil?
+
+				learn_topic_id(payload) if topic == 'FurComs/TopicID'
+
+				handout_data(topic, payload);
+			end
+
+			# @private
+			# Split a packet into topic and payload, resolving topic IDs.
+			# @return [Array(String, String), nil]
+			private def split_packet(record)
+				if record.getbyte(0) == 0x02 # Topic ID packet, see FURCOM_MARKER_TOPIC_ID
+					id, id_length = decode_topic_id(record, 1)
+					return nil if id.nil? || (topic = @topic_ids[id]).nil?
+
+					return [topic, record.byteslice((1 + id_length)..-1)]
+				end
+
+				topic, _sep, payload = record.partition("\0")
 
 				# Filter out unsafe topics
+				return nil unless topic =~ /^[\w\s\/]*$/
+
+				[topic, payload]
+			end
+
+			# @private
+			# Collect the fragments of a long message, made of a transfer
+			# ID, a little-endian sequence number with bit 15 set on the
+			# last fragment, and a packet. The message is handed out
+			# once complete, and dropped if a fragment went missing.
+			private def decode_fragment(record)
+				return if record.bytesize < 4
+
+				transfer = record.getbyte(1)
+				sequence = record.byteslice(2, 2).unpack1('v')
+				last = (sequence & 0x8000) != 0
+				sequence &= 0x7FFF
+
+				topic, payload = split_packet record.byteslice(4..-1)
+				return if topic.nil?
+
+				@fragments[topic] = { transfer: transfer, next: 0, data: ''.b } if sequence.zero?
+				return if (state = @fragments[topic]).nil?
+
+				unless state[:transfer] == transfer && state[:next] == sequence
+					@fragments.delete topic
+					return
+				end
+
+				if last
+					@fragments.delete topic
+
+					# Drop messages with fragments cut short on the way.
+					total = payload.unpack1('V')
+					payload = payload.byteslice(4..-1) || ''.b
+					return unless total == state[:data].bytesize + payload.bytesize
+				end
+
+				state[:data] << payload
+				state[:next] += 1
+				return unless last
+
+				handout_data(topic, state[:data])
+			end
+
+			# @private
+			# Decode a LEB128 topic ID of up to three bytes.
+			# @return [Array(Integer, Integer), nil] ID and number of bytes used.
+			private def decode_topic_id(data, pos)
+				id = 0
+				3.times do |i|
+					c = data.getbyte(pos + i)
+					return nil if c.nil?
+
+					id |= (c & 0x7F) << (7 * i)
+					return [id, i + 1] if (c & 0x80).zero?
+				end
+
+				nil
+			end
+
+			# @private
+			# Store an announced topic ID, made of the ID and the topic string.
+			private def learn_topic_id(payload)
+				id, id_length = decode_topic_id(payload, 0)
+				return if id.nil?
+
+				topic = payload.byteslice(id_length..-1)
 				return unless topic =~ /^[\w\s\/]*$/
 
-				handout_data(topic, payload);
+				@topic_ids[id] ||= topic
 			end
 
 			private def start_thread()
@@ -115,18 +274,56 @@ module TEF
 				out_data
 			end
 
+			# @private
+			# Send a message too long for one frame as a series of
+			# fragments, see FURCOM_MARKER_FRAGMENT.
+			private def send_fragments(topic, message, chunk_size, priority, chip_id)
+				chunks = (0...message.bytesize).step(chunk_size).map do |pos|
+					message.byteslice(pos, chunk_size)
+				end
+				raise ArgumentError, 'Message packet length exceeded!' if chunks.length > 0x8000
+
+				@fragment_transfer = (@fragment_transfer + 1) & 0xFF
+
+				chunks.each_with_index do |chunk, i|
+					last = (i == chunks.length - 1)
+					sequence = i | (last ? 0x8000 : 0)
+					header = [0x05, @fragment_transfer, sequence].pack('CCv')
+					# The last fragment leads with the message length.
+					chunk = [message.bytesize].pack('V') + chunk if last
+
+					write_packet header + "#{topic}\0".b + chunk, priority, chip_id
+				end
+			end
+
 			# (see Base#send_message)
+			#
+			# Messages too long for one frame are sent in fragments, which
+			# are reassembled by the receiving Serial, or a Fragment_Receiver
+			# on the bus nodes.
 			def send_message(topic, message, priority: 0, chip_id: 0)
 				unless topic =~ /^[\w\s\/]*$/
 					raise ArgumentError, 'Topic includes invalid characters!'
 				end
-				if (topic.length + message.length) > 250
-					raise ArgumentError, 'Message packet length exceeded!'
-				end
+
+				max_length = @crc ? 245 : 250
+				raise ArgumentError, 'Topic length exceeded!' if topic.length + 8 >= max_length
 
 				x_logd("Sending '#{topic}': '#{message}'")
 
-				escaped_str = slip_encode_data "#{topic}\0#{message}"
+				if (topic.length + message.length) > max_length
+					send_fragments topic, message.b, max_length - topic.length - 8, priority, chip_id
+				else
+					write_packet "#{topic}\0#{message}", priority, chip_id
+				end
+			end
+
+			# @private
+			# Frame and write one packet.
+			private def write_packet(packet, priority, chip_id)
+				packet = CRC.wrap(packet) if @crc
+
+				escaped_str = slip_encode_data packet
 				out_data = generate_furcom_message priority, chip_id, escaped_str;
 
 				@port.write(out_data.pack('C2S<C*'))
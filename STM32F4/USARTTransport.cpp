@@ -0,0 +1,205 @@
+/*
+ * USARTTransport.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/USARTTransport.h>
+
+namespace TEF {
+namespace FurComs {
+
+USART_Transport::USART_Transport(USART_TypeDef *handle,
+		DMA_Stream_TypeDef *stream, uint32_t channel) :
+		uart_handle(handle),
+		tx_stream(stream), tx_channel(channel),
+		tx_flag_clear_reg(nullptr), tx_flag_shift(0),
+		rx_stream(nullptr), rx_channel(0),
+		rx_buffer(nullptr), rx_buffer_size(0),
+		rx_flag_status_reg(nullptr), rx_flag_clear_reg(nullptr), rx_flag_shift(0),
+		rx_timeout_enabled(false) {
+
+	if(tx_stream == nullptr)
+		return;
+
+	volatile uint32_t *status_reg;
+	get_stream_flags(tx_stream, status_reg, tx_flag_clear_reg, tx_flag_shift);
+}
+
+void USART_Transport::get_stream_flags(DMA_Stream_TypeDef *stream,
+		volatile uint32_t *&status_reg, volatile uint32_t *&clear_reg, uint8_t &shift) {
+	// Work out the flag register and bit offset of this stream, the same way
+	// the HAL does it. Streams 0-3 live in LISR/LIFCR, 4-7 in HISR/HIFCR.
+	uintptr_t stream_addr = reinterpret_cast<uintptr_t>(stream);
+	DMA_TypeDef *dma = (stream_addr < DMA2_BASE) ? DMA1 : DMA2;
+	uint32_t stream_num = (stream_addr - reinterpret_cast<uintptr_t>(dma) - 0x10) / 0x18;
+
+	static const uint8_t flag_shifts[] = { 0, 6, 16, 22 };
+	shift = flag_shifts[stream_num & 0b11];
+	status_reg = (stream_num < 4) ? &dma->LISR : &dma->HISR;
+	clear_reg  = (stream_num < 4) ? &dma->LIFCR : &dma->HIFCR;
+}
+
+void USART_Transport::configure_rx_dma(DMA_Stream_TypeDef *stream, uint32_t channel,
+		uint8_t *buffer, size_t size) {
+	rx_stream = stream;
+	rx_channel = channel;
+	rx_buffer = buffer;
+	rx_buffer_size = size;
+
+	get_stream_flags(rx_stream, rx_flag_status_reg, rx_flag_clear_reg, rx_flag_shift);
+}
+
+void USART_Transport::enable_rx_timeout() {
+	rx_timeout_enabled = true;
+}
+
+void USART_Transport::init() {
+	if(rx_stream != nullptr) {
+		rx_stream->CR &= ~DMA_SxCR_EN;
+		while(rx_stream->CR & DMA_SxCR_EN) {}
+
+		*rx_flag_clear_reg = 0x3D << rx_flag_shift;
+
+		rx_stream->PAR  = reinterpret_cast<uintptr_t>(&uart_handle->RDR);
+		rx_stream->M0AR = reinterpret_cast<uintptr_t>(rx_buffer);
+		rx_stream->NDTR = rx_buffer_size;
+		rx_stream->CR   = (rx_channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC | DMA_SxCR_CIRC
+				| DMA_SxCR_HTIE | DMA_SxCR_TCIE;
+		rx_stream->CR  |= DMA_SxCR_EN;
+
+		uart_handle->ICR = USART_ICR_IDLECF;
+		uart_handle->CR1 |= USART_CR1_IDLEIE;
+	}
+
+	uart_handle->CR1 |= USART_CR1_RXNEIE;
+}
+
+uint32_t USART_Transport::poll_events(uint8_t &rx_byte) {
+	uint32_t isr = uart_handle->ISR;
+	uint32_t cr1 = uart_handle->CR1;
+	uint32_t events = 0;
+
+	// In DMA mode RXNE is serviced by the DMA, reading RDR would steal a byte.
+	if((isr & USART_ISR_RXNE) && (cr1 & USART_CR1_RXNEIE)) {
+		rx_byte = uart_handle->RDR;
+		events |= TRANSPORT_RX;
+	}
+
+	if((isr & USART_ISR_IDLE) && (cr1 & USART_CR1_IDLEIE)) {
+		uart_handle->ICR = USART_ICR_IDLECF;
+		events |= TRANSPORT_RX_SPAN;
+	}
+
+	if(rx_stream != nullptr) {
+		uint32_t dma_flags = (DMA_LISR_HTIF0 | DMA_LISR_TCIF0) << rx_flag_shift;
+		if(*rx_flag_status_reg & dma_flags) {
+			*rx_flag_clear_reg = dma_flags;
+			events |= TRANSPORT_RX_SPAN;
+		}
+	}
+
+	if((isr & USART_ISR_RTOF) && (cr1 & USART_CR1_RTOIE)) {
+		uart_handle->ICR = USART_ICR_RTOCF;
+		events |= TRANSPORT_RX_TIMEOUT;
+	}
+
+	if((isr & USART_ISR_TXE) && (cr1 & USART_CR1_TXEIE))
+		events |= TRANSPORT_TX_READY;
+
+	if((isr & USART_ISR_TC) && (cr1 & USART_CR1_TCIE)) {
+		uart_handle->CR1 &= ~USART_CR1_TCIE;
+		uart_handle->CR3 &= ~USART_CR3_DMAT;
+		uart_handle->ICR = USART_ICR_TCCF;
+
+		events |= TRANSPORT_TX_DONE;
+	}
+
+	return events;
+}
+
+void USART_Transport::write_byte(uint8_t c) {
+	uart_handle->TDR = c;
+}
+
+void USART_Transport::set_tx_irq(bool enabled) {
+	if(enabled)
+		uart_handle->CR1 |= USART_CR1_TXEIE;
+	else
+		uart_handle->CR1 &= ~USART_CR1_TXEIE;
+}
+
+bool USART_Transport::has_dma_tx() const {
+	return tx_stream != nullptr;
+}
+
+void USART_Transport::start_dma_tx(const uint8_t *data, size_t length) {
+	tx_stream->CR &= ~DMA_SxCR_EN;
+	while(tx_stream->CR & DMA_SxCR_EN) {}
+
+	*tx_flag_clear_reg = 0x3D << tx_flag_shift;
+
+	tx_stream->PAR  = reinterpret_cast<uintptr_t>(&uart_handle->TDR);
+	tx_stream->M0AR = reinterpret_cast<uintptr_t>(data);
+	tx_stream->NDTR = length;
+	tx_stream->CR   = (tx_channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MINC | DMA_SxCR_DIR_0;
+
+	// TC is only reported once the DMA has loaded the last byte and the
+	// shift register ran empty, i.e. the data has fully left the wire.
+	uart_handle->ICR = USART_ICR_TCCF;
+	uart_handle->CR3 |= USART_CR3_DMAT;
+
+	tx_stream->CR |= DMA_SxCR_EN;
+	uart_handle->CR1 |= USART_CR1_TCIE;
+}
+
+bool USART_Transport::has_dma_rx() const {
+	return rx_stream != nullptr;
+}
+
+void USART_Transport::use_rx_dma(bool enabled) {
+	if(enabled) {
+		uart_handle->CR1 &= ~USART_CR1_RXNEIE;
+		uart_handle->CR3 |= USART_CR3_DMAR;
+	}
+	else {
+		uart_handle->CR3 &= ~USART_CR3_DMAR;
+		uart_handle->CR1 |= USART_CR1_RXNEIE;
+	}
+}
+
+const uint8_t *USART_Transport::rx_dma_buffer(size_t &size) const {
+	size = rx_buffer_size;
+	return rx_buffer;
+}
+
+size_t USART_Transport::rx_dma_position() const {
+	size_t pos = rx_buffer_size - rx_stream->NDTR;
+	return (pos >= rx_buffer_size) ? 0 : pos;
+}
+
+bool USART_Transport::has_rx_timeout() const {
+	return rx_timeout_enabled;
+}
+
+void USART_Transport::set_rx_timeout(uint32_t bit_times) {
+	if(bit_times > USART_RTOR_RTO)
+		bit_times = USART_RTOR_RTO;
+
+	uart_handle->RTOR = (uart_handle->RTOR & ~USART_RTOR_RTO) | bit_times;
+
+	// RTOEN may only be changed while the USART is disabled.
+	if(!(uart_handle->CR2 & USART_CR2_RTOEN)) {
+		uint32_t cr1 = uart_handle->CR1;
+
+		uart_handle->CR1 = cr1 & ~USART_CR1_UE;
+		uart_handle->CR2 |= USART_CR2_RTOEN;
+		uart_handle->CR1 = cr1;
+	}
+
+	uart_handle->ICR = USART_ICR_RTOCF;
+	uart_handle->CR1 |= USART_CR1_RTOIE;
+}
+
+} /* namespace FurComs */
+} /* namespace TEF */
@@ -0,0 +1,112 @@
+/*!
+ * \file USARTTransport.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_USARTTRANSPORT_H_
+#define FURCOMS_USARTTRANSPORT_H_
+
+#include "main.h"
+
+#include <FurComs/Transport.h>
+
+namespace TEF {
+namespace FurComs {
+
+/*! \brief STM32 USART transport.
+ *  \details Register-level implementation of the FurComs Transport for
+ *   the STM32 USART peripheral. Optionally, a DMA stream may be given, in
+ *   which case frame transmission is done via DMA instead of one TXE
+ *   interrupt per byte.
+ *
+ *   A second DMA stream may be configured with configure_rx_dma(), which
+ *   will then receive into a circular buffer and use the idle-line
+ *   interrupt to report new data.
+ *
+ *   The USART receiver timeout (RTOR) is used for bus idle detection if
+ *   enabled with enable_rx_timeout(). Not every USART instance has one.
+ *
+ *   \pre The DMA streams, if used, must be clocked and connected to the
+ *    USART's TX/RX request. The channel numbers are given to this class,
+ *    everything else is configured by it.
+ *   \pre When using RX DMA, LL_Handler::handle_isr() must additionally be
+ *    called from the RX DMA stream's IRQ handler.
+ */
+class USART_Transport : public Transport {
+private:
+	USART_TypeDef *uart_handle;
+
+	DMA_Stream_TypeDef *tx_stream;
+	uint32_t tx_channel;
+
+	volatile uint32_t *tx_flag_clear_reg;
+	uint8_t tx_flag_shift;
+
+	DMA_Stream_TypeDef *rx_stream;
+	uint32_t rx_channel;
+	uint8_t *rx_buffer;
+	size_t rx_buffer_size;
+
+	volatile uint32_t *rx_flag_status_reg;
+	volatile uint32_t *rx_flag_clear_reg;
+	uint8_t rx_flag_shift;
+
+	bool rx_timeout_enabled;
+
+	static void get_stream_flags(DMA_Stream_TypeDef *stream,
+			volatile uint32_t *&status_reg, volatile uint32_t *&clear_reg, uint8_t &shift);
+
+public:
+	/*! \brief Construct a new USART transport.
+	 *
+	 * @param uart_handle USART instance, pre-configured by the user.
+	 * @param tx_stream Optional DMA stream to use for frame transmission.
+	 * @param tx_channel DMA request channel of the USART TX line on tx_stream.
+	 */
+	USART_Transport(USART_TypeDef *uart_handle,
+			DMA_Stream_TypeDef *tx_stream = nullptr, uint32_t tx_channel = 0);
+
+	/*! \brief Configure circular DMA reception.
+	 *  \details Must be called before init(). The buffer should be large
+	 *   enough to hold the data received within one interrupt latency
+	 *   period; half and full transfer interrupts will flush it.
+	 *
+	 * @param rx_stream DMA stream connected to the USART RX request.
+	 * @param rx_channel DMA request channel of the USART RX line.
+	 * @param buffer Circular buffer to receive into.
+	 * @param size Size of the buffer, in bytes.
+	 */
+	void configure_rx_dma(DMA_Stream_TypeDef *rx_stream, uint32_t rx_channel,
+			uint8_t *buffer, size_t size);
+
+	/*! \brief Use the receiver timeout for bus idle detection.
+	 *  \details Must be called before init(), and only for USART instances
+	 *   that have a receiver timeout (RTOR register).
+	 */
+	void enable_rx_timeout();
+
+	void init();
+	uint32_t poll_events(uint8_t &rx_byte);
+
+	void write_byte(uint8_t c);
+	void set_tx_irq(bool enabled);
+
+	bool has_dma_tx() const;
+	void start_dma_tx(const uint8_t *data, size_t length);
+
+	bool has_dma_rx() const;
+	void use_rx_dma(bool enabled);
+	const uint8_t *rx_dma_buffer(size_t &size) const;
+	size_t rx_dma_position() const;
+
+	bool has_rx_timeout() const;
+	void set_rx_timeout(uint32_t bit_times);
+};
+
+} /* namespace FurComs */
+} /* namespace TEF */
+
+#endif /* FURCOMS_USARTTRANSPORT_H_ */
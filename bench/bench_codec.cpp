@@ -0,0 +1,152 @@
+/*
+ * bench_codec.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/CRC.h>
+#include <FurComs/Codec.h>
+#include <FurComs/SLIP.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+typedef std::vector<uint8_t> bytes_t;
+
+enum payload_t {
+	TYPICAL,     //!< Text with the odd FURCOM_END, as most telemetry.
+	ADVERSARIAL, //!< Nothing but FURCOM_END and FURCOM_ESCAPE.
+};
+
+bytes_t make_payload(payload_t type, size_t length) {
+	std::mt19937 rng(1);
+	bytes_t data(length);
+
+	for(auto &c : data) {
+		if(type == ADVERSARIAL)
+			c = (rng() & 1) ? uint8_t(FURCOM_END) : uint8_t(FURCOM_ESCAPE);
+		else
+			c = (rng() % 200 == 0) ? uint8_t(FURCOM_END) : uint8_t('a' + rng() % 26);
+	}
+
+	return data;
+}
+
+bytes_t make_encoded(payload_t type, size_t length) {
+	bytes_t raw = make_payload(type, length);
+	bytes_t encoded(2 * length);
+	encoded.resize(slip_encode(raw.data(), raw.size(), encoded.data()));
+
+	return encoded;
+}
+
+//! Byte at a time encoder, the way the firmware originally sent.
+size_t bytewise_encode(const void *src, size_t length, uint8_t *dst) {
+	const uint8_t *pos = reinterpret_cast<const uint8_t*>(src);
+	uint8_t *out = dst;
+
+	while(length--) {
+		uint8_t c = *(pos++);
+		if(c == FURCOM_END || c == FURCOM_ESCAPE) {
+			*(out++) = FURCOM_ESCAPE;
+			*(out++) = (c == FURCOM_END) ? FURCOM_ESC_END : FURCOM_ESC_ESC;
+		}
+		else
+			*(out++) = c;
+	}
+
+	return out - dst;
+}
+
+//! Byte at a time decoder, the way the firmware originally received.
+size_t bytewise_decode(const uint8_t *src, size_t length,
+		char *&dst, const char *dst_end, bool &had_escape) {
+	size_t i = 0;
+
+	for(; i < length; i++) {
+		uint8_t c = src[i];
+		if(c == FURCOM_END)
+			break;
+		if(dst >= dst_end)
+			continue;
+
+		if(had_escape) {
+			if(c == FURCOM_ESC_END)
+				*(dst++) = char(FURCOM_END);
+			else if(c == FURCOM_ESC_ESC)
+				*(dst++) = char(FURCOM_ESCAPE);
+			had_escape = false;
+		}
+		else if(c == FURCOM_ESCAPE)
+			had_escape = true;
+		else
+			*(dst++) = char(c);
+	}
+
+	return i;
+}
+
+template<size_t (*ENCODE)(const void*, size_t, uint8_t*)>
+void BM_Encode(benchmark::State &state) {
+	bytes_t raw = make_payload(payload_t(state.range(0)), state.range(1));
+	bytes_t out(2 * raw.size());
+
+	for(auto _ : state)
+		benchmark::DoNotOptimize(ENCODE(raw.data(), raw.size(), out.data()));
+
+	state.SetBytesProcessed(state.iterations() * raw.size());
+}
+
+template<size_t (*DECODE)(const uint8_t*, size_t, char*&, const char*, bool&)>
+void BM_Decode(benchmark::State &state) {
+	bytes_t encoded = make_encoded(payload_t(state.range(0)), state.range(1));
+	std::vector<char> out(encoded.size());
+
+	for(auto _ : state) {
+		char *dst = out.data();
+		bool had_escape = false;
+
+		benchmark::DoNotOptimize(DECODE(encoded.data(), encoded.size(),
+				dst, out.data() + out.size(), had_escape));
+		benchmark::ClobberMemory();
+	}
+
+	state.SetBytesProcessed(state.iterations() * encoded.size());
+}
+
+template<uint32_t (*CRC)(uint32_t, const void*, size_t)>
+void BM_CRC(benchmark::State &state) {
+	bytes_t raw = make_payload(TYPICAL, state.range(0));
+
+	for(auto _ : state)
+		benchmark::DoNotOptimize(CRC(FURCOM_CRC_INIT, raw.data(), raw.size()));
+
+	state.SetBytesProcessed(state.iterations() * raw.size());
+}
+
+//! Both payload types, at the size of a frame and of a bulk transfer.
+void payload_args(benchmark::internal::Benchmark *b) {
+	b->ArgNames({"adversarial", "bytes"});
+	for(int type : {TYPICAL, ADVERSARIAL})
+		for(int length : {250, 1 << 16})
+			b->Args({type, length});
+}
+
+}
+
+BENCHMARK_TEMPLATE(BM_Encode, bytewise_encode)->Apply(payload_args);
+BENCHMARK_TEMPLATE(BM_Encode, slip_encode)->Apply(payload_args);
+BENCHMARK_TEMPLATE(BM_Encode, codec_encode)->Apply(payload_args);
+
+BENCHMARK_TEMPLATE(BM_Decode, bytewise_decode)->Apply(payload_args);
+BENCHMARK_TEMPLATE(BM_Decode, slip_decode_span)->Apply(payload_args);
+BENCHMARK_TEMPLATE(BM_Decode, codec_decode)->Apply(payload_args);
+
+BENCHMARK_TEMPLATE(BM_CRC, crc_update)->Arg(250)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_CRC, codec_crc)->Arg(250)->Arg(1 << 16);
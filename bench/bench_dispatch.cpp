@@ -0,0 +1,114 @@
+/*
+ * bench_dispatch.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/Subscriptions.h>
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+//! Topics of a fursuit with a few dozen modules, as the receive handlers test them.
+const char *const TOPICS[] = {
+	"power/battery", "power/charger", "power/rail/5v", "power/rail/12v",
+	"power/shutdown", "motor/left/telemetry", "motor/right/telemetry",
+	"motor/left/command", "motor/right/command", "motor/enable",
+	"fan/head/speed", "fan/head/command", "fan/body/speed", "fan/body/command",
+	"temp/head", "temp/body", "temp/battery", "temp/ambient",
+	"led/eyes/color", "led/eyes/pattern", "led/ears/color", "led/ears/pattern",
+	"led/tail/color", "led/tail/pattern", "led/brightness",
+	"imu/head/orientation", "imu/head/raw", "imu/tail/orientation",
+	"audio/volume", "audio/play", "audio/stop",
+	"display/face", "display/brightness", "ear/left/position", "ear/right/position",
+	"tail/wag", "mode/select",
+};
+//! Prefixes, as tested with strncmp().
+const char *const PREFIXES[] = {
+	"debug/*", "cfg/*", "rpc/req/*",
+};
+constexpr size_t TOPIC_NUM = sizeof(TOPICS) / sizeof(TOPICS[0]);
+constexpr size_t PREFIX_NUM = sizeof(PREFIXES) / sizeof(PREFIXES[0]);
+
+void count_call(void *context, const char *topic, const void *data, size_t length) {
+	(void)topic;
+	(void)data;
+	(void)length;
+
+	(*reinterpret_cast<int*>(context))++;
+}
+
+/*! The way the firmware dispatched before the table: one strcmp() per
+ *  topic, in order, until one matches. */
+int if_chain_dispatch(const char *topic, const void *data, size_t length, int &calls) {
+	for(auto pattern : TOPICS) {
+		if(strcmp(topic, pattern) == 0) {
+			count_call(&calls, topic, data, length);
+			return 1;
+		}
+	}
+
+	for(auto pattern : PREFIXES) {
+		if(strncmp(topic, pattern, strlen(pattern) - 1) == 0) {
+			count_call(&calls, topic, data, length);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+//! Received topics: every subscribed one, a few prefixed and some nobody wants.
+std::vector<const char*> received_topics() {
+	std::vector<const char*> topics(TOPICS, TOPICS + TOPIC_NUM);
+
+	topics.insert(topics.end(), {
+		"debug/motor/left", "cfg/led/eyes", "rpc/req/temp",
+		"sensor/unknown", "motor/middle/telemetry", "led/nose/color",
+	});
+
+	return topics;
+}
+
+void BM_IfChain(benchmark::State &state) {
+	std::vector<const char*> topics = received_topics();
+	int calls = 0;
+
+	for(auto _ : state) {
+		for(auto topic : topics)
+			benchmark::DoNotOptimize(if_chain_dispatch(topic, nullptr, 0, calls));
+	}
+
+	state.SetItemsProcessed(state.iterations() * topics.size());
+	state.counters["subscriptions"] = TOPIC_NUM + PREFIX_NUM;
+}
+
+void BM_SubscriptionTable(benchmark::State &state) {
+	std::vector<const char*> topics = received_topics();
+	int calls = 0;
+
+	Subscription_Table table;
+	for(auto pattern : TOPICS)
+		table.subscribe(pattern, count_call, &calls);
+	for(auto pattern : PREFIXES)
+		table.subscribe(pattern, count_call, &calls);
+
+	for(auto _ : state) {
+		for(auto topic : topics)
+			benchmark::DoNotOptimize(table.dispatch(topic, nullptr, 0));
+	}
+
+	state.SetItemsProcessed(state.iterations() * topics.size());
+	state.counters["subscriptions"] = TOPIC_NUM + PREFIX_NUM;
+}
+
+}
+
+BENCHMARK(BM_IfChain);
+BENCHMARK(BM_SubscriptionTable);
@@ -0,0 +1,110 @@
+/*
+ * bench_prepared.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/PreparedPacket.h>
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr const char *TOPIC = "telemetry/motor/left/current";
+
+/*! Empty the queue the way the handler does once frames are sent, so
+ *  the benchmark only times queueing. The bus is never stepped, so
+ *  nothing else consumes the queue. */
+void drain(Protocol_Core &node) {
+	TX_Queue &queue = node.get_tx_queue(PRIO_NORMAL);
+
+	const uint8_t *ptr;
+	size_t length;
+	while(queue.peek_frame(ptr, length))
+		queue.release_frame();
+}
+
+//! Publish the payload with start_packet(), add_packet_data() and close_packet().
+template<size_t LENGTH>
+struct start_packet_path_t {
+	Protocol_Core &node;
+	uint8_t *payload;
+
+	start_packet_path_t(Protocol_Core &node, uint8_t *payload) : node(node), payload(payload) {
+	}
+
+	void set(size_t offset, uint32_t value) { memcpy(payload + offset, &value, sizeof(value)); }
+	void send() {
+		node.start_packet(TOPIC);
+		node.add_packet_data(payload, LENGTH);
+		node.close_packet();
+	}
+};
+
+//! Publish the payload with send_packet().
+template<size_t LENGTH>
+struct send_packet_path_t {
+	Protocol_Core &node;
+	uint8_t *payload;
+
+	send_packet_path_t(Protocol_Core &node, uint8_t *payload) : node(node), payload(payload) {
+	}
+
+	void set(size_t offset, uint32_t value) { memcpy(payload + offset, &value, sizeof(value)); }
+	void send() { node.send_packet(TOPIC, payload, LENGTH); }
+};
+
+//! Publish the payload through a Prepared_Packet.
+template<size_t LENGTH>
+struct prepared_path_t {
+	Prepared_Packet<LENGTH> packet;
+
+	prepared_path_t(Protocol_Core &node, uint8_t *payload) : packet(node, TOPIC) {
+		packet.set(0, payload, LENGTH);
+	}
+
+	void set(size_t offset, uint32_t value) { packet.set(offset, value); }
+	void send() { packet.send(); }
+};
+
+/*! Publish telemetry whose last field changes every time, draining the
+ *  queue every four packets. Bytes of 0x55 need no escaping, so all three
+ *  paths put the same frame into the queue. */
+template<template<size_t> class PATH, size_t LENGTH>
+void BM_Publish(benchmark::State &state) {
+	Bus_Sim bus;
+	Sim_Node<> node(bus, 1);
+	node.set_crc(state.range(0));
+
+	uint8_t payload[LENGTH];
+	memset(payload, 0x55, sizeof(payload));
+
+	PATH<LENGTH> path(node, payload);
+	uint32_t value = 0;
+
+	for(auto _ : state) {
+		path.set(LENGTH - sizeof(value), value++);
+		path.send();
+
+		if((value & 3) == 0)
+			drain(node);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+}
+
+#define PUBLISH_BENCHMARKS(LENGTH) \
+	BENCHMARK_TEMPLATE(BM_Publish, start_packet_path_t, LENGTH)->ArgName("crc")->Arg(0)->Arg(1); \
+	BENCHMARK_TEMPLATE(BM_Publish, send_packet_path_t, LENGTH)->ArgName("crc")->Arg(0)->Arg(1); \
+	BENCHMARK_TEMPLATE(BM_Publish, prepared_path_t, LENGTH)->ArgName("crc")->Arg(0)->Arg(1)
+
+PUBLISH_BENCHMARKS(8);
+PUBLISH_BENCHMARKS(24);
+PUBLISH_BENCHMARKS(64);
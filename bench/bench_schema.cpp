@@ -0,0 +1,154 @@
+/*
+ * bench_schema.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/SLIP.h>
+#include <FurComs/Schema.h>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+struct Motor_Telemetry {
+	static constexpr const char *TOPIC = "motor/telemetry";
+
+	FURCOM_SCHEMA_FIELD(position, int32_t);
+	FURCOM_SCHEMA_FIELD(velocity, int16_t);
+	FURCOM_SCHEMA_FIELD(current_ma, uint16_t);
+	FURCOM_SCHEMA_FIELD(temperature, float);
+	FURCOM_SCHEMA_FIELD(enabled, bool);
+
+	typedef Schema_Fields<position, velocity, current_ma, temperature, enabled> fields;
+};
+
+struct telemetry_t {
+	int32_t position;
+	int16_t velocity;
+	uint16_t current_ma;
+	float temperature;
+	bool enabled;
+};
+
+constexpr size_t SAMPLES = 1024;
+constexpr size_t FRAME_SIZE = 128;
+
+std::vector<telemetry_t> make_samples() {
+	std::mt19937 rng(1);
+	std::vector<telemetry_t> samples(SAMPLES);
+
+	for(auto &sample : samples) {
+		sample.position = int32_t(rng() % 2000000) - 1000000;
+		sample.velocity = int16_t(int(rng() % 4000) - 2000);
+		sample.current_ma = uint16_t(rng() % 5000);
+		sample.temperature = 20 + (rng() % 2000) / 100.0f;
+		sample.enabled = rng() & 1;
+	}
+
+	return samples;
+}
+
+//! Comma-separated text, the way payloads were formatted with snprintf().
+size_t encode_text(const telemetry_t &sample, uint8_t *frame) {
+	char text[64];
+	size_t length = snprintf(text, sizeof(text), "%ld,%d,%u,%.2f,%d",
+			long(sample.position), sample.velocity, sample.current_ma,
+			double(sample.temperature), sample.enabled);
+
+	return slip_encode(text, length, frame);
+}
+
+size_t encode_schema(const telemetry_t &sample, uint8_t *frame) {
+	Schema_Message<Motor_Telemetry> message;
+	message.set<Motor_Telemetry::position>(sample.position);
+	message.set<Motor_Telemetry::velocity>(sample.velocity);
+	message.set<Motor_Telemetry::current_ma>(sample.current_ma);
+	message.set<Motor_Telemetry::temperature>(sample.temperature);
+	message.set<Motor_Telemetry::enabled>(sample.enabled);
+
+	return slip_encode(message.get_data(), message.get_length(), frame);
+}
+
+//! Unescape a frame, as the receive ISR does, returning its length.
+size_t unescape(const uint8_t *frame, size_t length, char *payload) {
+	char *end = payload;
+	bool escaped = false;
+	slip_decode_span(frame, length, end, payload + FRAME_SIZE - 1, escaped);
+
+	return end - payload;
+}
+
+//! Parse the text back with strtol() and strtof(), summing the fields.
+double decode_text(const uint8_t *frame, size_t length) {
+	char payload[FRAME_SIZE];
+	payload[unescape(frame, length, payload)] = 0;
+
+	char *end;
+	double sum = strtol(payload, &end, 10);
+	sum += strtol(end + 1, &end, 10);
+	sum += strtoul(end + 1, &end, 10);
+	sum += strtof(end + 1, &end);
+	sum += strtol(end + 1, &end, 10);
+
+	return sum;
+}
+
+double decode_schema(const uint8_t *frame, size_t length) {
+	char payload[FRAME_SIZE];
+	Schema_View<Motor_Telemetry> view(payload, unescape(frame, length, payload));
+
+	return view.get<Motor_Telemetry::position>() + view.get<Motor_Telemetry::velocity>()
+			+ view.get<Motor_Telemetry::current_ma>() + view.get<Motor_Telemetry::temperature>()
+			+ view.get<Motor_Telemetry::enabled>();
+}
+
+/*! Format and escape a message, reporting the escaped bytes it takes
+ *  on the wire, without topic or framing. */
+template<size_t (*ENCODE)(const telemetry_t&, uint8_t*)>
+void BM_Encode(benchmark::State &state) {
+	std::vector<telemetry_t> samples = make_samples();
+	uint8_t frame[FRAME_SIZE];
+	size_t i = 0, bytes = 0;
+
+	for(auto _ : state) {
+		bytes += ENCODE(samples[i++ % SAMPLES], frame);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations());
+	state.counters["wire_bytes"] = double(bytes) / state.iterations();
+}
+
+//! Unescape and parse messages encoded beforehand.
+template<size_t (*ENCODE)(const telemetry_t&, uint8_t*), double (*DECODE)(const uint8_t*, size_t)>
+void BM_Decode(benchmark::State &state) {
+	std::vector<telemetry_t> samples = make_samples();
+	std::vector<uint8_t> frames(SAMPLES * FRAME_SIZE);
+	std::vector<size_t> lengths(SAMPLES);
+	for(size_t i = 0; i < SAMPLES; i++)
+		lengths[i] = ENCODE(samples[i], &frames[i * FRAME_SIZE]);
+
+	size_t i = 0;
+	for(auto _ : state) {
+		size_t sample = i++ % SAMPLES;
+		benchmark::DoNotOptimize(DECODE(&frames[sample * FRAME_SIZE], lengths[sample]));
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+}
+
+BENCHMARK_TEMPLATE(BM_Encode, encode_text);
+BENCHMARK_TEMPLATE(BM_Encode, encode_schema);
+
+BENCHMARK_TEMPLATE(BM_Decode, encode_text, decode_text);
+BENCHMARK_TEMPLATE(BM_Decode, encode_schema, decode_schema);
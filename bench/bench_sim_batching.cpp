@@ -0,0 +1,72 @@
+/*
+ * bench_sim_batching.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr int PACKETS = 1000;
+
+void count_payload(void *context, const char *topic, const void *data, size_t length) {
+	(void)topic;
+	(void)data;
+
+	*reinterpret_cast<uint64_t*>(context) += length;
+}
+
+/*! Two nodes flood a third with packets of the given payload length, with
+ *  batching on or off. Reports the payload bytes received per character
+ *  time the bus was busy, i.e. per byte on the wire. */
+void BM_Flood(benchmark::State &state) {
+	size_t length = state.range(0);
+	bool batching = state.range(1);
+
+	for(auto _ : state) {
+		Bus_Sim bus;
+		Sim_Node<> receiver(bus, 1);
+		Sim_Node<> first(bus, 2);
+		Sim_Node<> second(bus, 3);
+
+		uint64_t payload_bytes = 0;
+		receiver.subscribe("s/*", count_payload, &payload_bytes);
+		first.set_batching(batching);
+		second.set_batching(batching);
+
+		std::vector<char> payload(length, 'p');
+		for(int i = 0; i < PACKETS; i++) {
+			for(auto sender : {&first, &second}) {
+				while(!sender->send_packet("s/v", payload.data(), payload.size()))
+					bus.step();
+			}
+		}
+		bus.run_until_idle(10000000);
+
+		if(payload_bytes != 2 * PACKETS * length) {
+			state.SkipWithError("Packets were lost");
+			break;
+		}
+
+		state.counters["payload_per_char"] = double(payload_bytes) / bus.busy_steps;
+	}
+}
+
+//! Payloads of 4 to 48 bytes, as single frames and batched.
+void flood_args(benchmark::internal::Benchmark *b) {
+	b->ArgNames({"bytes", "batching"});
+	for(int length : {4, 16, 48})
+		for(int batching : {0, 1})
+			b->Args({length, batching});
+}
+
+}
+
+BENCHMARK(BM_Flood)->Apply(flood_args)->Iterations(1)->Unit(benchmark::kMillisecond);
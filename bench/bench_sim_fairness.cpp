@@ -0,0 +1,142 @@
+/*
+ * bench_sim_fairness.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <string.h>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr int NODES = 6;
+constexpr uint32_t SECONDS = 5;
+
+//! Queue time of every packet of one sender by sequence number, and its latency once received.
+struct sender_record_t {
+	std::vector<uint64_t> sent_step;
+	std::vector<bool> seen;
+	std::vector<double> latency_ms;
+};
+
+struct fairness_t {
+	Bus_Sim *bus;
+	sender_record_t senders[NODES];
+};
+
+void record_latency(void *context, const char *topic, const void *data, size_t length) {
+	auto fairness = reinterpret_cast<fairness_t*>(context);
+	auto bytes = reinterpret_cast<const uint8_t*>(data);
+	(void)topic;
+
+	uint32_t sequence;
+	if(length < 1 + sizeof(sequence) || bytes[0] >= NODES)
+		return;
+	memcpy(&sequence, bytes + 1, sizeof(sequence));
+
+	sender_record_t &sender = fairness->senders[bytes[0]];
+	if(sequence >= sender.sent_step.size() || sender.seen[sequence])
+		return;
+	sender.seen[sequence] = true;
+
+	uint64_t steps = fairness->bus->get_step() - sender.sent_step[sequence];
+	sender.latency_ms.push_back(steps * 10000.0 / fairness->bus->get_baudrate());
+}
+
+/*! Six nodes with chip IDs 1 to 1501 send short packets in one priority
+ *  class, each every gap_steps character times on average. Reports the
+ *  delivered frame rate, the Jain fairness index of the per-node
+ *  throughput, and the worst p99 latency of any node, in bus time. */
+void BM_Fairness(benchmark::State &state) {
+	uint32_t gap_steps = state.range(0);
+	uint8_t aging = state.range(1);
+
+	for(auto _ : state) {
+		Bus_Sim bus(250000, 1000);
+		std::unique_ptr<fairness_t> fairness(new fairness_t());
+		fairness->bus = &bus;
+
+		std::vector<std::unique_ptr<Sim_Node<>>> nodes;
+		for(int i = 0; i < NODES; i++) {
+			nodes.emplace_back(new Sim_Node<>(bus, 1 + i * 300, false, true));
+			nodes.back()->subscribe("fair/*", record_latency, fairness.get());
+			nodes.back()->set_priority_aging(aging);
+		}
+
+		uint32_t seed = 7;
+		auto random = [&seed]() {
+			seed = seed * 1103515245 + 12345;
+			return (seed >> 16) & 0x7FFF;
+		};
+
+		uint64_t next_send[NODES];
+		for(auto &next : next_send)
+			next = random() % gap_steps;
+
+		uint64_t end_step = uint64_t(bus.get_baudrate()) / 10 * SECONDS;
+		uint64_t offered = 0;
+
+		while(bus.get_step() < end_step) {
+			for(int i = 0; i < NODES; i++) {
+				if(bus.get_step() < next_send[i])
+					continue;
+
+				sender_record_t &sender = fairness->senders[i];
+				uint32_t sequence = sender.sent_step.size();
+
+				uint8_t payload[24] = {};
+				payload[0] = i;
+				memcpy(payload + 1, &sequence, sizeof(sequence));
+
+				if(nodes[i]->send_packet("fair/x", payload, 5 + random() % 19)) {
+					sender.sent_step.push_back(bus.get_step());
+					sender.seen.push_back(false);
+				}
+				offered++;
+
+				next_send[i] = bus.get_step() + gap_steps / 2 + random() % gap_steps;
+			}
+			bus.step();
+		}
+
+		double sum = 0, square_sum = 0, worst_p99 = 0;
+		uint64_t delivered = 0;
+		for(auto &sender : fairness->senders) {
+			std::vector<double> &sorted = sender.latency_ms;
+			std::sort(sorted.begin(), sorted.end());
+
+			double rate = double(sorted.size()) / SECONDS;
+			sum += rate;
+			square_sum += rate * rate;
+			delivered += sorted.size();
+
+			if(!sorted.empty())
+				worst_p99 = std::max(worst_p99, sorted[size_t(0.99 * (sorted.size() - 1))]);
+		}
+
+		state.counters["offered_per_s"] = double(offered) / SECONDS;
+		state.counters["delivered_per_s"] = double(delivered) / SECONDS;
+		state.counters["jain"] = (square_sum > 0) ? sum * sum / (NODES * square_sum) : 0;
+		state.counters["worst_p99_ms"] = worst_p99;
+	}
+}
+
+//! A bus loaded to about 85% and overloaded to about 130%, without and with aging.
+void load_args(benchmark::internal::Benchmark *b) {
+	b->ArgNames({"gap_steps", "aging"});
+	for(int gap : {300, 200})
+		for(int aging : {0, 8})
+			b->Args({gap, aging});
+}
+
+}
+
+BENCHMARK(BM_Fairness)->Apply(load_args)->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,125 @@
+/*
+ * bench_sim_latency.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_stats.h"
+
+#include <algorithm>
+#include <memory>
+#include <string.h>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr int NODES = 3;
+constexpr uint32_t PACKETS = 2000;
+
+//! Queue time of every packet by ID, and its latency once first received.
+struct latency_t {
+	Bus_Sim *bus;
+	std::vector<uint64_t> sent_step;
+	std::vector<bool> seen;
+	std::vector<double> latency_ms;
+};
+
+void record_latency(void *context, const char *topic, const void *data, size_t length) {
+	auto latency = reinterpret_cast<latency_t*>(context);
+	(void)topic;
+
+	uint32_t id;
+	if(length < sizeof(id))
+		return;
+	memcpy(&id, data, sizeof(id));
+
+	if(id >= latency->seen.size() || latency->seen[id])
+		return;
+	latency->seen[id] = true;
+
+	uint64_t steps = latency->bus->get_step() - latency->sent_step[id];
+	latency->latency_ms.push_back(steps * 10000.0 / latency->bus->get_baudrate());
+}
+
+/*! Three nodes send packets at random, with random gaps of up to the
+ *  given number of milliseconds in between, so packets often find the
+ *  bus busy and have to wait for it to go idle. Reports the simulated
+ *  time from queueing a packet until the first node received it.
+ *
+ *  With polling set, the nodes run the old 100 ms polling thread instead
+ *  of starting transmissions on events, see Sim_Node_Base::set_tx_polling().
+ *  On a clean bus, the STOP of the previous frame starts the next one, so
+ *  both behave the same. Losing every stop_loss-th STOP leaves the nodes
+ *  waiting for the bus to go idle, which the polling thread only notices
+ *  on its next wakeup. */
+void BM_FirstReception(benchmark::State &state) {
+	uint32_t max_gap_ms = state.range(0);
+	bool rx_timeout = state.range(1);
+	bool polling = state.range(2);
+	uint32_t stop_loss = state.range(3);
+
+	for(auto _ : state) {
+		Bus_Sim bus(250000, 1000);
+		bus.set_stop_loss(stop_loss);
+		latency_t latency = { &bus, {}, std::vector<bool>(PACKETS, false), {} };
+
+		std::vector<std::unique_ptr<Sim_Node<>>> nodes;
+		for(int i = 0; i < NODES; i++) {
+			nodes.emplace_back(new Sim_Node<>(bus, 1 + i, i == NODES - 1, rx_timeout));
+			nodes.back()->subscribe("lat/*", record_latency, &latency);
+			nodes.back()->set_tx_polling(polling);
+		}
+
+		uint32_t seed = 12345;
+		auto random = [&seed]() {
+			seed = seed * 1103515245 + 12345;
+			return (seed >> 16) & 0x7FFF;
+		};
+		uint64_t max_gap_steps = max_gap_ms * bus.get_baudrate() / 10 / 1000;
+
+		for(uint32_t id = 0; id < PACKETS; id++) {
+			bus.run(random() % max_gap_steps);
+
+			uint8_t payload[20] = {};
+			memcpy(payload, &id, sizeof(id));
+
+			latency.sent_step.push_back(bus.get_step());
+			nodes[random() % NODES]->send_packet("lat/x", payload, 4 + random() % 16);
+		}
+		bus.run_until_idle(10000000);
+
+		std::vector<double> &sorted = latency.latency_ms;
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum = 0;
+		for(double value : sorted)
+			sum += value;
+
+		state.counters["received"] = sorted.size();
+		state.counters["mean_ms"] = sorted.empty() ? 0 : sum / sorted.size();
+		state.counters["p50_ms"] = percentile(sorted, 0.5);
+		state.counters["p99_ms"] = percentile(sorted, 0.99);
+		state.counters["max_ms"] = percentile(sorted, 1);
+	}
+}
+
+//! Gaps of 6, 40 and 400 ms, with and without receiver timeout, polled
+//! and event-driven, on a clean bus and losing every 20th STOP.
+void gap_args(benchmark::internal::Benchmark *b) {
+	b->ArgNames({"max_gap_ms", "rx_timeout", "polling", "stop_loss"});
+	for(int stop_loss : {0, 20})
+		for(int gap : {6, 40, 400})
+			for(int rx_timeout : {0, 1})
+				for(int polling : {1, 0})
+					b->Args({gap, rx_timeout, polling, stop_loss});
+}
+
+}
+
+BENCHMARK(BM_FirstReception)->Apply(gap_args)->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,86 @@
+/*
+ * bench_sim_priority.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_stats.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+//! Queue time of every urgent packet by ID, and its latency once received.
+struct latency_t {
+	Bus_Sim *bus;
+	std::vector<uint64_t> sent_step;
+	std::vector<double> latency_ms;
+};
+
+void record_latency(void *context, const char *topic, const void *data, size_t length) {
+	auto latency = reinterpret_cast<latency_t*>(context);
+	(void)topic;
+
+	uint32_t id;
+	if(length < sizeof(id))
+		return;
+	memcpy(&id, data, sizeof(id));
+
+	uint64_t steps = latency->bus->get_step() - latency->sent_step.at(id);
+	latency->latency_ms.push_back(steps * 10000.0 / latency->bus->get_baudrate());
+}
+
+/*! One node keeps its bulk queue full and sends an urgent packet every
+ *  5 ms, either in the same class as the bulk data or in PRIO_URGENT.
+ *  Reports the simulated latency of the urgent packets, from the first
+ *  attempt to queue them until they were received. */
+void BM_UrgentBehindBulk(benchmark::State &state) {
+	tx_priority_t urgent_class = state.range(0) ? PRIO_URGENT : PRIO_BULK;
+
+	for(auto _ : state) {
+		Bus_Sim bus;
+		Sim_Node<> sender(bus, 1);
+		Sim_Node<> receiver(bus, 2);
+
+		latency_t latency = { &bus, {}, {} };
+		receiver.subscribe("urgent", record_latency, &latency);
+
+		char bulk[200];
+		memset(bulk, 'b', sizeof(bulk));
+		uint64_t steps_per_ms = bus.get_baudrate() / 10 / 1000;
+
+		for(uint32_t id = 0; id < 200; id++) {
+			for(uint64_t i = 0; i < 5 * steps_per_ms; i++) {
+				while(sender.send_packet("bulk", bulk, sizeof(bulk), PRIO_BULK)) {}
+				bus.step();
+			}
+
+			// Behind bulk data, the packet may have to wait for queue space.
+			latency.sent_step.push_back(bus.get_step());
+			while(!sender.send_packet("urgent", &id, sizeof(id), urgent_class))
+				bus.step();
+		}
+		bus.run(100 * steps_per_ms);
+
+		std::vector<double> &sorted = latency.latency_ms;
+		std::sort(sorted.begin(), sorted.end());
+
+		state.counters["received"] = sorted.size();
+		state.counters["p50_ms"] = percentile(sorted, 0.5);
+		state.counters["p99_ms"] = percentile(sorted, 0.99);
+		state.counters["max_ms"] = percentile(sorted, 1);
+	}
+}
+
+}
+
+BENCHMARK(BM_UrgentBehindBulk)->ArgName("urgent_class")->Arg(0)->Arg(1)
+		->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,131 @@
+/*
+ * bench_sim_rpc.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/RPC.h>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_stats.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr int CALLS = 400;
+
+uint8_t echo(void *context, const void *args, size_t length, rpc_reply_t &reply) {
+	(void)context;
+
+	memcpy(reply.data, args, length);
+	reply.length = length;
+	return RPC_OK;
+}
+
+struct round_trips_t;
+
+//! One outstanding call, passed as context to its completion handler.
+struct call_slot_t {
+	round_trips_t *round_trips;
+	uint64_t start_step;
+	bool busy;
+};
+
+struct round_trips_t {
+	Bus_Sim *bus;
+	std::vector<double> latency_chars;
+	int failed;
+};
+
+void record_reply(void *context, uint8_t status, const void *data, size_t length) {
+	auto slot = reinterpret_cast<call_slot_t*>(context);
+	(void)data;
+	(void)length;
+
+	round_trips_t &round_trips = *slot->round_trips;
+	if(status != RPC_OK)
+		round_trips.failed++;
+	else
+		round_trips.latency_chars.push_back(round_trips.bus->get_step() - slot->start_step);
+
+	slot->busy = false;
+}
+
+/*! A client keeps up to the given number of calls to a 4-byte echo
+ *  method outstanding, issuing the next as soon as one completes.
+ *  Reports the simulated time from call() until the completion handler
+ *  ran, in character times, and the calls completed per 1000 characters. */
+void BM_RoundTrip(benchmark::State &state) {
+	int window = state.range(0);
+	bool crc = state.range(1);
+
+	for(auto _ : state) {
+		Bus_Sim bus;
+		Sim_Node<> caller(bus, 1);
+		Sim_Node<> server(bus, 2);
+		caller.set_crc(crc);
+		server.set_crc(crc);
+
+		RPC_Client client(caller, 0x101);
+		RPC_Method method("svc/echo", echo);
+		if(!client.attach() || !method.attach(server)) {
+			state.SkipWithError("Could not attach");
+			break;
+		}
+		bus.run(300);
+
+		round_trips_t round_trips = { &bus, {}, 0 };
+		std::vector<call_slot_t> slots(window, call_slot_t{ &round_trips, 0, false });
+
+		uint64_t start_step = bus.get_step();
+		uint32_t issued = 0;
+		while(round_trips.latency_chars.size() + round_trips.failed < CALLS
+				&& bus.get_step() - start_step < 10000000) {
+			for(auto &slot : slots) {
+				if(slot.busy || issued >= CALLS)
+					continue;
+
+				slot.start_step = bus.get_step();
+				slot.busy = client.call("svc/echo", &issued, sizeof(issued), record_reply, &slot, 1000);
+				if(slot.busy)
+					issued++;
+			}
+
+			bus.step();
+		}
+		uint64_t steps = bus.get_step() - start_step;
+
+		std::vector<double> &sorted = round_trips.latency_chars;
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum = 0;
+		for(double value : sorted)
+			sum += value;
+
+		state.counters["completed"] = sorted.size();
+		state.counters["failed"] = round_trips.failed;
+		state.counters["mean_chars"] = sorted.empty() ? 0 : sum / sorted.size();
+		state.counters["p99_chars"] = percentile(sorted, 0.99);
+		state.counters["max_chars"] = percentile(sorted, 1);
+		state.counters["calls_per_kchar"] = sorted.size() * 1000.0 / steps;
+	}
+}
+
+//! Windows of 1, 4 and 8 outstanding calls, with and without CRC.
+void window_args(benchmark::internal::Benchmark *b) {
+	b->ArgNames({"window", "crc"});
+	for(int window : {1, 4, FURCOM_RPC_PENDING_NUM})
+		for(int crc : {0, 1})
+			b->Args({window, crc});
+}
+
+}
+
+BENCHMARK(BM_RoundTrip)->Apply(window_args)->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,64 @@
+/*
+ * bench_sim_rx.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr int RECEIVERS = 4;
+constexpr int FRAMES = 16;
+
+/*! Receive bursts of frames on idle nodes, per byte or through the
+ *  simulated RX DMA. The host time covers the whole simulation, so the
+ *  difference between both is what rx_span() saves over rx_byte(). */
+void BM_SimRX(benchmark::State &state) {
+	bool dma_rx = state.range(0);
+	size_t length = state.range(1);
+
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	std::vector<std::unique_ptr<Sim_Node<>>> receivers;
+	for(int i = 0; i < RECEIVERS; i++)
+		receivers.emplace_back(new Sim_Node<>(bus, 2 + i, false, false, dma_rx));
+
+	std::vector<char> payload(length, 'p');
+	uint64_t start_step = bus.get_step();
+
+	for(auto _ : state) {
+		// Waiting for queue space keeps the simulation running meanwhile.
+		for(int i = 0; i < FRAMES; i++)
+			sender.send_packet_wait("bench/rx", payload.data(), payload.size(), 1000);
+
+		if(!bus.run_until_idle(1000000)) {
+			state.SkipWithError("Bus did not go idle");
+			break;
+		}
+	}
+
+	uint64_t frames = 0, dma_bytes = 0;
+	for(auto &receiver : receivers) {
+		frames += receiver->rx_frames;
+		dma_bytes += receiver->rx_dma_bytes;
+	}
+
+	state.SetItemsProcessed(frames);
+	state.counters["bus_bytes"] = benchmark::Counter(bus.get_step() - start_step,
+			benchmark::Counter::kIsRate);
+	state.counters["dma_share"] = double(dma_bytes) / (RECEIVERS * (bus.get_step() - start_step));
+}
+
+}
+
+BENCHMARK(BM_SimRX)->ArgNames({"dma_rx", "bytes"})
+		->Args({0, 16})->Args({1, 16})
+		->Args({0, 200})->Args({1, 200});
@@ -0,0 +1,20 @@
+/*!
+ * \file bench_stats.h
+ * \date 16.10.2026
+ * \version 1.0
+ *
+ * \copyright GNU Public License v3
+ */
+
+#ifndef FURCOMS_BENCH_STATS_H_
+#define FURCOMS_BENCH_STATS_H_
+
+#include <stddef.h>
+#include <vector>
+
+//! Return the q-quantile of sorted values, q = 1 being the maximum. 0 if empty.
+inline double percentile(const std::vector<double> &sorted, double q) {
+	return sorted.empty() ? 0 : sorted[size_t(q * (sorted.size() - 1))];
+}
+
+#endif /* FURCOMS_BENCH_STATS_H_ */
@@ -0,0 +1,95 @@
+/*
+ * batching_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr int SENDERS = 2;
+constexpr uint32_t PACKETS = 500;
+
+struct received_t {
+	uint64_t payload_bytes;
+	uint32_t next[SENDERS];
+	int bad_packets;
+};
+
+//! Payload is the sender and its sequence number.
+void check_packet(void *context, const char *topic, const void *data, size_t length) {
+	auto received = reinterpret_cast<received_t*>(context);
+	(void)topic;
+
+	uint8_t sender;
+	uint32_t sequence;
+	if(length != 1 + sizeof(sequence)) {
+		received->bad_packets++;
+		return;
+	}
+	memcpy(&sender, data, 1);
+	memcpy(&sequence, reinterpret_cast<const uint8_t*>(data) + 1, sizeof(sequence));
+
+	if(sender >= SENDERS || sequence != received->next[sender])
+		received->bad_packets++;
+	else
+		received->next[sender]++;
+
+	received->payload_bytes += length;
+}
+
+/*! Two nodes flood a third with 5-byte packets. Returns payload bytes
+ *  received per character time the bus was busy. */
+double run_flood(bool batching, bool use_dma, received_t &received) {
+	Bus_Sim bus;
+	Sim_Node<> receiver(bus, 1);
+	Sim_Node<> senders[SENDERS] = { {bus, 2, use_dma}, {bus, 3, use_dma} };
+
+	received = {};
+	EXPECT_TRUE(receiver.subscribe("s/*", check_packet, &received));
+	for(auto &sender : senders)
+		sender.set_batching(batching);
+
+	for(uint32_t sequence = 0; sequence < PACKETS; sequence++) {
+		for(uint8_t s = 0; s < SENDERS; s++) {
+			uint8_t payload[5] = { s };
+			memcpy(payload + 1, &sequence, sizeof(sequence));
+
+			while(!senders[s].send_packet("s/v", payload, sizeof(payload)))
+				bus.step();
+		}
+	}
+	EXPECT_TRUE(bus.run_until_idle(1000000));
+
+	return double(received.payload_bytes) / bus.busy_steps;
+}
+
+} /* namespace */
+
+TEST(Batching, RaisesGoodputOfSmallPackets) {
+	for(bool use_dma : {false, true}) {
+		received_t single, batched;
+		double single_goodput = run_flood(false, use_dma, single);
+		double batched_goodput = run_flood(true, use_dma, batched);
+
+		for(auto received : {&single, &batched}) {
+			EXPECT_EQ(received->bad_packets, 0) << use_dma;
+			EXPECT_EQ(received->next[0], PACKETS) << use_dma;
+			EXPECT_EQ(received->next[1], PACKETS) << use_dma;
+		}
+
+		// Most of a single small frame is START, arbitration and STOP.
+		EXPECT_GT(batched_goodput, 1.3 * single_goodput) << use_dma;
+
+		std::string suffix = use_dma ? "_dma" : "";
+		RecordProperty("payload_per_char" + suffix, std::to_string(single_goodput));
+		RecordProperty("batched_payload_per_char" + suffix, std::to_string(batched_goodput));
+	}
+}
@@ -0,0 +1,168 @@
+/*
+ * bus_stats_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/BusTrace.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace TEF::FurComs;
+
+TEST(BusStats, CountTraffic) {
+	Bus_Sim bus(250000, 1000);
+	Sim_Node<> a(bus, 1, false, true);
+	Sim_Node<> b(bus, 2, false, true);
+	Sim_Node<> c(bus, 3, true, true);
+
+	// Every fifth byte needs an escape.
+	uint8_t payload[40];
+	for(int i = 0; i < 40; i++)
+		payload[i] = (i % 5 == 0) ? 0 : i;
+
+	for(int round = 0; round < 200; round++) {
+		ASSERT_TRUE(a.send_packet("t/a", payload, 20));
+		ASSERT_TRUE(b.send_packet("t/b", payload, 30));
+		if(round % 3 == 0) {
+			ASSERT_TRUE(c.send_packet("t/c", payload, 10, PRIO_HIGH));
+		}
+		bus.run(300);
+	}
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	bus_stats_t stats = a.get_stats();
+	EXPECT_EQ(stats.frames_sent, 200u);
+	EXPECT_EQ(stats.packets_sent, 200u);
+	EXPECT_EQ(stats.frames_received, 200u + 67u);
+	EXPECT_EQ(stats.rx_overruns, 0u);
+	EXPECT_EQ(stats.rx_truncated, 0u);
+
+	EXPECT_GE(stats.arbitration_attempts, stats.frames_sent);
+	EXPECT_GT(stats.arbitration_losses, 0u);
+	uint32_t losses = 0;
+	for(uint32_t count : stats.arbitration_loss_positions)
+		losses += count;
+	EXPECT_EQ(losses, stats.arbitration_losses);
+
+	// Escapes make the wire longer than the data.
+	EXPECT_GT(stats.rx_decoded_bytes, 0u);
+	EXPECT_GT(stats.rx_encoded_bytes, stats.rx_decoded_bytes);
+
+	EXPECT_GT(stats.tx_queue_high_water[PRIO_NORMAL], 0u);
+	EXPECT_EQ(stats.tx_queue_high_water[PRIO_URGENT], 0u);
+	EXPECT_GT(c.get_stats().tx_queue_high_water[PRIO_HIGH], 0u);
+
+	// The state times add up to the time the node ran.
+	uint64_t total_time = 0;
+	for(uint64_t time : stats.state_time)
+		total_time += time;
+	double seconds = double(total_time) / stats.clock_rate;
+	double bus_seconds = double(bus.get_step()) * 10 / bus.get_baudrate();
+	EXPECT_NEAR(seconds, bus_seconds, 0.001);
+	EXPECT_GT(stats.state_time[SENDING], 0u);
+	EXPECT_GT(stats.state_time[RECEIVING], 0u);
+
+	a.reset_stats();
+	stats = a.get_stats();
+	EXPECT_EQ(stats.frames_sent, 0u);
+	EXPECT_EQ(stats.frames_received, 0u);
+	EXPECT_EQ(stats.arbitration_losses, 0u);
+	EXPECT_EQ(stats.tx_queue_high_water[PRIO_NORMAL], 0u);
+}
+
+TEST(BusTrace, RecordsStateChanges) {
+	Bus_Sim bus;
+	Sim_Node<> a(bus, 1);
+	Sim_Node<> b(bus, 2);
+
+	Trace_Ring ring;
+	a.set_trace(&ring);
+
+	ASSERT_TRUE(a.send_packet("t/a", "data", 4));
+	ASSERT_TRUE(b.send_packet("t/b", "data", 4));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	uint32_t cursor = 0, lost = 0;
+	trace_entry_t entries[FURCOM_TRACE_SIZE];
+	size_t count = ring.read(cursor, entries, FURCOM_TRACE_SIZE, &lost);
+	ASSERT_GT(count, 2u);
+	EXPECT_EQ(lost, 0u);
+	EXPECT_EQ(cursor, ring.get_write_seq());
+
+	// One chain of transitions, from IDLE back to IDLE.
+	EXPECT_EQ(entries[0].from_state, IDLE);
+	EXPECT_EQ(entries[count - 1].to_state, IDLE);
+	for(size_t i = 1; i < count; i++) {
+		EXPECT_EQ(entries[i].from_state, entries[i - 1].to_state) << i;
+		EXPECT_GE(entries[i].timestamp, entries[i - 1].timestamp) << i;
+	}
+
+	// Nothing new, nothing read.
+	EXPECT_EQ(ring.read(cursor, entries, FURCOM_TRACE_SIZE, &lost), 0u);
+
+	a.set_trace(nullptr);
+	ASSERT_TRUE(a.send_packet("t/a", "data", 4));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+	EXPECT_EQ(ring.get_write_seq(), cursor);
+}
+
+TEST(BusTrace, OverwrittenEntriesAreLost) {
+	Trace_Ring ring;
+	for(uint32_t i = 0; i < FURCOM_TRACE_SIZE + 10; i++)
+		ring.record(i, i & 0xFF, (i + 1) & 0xFF, 0);
+
+	uint32_t cursor = 0, lost = 0;
+	trace_entry_t entries[FURCOM_TRACE_SIZE];
+	size_t count = ring.read(cursor, entries, FURCOM_TRACE_SIZE, &lost);
+
+	// The oldest slot is the next to be written, so it counts as lost too.
+	EXPECT_EQ(lost, 11u);
+	ASSERT_EQ(count, size_t(FURCOM_TRACE_SIZE - 1));
+	EXPECT_EQ(entries[0].timestamp, 11u);
+	EXPECT_EQ(entries[count - 1].timestamp, FURCOM_TRACE_SIZE + 9u);
+}
+
+TEST(BusTrace, ReaderFollowsWriter) {
+	constexpr uint32_t ENTRIES = 200000;
+	Trace_Ring ring;
+	std::atomic<bool> done(false);
+
+	// Stands in for the ISR, the timestamp is the sequence number.
+	std::thread writer([&] {
+		for(uint32_t i = 0; i < ENTRIES; i++)
+			ring.record(i, i & 0xFF, (i + 1) & 0xFF, i % 25);
+		done = true;
+	});
+
+	uint32_t cursor = 0, lost = 0, next = 0;
+	int errors = 0;
+	trace_entry_t entries[16];
+	while(next < ENTRIES) {
+		uint32_t lost_before = lost;
+		size_t count = ring.read(cursor, entries, 16, &lost);
+		if(count == 0) {
+			if(done && cursor == ENTRIES)
+				break;
+			std::this_thread::yield();
+			continue;
+		}
+
+		next += lost - lost_before;
+		for(size_t i = 0; i < count; i++, next++) {
+			const trace_entry_t &entry = entries[i];
+			if(entry.timestamp != next || entry.from_state != (next & 0xFF)
+					|| entry.to_state != ((next + 1) & 0xFF) || entry.detail != next % 25)
+				errors++;
+		}
+	}
+	writer.join();
+
+	EXPECT_EQ(errors, 0);
+	EXPECT_EQ(next, ENTRIES);
+	EXPECT_EQ(cursor, ENTRIES);
+}
@@ -0,0 +1,58 @@
+/*
+ * flush_tx_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <gtest/gtest.h>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+void count_done(void *context, bool sent) {
+	auto counts = reinterpret_cast<int*>(context);
+	counts[sent ? 1 : 0]++;
+}
+
+//! Bus steps to send the given number of packets, flushing all but the first while it is sent.
+uint64_t run_flushed(int packets, int *counts, int &dropped) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+
+	for(int i = 0; i < packets; i++)
+		EXPECT_TRUE(sender.send_packet("t", "data", 4, PRIO_NORMAL, count_done, counts));
+
+	for(int i = 0; i < 10000 && sender.get_state() != SENDING; i++)
+		bus.run(1);
+	EXPECT_EQ(sender.get_state(), SENDING);
+
+	dropped = sender.flush_tx(PRIO_NORMAL);
+	EXPECT_TRUE(bus.run_until_idle(100000));
+
+	EXPECT_EQ(sender.get_stats().frames_sent, 1u);
+	EXPECT_EQ(sender.get_stats().arbitration_attempts, 1u);
+
+	return bus.busy_steps;
+}
+
+} /* namespace */
+
+TEST(FlushTX, DroppedFramesDoNotStartArbitration) {
+	int single[2] = {};
+	int dropped = 0;
+	uint64_t single_steps = run_flushed(1, single, dropped);
+	EXPECT_EQ(dropped, 0);
+
+	int counts[2] = {};
+	uint64_t flushed_steps = run_flushed(4, counts, dropped);
+	EXPECT_EQ(dropped, 3);
+	EXPECT_EQ(counts[0], 3);
+	EXPECT_EQ(counts[1], 1);
+
+	// No START for frames that are gone.
+	EXPECT_EQ(flushed_steps, single_steps);
+}
@@ -0,0 +1,250 @@
+/*
+ * fragments_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/Fragments.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+std::string make_message(size_t length) {
+	std::string message(length, '\0');
+	for(size_t i = 0; i < length; i++)
+		message[i] = char((i * 131 + (i >> 8)) & 0xFF);
+
+	return message;
+}
+
+//! Collects what a Fragment_Receiver hands out.
+struct collector_t {
+	std::vector<char> buffer;
+	std::vector<std::string> messages;
+
+	std::string streamed;
+	bool stream_in_order = true;
+	int last_fragments = 0;
+
+	collector_t() : buffer(20000) {}
+
+	void attach(Fragment_Receiver &receiver) {
+		receiver.set_buffer(buffer.data(), buffer.size(), on_message, this);
+		receiver.set_fragment_handler(on_fragment, this);
+	}
+
+	static void on_message(void *context, const char *topic, const void *data, size_t length) {
+		(void)topic;
+		auto self = reinterpret_cast<collector_t*>(context);
+
+		self->messages.emplace_back(reinterpret_cast<const char*>(data), length);
+	}
+
+	static void on_fragment(void *context, const char *topic, size_t offset,
+			const void *data, size_t length, bool last) {
+		(void)topic;
+		auto self = reinterpret_cast<collector_t*>(context);
+
+		if(offset == 0)
+			self->streamed.clear();
+		if(offset != self->streamed.size())
+			self->stream_in_order = false;
+
+		self->streamed.append(reinterpret_cast<const char*>(data), length);
+		if(last)
+			self->last_fragments++;
+	}
+};
+
+}
+
+class Fragments : public ::testing::TestWithParam<bool> {
+};
+
+TEST_P(Fragments, ReassemblesLongMessage) {
+	Bus_Sim bus;
+	Sim_Node<4, 256, 2048> sender(bus, 1);
+	Sim_Node<4, 256, 2048> receiver(bus, 2);
+	sender.set_crc(GetParam());
+
+	Fragment_Receiver fragment_receiver("anim");
+	collector_t collector;
+	collector.attach(fragment_receiver);
+	receiver.add_fragment_receiver(fragment_receiver);
+
+	std::string message = make_message(3000);
+
+	Fragment_Sender fragment_sender(sender, "anim");
+	ASSERT_TRUE(fragment_sender.send(message.data(), message.size()));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+	EXPECT_FALSE(fragment_sender.is_busy());
+
+	ASSERT_EQ(collector.messages.size(), 1u);
+	EXPECT_EQ(collector.messages[0], message);
+	EXPECT_EQ(collector.streamed, message);
+	EXPECT_TRUE(collector.stream_in_order);
+	EXPECT_EQ(collector.last_fragments, 1);
+
+	EXPECT_EQ(fragment_receiver.get_completed(), 1u);
+	EXPECT_EQ(fragment_receiver.get_dropped(), 0u);
+
+	bus_stats_t stats;
+	receiver.get_stats(stats);
+	EXPECT_EQ(stats.rx_truncated, 0u);
+	EXPECT_EQ(stats.rx_crc_errors, 0u);
+}
+
+TEST_P(Fragments, ReassemblesStreamedMessage) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+	sender.set_crc(GetParam());
+
+	Fragment_Receiver fragment_receiver("anim");
+	collector_t collector;
+	collector.attach(fragment_receiver);
+	receiver.add_fragment_receiver(fragment_receiver);
+
+	std::string message = make_message(8000);
+
+	Fragment_Sender fragment_sender(sender, "anim");
+	fragment_sender.begin();
+	ASSERT_TRUE(fragment_sender.write_wait(message.data(), 5000, false, 1000));
+	ASSERT_TRUE(fragment_sender.write_wait(message.data() + 5000, 3000, true, 1000));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	ASSERT_EQ(collector.messages.size(), 1u);
+	EXPECT_EQ(collector.messages[0], message);
+	EXPECT_EQ(fragment_receiver.get_dropped(), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(CRC, Fragments, ::testing::Bool());
+
+TEST(Fragments, ShortFragmentsDoNotComplete) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	// Cuts off every full-size fragment of the sender.
+	Sim_Node<4, 128> receiver(bus, 2);
+
+	Fragment_Receiver fragment_receiver("anim");
+	collector_t collector;
+	collector.attach(fragment_receiver);
+	receiver.add_fragment_receiver(fragment_receiver);
+
+	std::string message = make_message(3000);
+
+	Fragment_Sender fragment_sender(sender, "anim");
+	ASSERT_TRUE(fragment_sender.send(message.data(), message.size()));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	EXPECT_TRUE(collector.messages.empty());
+	EXPECT_EQ(collector.last_fragments, 0);
+	EXPECT_EQ(fragment_receiver.get_completed(), 0u);
+	EXPECT_EQ(fragment_receiver.get_dropped(), 1u);
+
+	// Messages that fit the receiver's frames still arrive.
+	std::string small = make_message(100);
+	ASSERT_TRUE(fragment_sender.send(small.data(), small.size()));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	ASSERT_EQ(collector.messages.size(), 1u);
+	EXPECT_EQ(collector.messages[0], small);
+}
+
+TEST(Fragments, MissingFragmentDropsMessage) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+
+	Fragment_Receiver fragment_receiver("anim");
+	collector_t collector;
+	collector.attach(fragment_receiver);
+	receiver.add_fragment_receiver(fragment_receiver);
+
+	std::string message = make_message(3000);
+
+	// Start a message, then begin the next before the first one ended.
+	Fragment_Sender fragment_sender(sender, "anim");
+	fragment_sender.begin();
+	ASSERT_TRUE(fragment_sender.write_wait(message.data(), 1000, false, 1000));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	ASSERT_TRUE(fragment_sender.send(message.data(), message.size()));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	ASSERT_EQ(collector.messages.size(), 1u);
+	EXPECT_EQ(collector.messages[0], message);
+	EXPECT_EQ(fragment_receiver.get_dropped(), 1u);
+}
+
+TEST(Fragments, BufferInstalledMidMessageDropsIt) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+
+	// Streams only, until the buffer is installed.
+	Fragment_Receiver fragment_receiver("anim");
+	collector_t collector;
+	fragment_receiver.set_fragment_handler(collector_t::on_fragment, &collector);
+	receiver.add_fragment_receiver(fragment_receiver);
+
+	std::string message = make_message(3000);
+
+	Fragment_Sender fragment_sender(sender, "anim");
+	fragment_sender.begin();
+	ASSERT_TRUE(fragment_sender.write_wait(message.data(), 1000, false, 1000));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	// Smaller than what has already arrived.
+	std::vector<char> small_buffer(256);
+	fragment_receiver.set_buffer(small_buffer.data(), small_buffer.size(),
+			collector_t::on_message, &collector);
+
+	ASSERT_TRUE(fragment_sender.write_wait(message.data() + 1000, 2000, true, 1000));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	EXPECT_TRUE(collector.messages.empty());
+	EXPECT_EQ(fragment_receiver.get_completed(), 0u);
+	EXPECT_EQ(fragment_receiver.get_dropped(), 1u);
+}
+
+TEST(Fragments, LastFragmentWithoutLengthDropsMessage) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+
+	Fragment_Receiver fragment_receiver("anim");
+	collector_t collector;
+	collector.attach(fragment_receiver);
+	receiver.add_fragment_receiver(fragment_receiver);
+
+	std::string message = make_message(3000);
+
+	Fragment_Sender fragment_sender(sender, "anim");
+	fragment_sender.begin();
+	ASSERT_TRUE(fragment_sender.write_wait(message.data(), 1000, false, 1000));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	// Fragment header of the last fragment, sequence 1, spelled out in
+	// front of the topic, followed by two bytes instead of the length.
+	const char *header_topic = "\x05\x07\x01\x80" "anim";
+	ASSERT_TRUE(sender.send_packet(header_topic, "ab", 2));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	EXPECT_EQ(fragment_receiver.get_dropped(), 1u);
+
+	// The rest of the message no longer continues it.
+	ASSERT_TRUE(fragment_sender.write_wait(message.data() + 1000, 2000, true, 1000));
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	EXPECT_TRUE(collector.messages.empty());
+	EXPECT_EQ(fragment_receiver.get_completed(), 0u);
+	EXPECT_EQ(fragment_receiver.get_dropped(), 1u);
+}
@@ -0,0 +1,126 @@
+/*
+ * frame_length_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+void store_payload(void *context, const char *topic, const void *data, size_t length) {
+	(void)topic;
+	auto received = reinterpret_cast<std::vector<std::string>*>(context);
+
+	received->emplace_back(reinterpret_cast<const char*>(data), length);
+}
+
+//! Payload of the given length, with escaped bytes in it.
+std::string make_payload(size_t length) {
+	std::string payload(length, 'x');
+	for(size_t i = 0; i < length; i += 7)
+		payload[i] = char(i % 3 == 0 ? FURCOM_END : FURCOM_ESCAPE);
+
+	return payload;
+}
+
+}
+
+class FrameLength : public ::testing::TestWithParam<bool> {
+};
+
+TEST_P(FrameLength, LongestPacketArrivesIntact) {
+	bool with_crc = GetParam();
+
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+
+	std::vector<std::string> received;
+	receiver.subscribe("t", store_payload, &received);
+	sender.set_crc(with_crc);
+
+	// Topic "t" and its separator take two bytes of the frame.
+	size_t longest = FURCOM_MAX_PACKET_LENGTH - 2 - (with_crc ? FURCOM_CRC_OVERHEAD : 0);
+	std::string payload = make_payload(longest);
+
+	EXPECT_FALSE(sender.send_packet("t", payload.data(), longest + 1));
+	ASSERT_TRUE(sender.send_packet("t", payload.data(), longest));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	ASSERT_EQ(received.size(), 1u);
+	EXPECT_EQ(received[0], payload);
+
+	bus_stats_t stats = receiver.get_stats();
+	EXPECT_EQ(stats.rx_truncated, 0u);
+	EXPECT_EQ(stats.rx_crc_errors, 0u);
+}
+
+TEST_P(FrameLength, LongestFrameArrivesIntact) {
+	bool with_crc = GetParam();
+
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+
+	std::vector<std::string> received;
+	receiver.subscribe("t", store_payload, &received);
+
+	// send_frame() takes frames as they are, CRC included.
+	std::string frame = "t" + std::string(1, '\0') + make_payload(FURCOM_MAX_PACKET_LENGTH - 2);
+	if(with_crc) {
+		frame.resize(FURCOM_MAX_PACKET_LENGTH - FURCOM_CRC_OVERHEAD);
+		frame.insert(0, 1, char(FURCOM_MARKER_CRC));
+
+		uint8_t trailer[FURCOM_CRC_LENGTH];
+		crc_write_trailer(crc_compute(frame.data() + 1, frame.size() - 1), trailer);
+		frame.append(reinterpret_cast<char*>(trailer), FURCOM_CRC_LENGTH);
+	}
+	ASSERT_EQ(frame.size(), size_t(FURCOM_MAX_PACKET_LENGTH));
+
+	EXPECT_FALSE(sender.send_frame("x", 1, frame.data(), frame.size()));
+	ASSERT_TRUE(sender.send_frame(nullptr, 0, frame.data(), frame.size()));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	ASSERT_EQ(received.size(), 1u);
+	size_t payload_start = with_crc ? 3 : 2;
+	size_t payload_length = frame.size() - payload_start - (with_crc ? FURCOM_CRC_LENGTH : 0);
+	EXPECT_EQ(received[0], frame.substr(payload_start, payload_length));
+
+	bus_stats_t stats = receiver.get_stats();
+	EXPECT_EQ(stats.rx_truncated, 0u);
+	EXPECT_EQ(stats.rx_crc_errors, 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(CRC, FrameLength, ::testing::Bool());
+
+TEST(FrameLength, ShortReceiverCutsOffLongerFrames) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<4, 64> receiver(bus, 2);
+
+	std::vector<std::string> received;
+	receiver.subscribe("t", store_payload, &received);
+
+	// Exactly fills the receiver's frames, then one byte more.
+	std::string payload = make_payload(63);
+	ASSERT_TRUE(sender.send_packet("t", payload.data(), 62));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+	ASSERT_TRUE(sender.send_packet("t", payload.data(), 63));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	ASSERT_EQ(received.size(), 2u);
+	EXPECT_EQ(received[0], payload.substr(0, 62));
+	EXPECT_EQ(received[1], payload.substr(0, 62));
+
+	bus_stats_t stats = receiver.get_stats();
+	EXPECT_EQ(stats.rx_truncated, 1u);
+	EXPECT_EQ(stats.frames_received, 2u);
+}
@@ -0,0 +1,188 @@
+/*
+ * fuzz_slip.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/Codec.h>
+#include <FurComs/SLIP.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+typedef std::vector<uint8_t> bytes_t;
+typedef size_t (*decode_fn_t)(const uint8_t*, size_t, char*&, const char*, bool&);
+
+//! Byte at a time encoder, the way the firmware originally sent.
+bytes_t reference_encode(const bytes_t &raw) {
+	bytes_t out;
+
+	for(uint8_t c : raw) {
+		if(c == FURCOM_END || c == FURCOM_ESCAPE) {
+			out.push_back(FURCOM_ESCAPE);
+			out.push_back(c == FURCOM_END ? FURCOM_ESC_END : FURCOM_ESC_ESC);
+		}
+		else
+			out.push_back(c);
+	}
+
+	return out;
+}
+
+/*! Byte at a time decoder, the way the firmware originally received.
+ *  Splits the stream into frames at every FURCOM_END, each truncated
+ *  to capacity bytes. */
+std::vector<std::string> reference_decode(const bytes_t &stream, size_t capacity) {
+	std::vector<std::string> frames(1);
+	bool had_escape = false;
+
+	for(uint8_t c : stream) {
+		std::string &frame = frames.back();
+
+		if(c == FURCOM_END) {
+			frames.emplace_back();
+			had_escape = false;
+		}
+		else if(frame.size() >= capacity)
+			continue;
+		else if(had_escape) {
+			if(c == FURCOM_ESC_END)
+				frame.push_back(char(FURCOM_END));
+			else if(c == FURCOM_ESC_ESC)
+				frame.push_back(char(FURCOM_ESCAPE));
+			had_escape = false;
+		}
+		else if(c == FURCOM_ESCAPE)
+			had_escape = true;
+		else
+			frame.push_back(char(c));
+	}
+
+	return frames;
+}
+
+//! Same as reference_decode(), but with a span decoder fed random chunks.
+std::vector<std::string> span_decode(decode_fn_t decode, const bytes_t &stream,
+		size_t capacity, std::mt19937 &rng) {
+	std::vector<std::string> frames;
+	std::vector<char> buffer(capacity);
+	char *dst = buffer.data();
+	bool had_escape = false;
+
+	size_t pos = 0;
+	while(pos < stream.size()) {
+		size_t chunk = std::min<size_t>(rng() % 64 + 1, stream.size() - pos);
+		size_t consumed = decode(stream.data() + pos, chunk, dst, buffer.data() + capacity, had_escape);
+		pos += consumed;
+
+		if(consumed < chunk) {
+			EXPECT_EQ(stream[pos], FURCOM_END);
+
+			frames.emplace_back(buffer.data(), dst);
+			dst = buffer.data();
+			had_escape = false;
+			pos++;
+		}
+	}
+	frames.emplace_back(buffer.data(), dst);
+
+	return frames;
+}
+
+/*! Random data of one of several flavours: all specials, dense specials
+ *  and escape sequences, text, or uniform noise. */
+bytes_t fuzz_data(std::mt19937 &rng, size_t length) {
+	static const uint8_t specials[] = { FURCOM_END, FURCOM_ESCAPE, FURCOM_ESC_END, FURCOM_ESC_ESC };
+
+	bytes_t data(length);
+	int flavour = rng() % 4;
+
+	for(auto &c : data) {
+		unsigned r = rng() % 100;
+
+		switch(flavour) {
+		case 0: c = specials[r % 2]; break;
+		case 1: c = (r < 20) ? specials[r % 4] : rng(); break;
+		case 2: c = 'a' + r % 26; break;
+		default: c = rng(); break;
+		}
+	}
+
+	return data;
+}
+
+}
+
+TEST(FuzzSLIP, FindSpecialMatchesScalar) {
+	std::mt19937 rng(1);
+
+	for(int i = 0; i < 20000; i++) {
+		bytes_t data = fuzz_data(rng, rng() % 300);
+
+		size_t expected = data.size();
+		for(size_t j = 0; j < data.size(); j++) {
+			if(data[j] == FURCOM_END || data[j] == FURCOM_ESCAPE) {
+				expected = j;
+				break;
+			}
+		}
+
+		ASSERT_EQ(codec_find_special(data.data(), data.size()), expected);
+	}
+}
+
+TEST(FuzzSLIP, EncodersMatchReference) {
+	std::mt19937 rng(2);
+
+	for(int i = 0; i < 20000; i++) {
+		bytes_t data = fuzz_data(rng, rng() % 300);
+		bytes_t expected = reference_encode(data);
+
+		bytes_t slip(2 * data.size());
+		slip.resize(slip_encode(data.data(), data.size(), slip.data()));
+		ASSERT_EQ(slip, expected);
+
+		bytes_t codec(2 * data.size());
+		codec.resize(codec_encode(data.data(), data.size(), codec.data()));
+		ASSERT_EQ(codec, expected);
+
+		ASSERT_EQ(slip_encoded_length(data.data(), data.size()), expected.size());
+		ASSERT_EQ(slip_decoded_length(expected.data(), expected.size()), data.size());
+	}
+}
+
+TEST(FuzzSLIP, DecodersMatchReference) {
+	std::mt19937 rng(3);
+
+	for(int i = 0; i < 20000; i++) {
+		// Arbitrary streams, including invalid escapes and several frames.
+		bytes_t stream = fuzz_data(rng, rng() % 600);
+		size_t capacity = rng() % 300 + 1;
+
+		auto expected = reference_decode(stream, capacity);
+		ASSERT_EQ(span_decode(slip_decode_span, stream, capacity, rng), expected);
+		ASSERT_EQ(span_decode(codec_decode, stream, capacity, rng), expected);
+	}
+}
+
+TEST(FuzzSLIP, RoundTrip) {
+	std::mt19937 rng(4);
+
+	for(int i = 0; i < 5000; i++) {
+		bytes_t data = fuzz_data(rng, rng() % 2000);
+
+		bytes_t encoded(2 * data.size());
+		encoded.resize(codec_encode(data.data(), data.size(), encoded.data()));
+
+		auto frames = span_decode(codec_decode, encoded, data.size() + 1, rng);
+		ASSERT_EQ(frames.size(), 1u);
+		ASSERT_EQ(frames[0], std::string(data.begin(), data.end()));
+	}
+}
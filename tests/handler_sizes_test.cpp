@@ -0,0 +1,155 @@
+/*
+ * handler_sizes_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+template<int RX_BUFFER_NUM, size_t FRAME_LENGTH, uint32_t TX_QUEUE_SIZE>
+struct handler_sizes_t {
+	static constexpr int RX_BUFFERS = RX_BUFFER_NUM;
+	//! Longest payload on topic "t", whose separator takes another byte.
+	static constexpr size_t LONGEST = FRAME_LENGTH - 2;
+
+	typedef Sim_Node<RX_BUFFER_NUM, FRAME_LENGTH, TX_QUEUE_SIZE> node_t;
+};
+
+//! A single RX buffer and a TX queue of about one frame, up to a gateway.
+typedef handler_sizes_t<1, 32, 64> Tiny_Sizes;
+typedef handler_sizes_t<2, 64, 128> Small_Sizes;
+typedef handler_sizes_t<8, 256, 2048> Large_Sizes;
+
+void store_payload(void *context, const char *topic, const void *data, size_t length) {
+	(void)topic;
+	auto received = reinterpret_cast<std::vector<std::string>*>(context);
+
+	received->emplace_back(reinterpret_cast<const char*>(data), length);
+}
+
+struct loaner_t {
+	Protocol_Core *node;
+	std::vector<rx_loan_t> loans;
+	int received;
+};
+
+//! Loan every received payload, and keep the loan.
+void loan_payload(void *context, const char *topic, const void *data, size_t length) {
+	(void)topic;
+	auto loaner = reinterpret_cast<loaner_t*>(context);
+
+	loaner->received++;
+
+	rx_loan_t loan;
+	if(loaner->node->loan_rx(data, length, loan))
+		loaner->loans.push_back(loan);
+}
+
+//! Payload of the given length, with escaped bytes in it.
+std::string make_payload(size_t length, int seed = 0) {
+	std::string payload(length, char('a' + seed % 26));
+	for(size_t i = 0; i < length; i += 5)
+		payload[i] = char((i + seed) % 2 ? FURCOM_END : FURCOM_ESCAPE);
+
+	return payload;
+}
+
+} /* namespace */
+
+template<typename SIZES>
+class HandlerSizes : public ::testing::Test {
+};
+
+typedef ::testing::Types<Tiny_Sizes, Small_Sizes, Large_Sizes> All_Sizes;
+TYPED_TEST_SUITE(HandlerSizes, All_Sizes);
+
+TYPED_TEST(HandlerSizes, LongestPacketOnMixedBus) {
+	Bus_Sim bus;
+	typename TypeParam::node_t sender(bus, 1);
+	Tiny_Sizes::node_t tiny(bus, 2);
+	Small_Sizes::node_t small(bus, 3);
+	Large_Sizes::node_t large(bus, 4);
+
+	std::vector<std::string> received[3];
+	Protocol_Core *receivers[3] = { &tiny, &small, &large };
+	const size_t longest[3] = { Tiny_Sizes::LONGEST, Small_Sizes::LONGEST, Large_Sizes::LONGEST };
+	for(int i = 0; i < 3; i++)
+		ASSERT_TRUE(receivers[i]->subscribe("t", store_payload, &received[i]));
+
+	std::string payload = make_payload(TypeParam::LONGEST);
+	EXPECT_FALSE(sender.send_packet("t", payload.data(), payload.size() + 1));
+	ASSERT_TRUE(sender.send_packet("t", payload.data(), payload.size()));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	// Receivers with shorter frames get the start of the payload.
+	for(int i = 0; i < 3; i++) {
+		bool fits = TypeParam::LONGEST <= longest[i];
+
+		ASSERT_EQ(received[i].size(), 1u) << i;
+		EXPECT_EQ(received[i][0], payload.substr(0, longest[i])) << i;
+		EXPECT_EQ(receivers[i]->get_stats().rx_truncated, fits ? 0u : 1u) << i;
+	}
+}
+
+TYPED_TEST(HandlerSizes, QueueSizedForOneFrameKeepsSending) {
+	Bus_Sim bus;
+	typename TypeParam::node_t sender(bus, 1);
+	Large_Sizes::node_t receiver(bus, 2);
+
+	std::vector<std::string> received;
+	ASSERT_TRUE(receiver.subscribe("t", store_payload, &received));
+
+	// Lengths up to the longest packet, waiting for queue space as needed.
+	std::vector<std::string> sent;
+	for(int i = 0; i < 100; i++) {
+		sent.push_back(make_payload(1 + (i * 7) % TypeParam::LONGEST, i));
+
+		int steps = 0;
+		while(!sender.send_packet("t", sent.back().data(), sent.back().size()) && steps++ < 10000)
+			bus.step();
+		ASSERT_LT(steps, 10000) << i;
+	}
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	EXPECT_EQ(received, sent);
+	EXPECT_EQ(receiver.get_stats().rx_overruns, 0u);
+}
+
+TYPED_TEST(HandlerSizes, LoansKeepOneBufferForReception) {
+	Bus_Sim bus;
+	Large_Sizes::node_t sender(bus, 1);
+	typename TypeParam::node_t receiver(bus, 2);
+
+	loaner_t loaner = { &receiver, {}, 0 };
+	ASSERT_TRUE(receiver.subscribe("t", loan_payload, &loaner));
+
+	for(int i = 0; i < TypeParam::RX_BUFFERS + 2; i++) {
+		ASSERT_TRUE(sender.send_packet("t", "data", 4));
+		ASSERT_TRUE(bus.run_until_idle(100000));
+	}
+
+	// All but one buffer may be loaned, a single one never.
+	EXPECT_EQ(loaner.received, TypeParam::RX_BUFFERS + 2);
+	EXPECT_EQ(int(loaner.loans.size()), TypeParam::RX_BUFFERS - 1);
+	EXPECT_EQ(receiver.get_rx_loans(), TypeParam::RX_BUFFERS - 1);
+
+	for(auto &loan : loaner.loans)
+		receiver.return_rx(loan);
+	EXPECT_EQ(receiver.get_rx_loans(), 0);
+
+	// Returned buffers receive again.
+	loaner.loans.clear();
+	ASSERT_TRUE(sender.send_packet("t", "data", 4));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+	EXPECT_EQ(loaner.received, TypeParam::RX_BUFFERS + 3);
+	EXPECT_EQ(receiver.get_stats().rx_overruns, 0u);
+}
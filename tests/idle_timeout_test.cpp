@@ -0,0 +1,86 @@
+/*
+ * idle_timeout_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+struct log_context_t {
+	Bus_Sim *bus;
+	int node;
+	std::string *log;
+};
+
+void log_packet(void *context, const char *topic, const void *data, size_t length) {
+	auto log = reinterpret_cast<log_context_t*>(context);
+	(void)data;
+
+	char line[128];
+	snprintf(line, sizeof(line), "%llu %d %s %zu\n",
+			(unsigned long long)log->bus->get_step(), log->node, topic, length);
+	*log->log += line;
+}
+
+//! Bursts from several senders at once, with idle gaps of 8 to 44 ms in between.
+std::string run_bursts(uint32_t tick_rate, bool rx_timeout) {
+	Bus_Sim bus(250000, tick_rate);
+	Sim_Node<> a(bus, 1, false, rx_timeout);
+	Sim_Node<> b(bus, 2, false, rx_timeout);
+	Sim_Node<> c(bus, 3, true, rx_timeout);
+
+	std::string log;
+	log_context_t contexts[3] = { { &bus, 1, &log }, { &bus, 2, &log }, { &bus, 3, &log } };
+	a.subscribe("t/*", log_packet, &contexts[0]);
+	b.subscribe("t/*", log_packet, &contexts[1]);
+	c.subscribe("t/*", log_packet, &contexts[2]);
+
+	char payload[40] = {};
+	for(int round = 0; round < 40; round++) {
+		a.send_packet("t/a", payload, 10 + round % 20);
+		if(round % 3 == 0)
+			b.send_packet("t/b", payload, 5);
+		if(round % 4 == 0)
+			c.send_packet("t/c", payload, 30);
+		bus.run(200 + (round * 37) % 900);
+
+		if(round % 5 == 0) {
+			a.send_packet("t/a2", payload, 3);
+			b.send_packet("t/b2", payload, 3);
+		}
+		bus.run(100);
+	}
+	EXPECT_TRUE(bus.run_until_idle(1000000));
+
+	return log;
+}
+
+} /* namespace */
+
+TEST(IdleTimeout, SameTrafficAtAnyTickRate) {
+	for(bool rx_timeout : {false, true}) {
+		std::string reference = run_bursts(1000, rx_timeout);
+
+		// Every packet reaches both other nodes.
+		size_t lines = 0;
+		for(char c : reference)
+			lines += (c == '\n');
+		EXPECT_EQ(lines, 160u) << rx_timeout;
+
+		for(uint32_t tick_rate : {100u, 250u, 10000u, 32768u})
+			EXPECT_EQ(run_bursts(tick_rate, rx_timeout), reference) << tick_rate << " " << rx_timeout;
+	}
+}
+
+TEST(IdleTimeout, ReceiverTimeoutMatchesTickTiming) {
+	EXPECT_EQ(run_bursts(1000, true), run_bursts(1000, false));
+}
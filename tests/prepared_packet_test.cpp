@@ -0,0 +1,135 @@
+/*
+ * prepared_packet_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/PreparedPacket.h>
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr size_t LENGTH = 24;
+
+struct receiver_t {
+	int packets = 0;
+	int bad_packets = 0;
+	uint8_t expected[LENGTH];
+};
+
+void check_packet(void *context, const char *topic, const void *data, size_t length) {
+	auto receiver = reinterpret_cast<receiver_t*>(context);
+
+	receiver->packets++;
+	if(strcmp(topic, "telemetry/imu") != 0 || length != LENGTH
+			|| memcmp(data, receiver->expected, LENGTH) != 0)
+		receiver->bad_packets++;
+}
+
+} /* namespace */
+
+TEST(PreparedPacket, RejectsOutOfRangeFields) {
+	Bus_Sim bus;
+	Sim_Node<> node(bus, 1);
+	Prepared_Packet<LENGTH> packet(node, "telemetry/imu");
+
+	EXPECT_EQ(packet.get_length(), LENGTH);
+	EXPECT_TRUE(packet.set(LENGTH - 4, uint32_t(1)));
+	EXPECT_FALSE(packet.set(LENGTH - 3, uint32_t(1)));
+	EXPECT_FALSE(packet.set(LENGTH + 1, nullptr, 0));
+}
+
+TEST(PreparedPacket, FollowsHandlerSettings) {
+	// CRC and topic IDs switched on mid-stream, in every combination.
+	for(int mode = 0; mode < 4; mode++) {
+		Bus_Sim bus;
+		Sim_Node<> sender(bus, 1);
+		Sim_Node<> node(bus, 2);
+
+		receiver_t receiver;
+		ASSERT_TRUE(node.subscribe("telemetry/imu", check_packet, &receiver));
+		sender.add_topic_id(7, "telemetry/imu");
+		node.add_topic_id(7, "telemetry/imu");
+
+		Prepared_Packet<LENGTH> packet(sender, "telemetry/imu");
+		uint8_t payload[LENGTH] = {};
+
+		for(int i = 0; i < 300; i++) {
+			if(i == 100) {
+				sender.set_crc(mode & 1);
+				sender.set_topic_ids(mode & 2);
+			}
+
+			// Sprinkled with bytes that need escaping.
+			int offset = (i * 7) % 20;
+			uint8_t field[4] = {uint8_t(i), uint8_t(i % 3 ? FURCOM_ESCAPE : FURCOM_END),
+					uint8_t(i * 3), uint8_t(i % 5 ? 0x55 : FURCOM_ESCAPE)};
+			memcpy(payload + offset, field, sizeof(field));
+			ASSERT_TRUE(packet.set(offset, field, sizeof(field)));
+
+			if(i % 50 == 0) {
+				float value = i * 0.5f;
+				memcpy(payload + 20, &value, sizeof(value));
+				ASSERT_TRUE(packet.set(20, value));
+			}
+
+			EXPECT_EQ(memcmp(packet.get_data(), payload, LENGTH), 0) << mode << " " << i;
+			memcpy(receiver.expected, payload, LENGTH);
+
+			uint64_t before = node.get_stats().rx_encoded_bytes;
+			ASSERT_TRUE(packet.send()) << mode << " " << i;
+			EXPECT_TRUE(bus.run_until_idle(100000));
+			uint64_t prepared_bytes = node.get_stats().rx_encoded_bytes - before;
+
+			// Same frame as send_packet() builds, CRC included.
+			before = node.get_stats().rx_encoded_bytes;
+			ASSERT_TRUE(sender.send_packet("telemetry/imu", payload, LENGTH));
+			EXPECT_TRUE(bus.run_until_idle(100000));
+			EXPECT_EQ(prepared_bytes, node.get_stats().rx_encoded_bytes - before) << mode << " " << i;
+
+			ASSERT_EQ(receiver.packets, 2 * (i + 1)) << mode;
+		}
+
+		EXPECT_EQ(receiver.bad_packets, 0) << mode;
+		EXPECT_EQ(node.get_stats().rx_crc_errors, 0u) << mode;
+	}
+}
+
+TEST(PreparedPacket, InvalidatePicksUpTopicID) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> node(bus, 2);
+
+	receiver_t receiver;
+	ASSERT_TRUE(node.subscribe("telemetry/imu", check_packet, &receiver));
+	sender.set_topic_ids(true);
+	memset(receiver.expected, 0, LENGTH);
+
+	Prepared_Packet<LENGTH> packet(sender, "telemetry/imu");
+	uint64_t sizes[3];
+	for(int i = 0; i < 3; i++) {
+		if(i == 1) {
+			sender.add_topic_id(7, "telemetry/imu");
+			node.add_topic_id(7, "telemetry/imu");
+		}
+		else if(i == 2)
+			packet.invalidate();
+
+		uint64_t before = node.get_stats().rx_encoded_bytes;
+		ASSERT_TRUE(packet.send());
+		EXPECT_TRUE(bus.run_until_idle(100000));
+		sizes[i] = node.get_stats().rx_encoded_bytes - before;
+	}
+
+	EXPECT_EQ(receiver.packets, 3);
+	EXPECT_EQ(receiver.bad_packets, 0);
+	// The topic stays spelled out until the packet is invalidated.
+	EXPECT_EQ(sizes[1], sizes[0]);
+	EXPECT_LT(sizes[2], sizes[0]);
+}
@@ -0,0 +1,23 @@
+/*
+ * require_avx2.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <gtest/gtest.h>
+
+namespace {
+
+//! Skips all tests of a binary built with -mavx2 on hosts without AVX2.
+class Require_AVX2 : public ::testing::Environment {
+public:
+	void SetUp() override {
+		if(!__builtin_cpu_supports("avx2"))
+			GTEST_SKIP() << "Host has no AVX2";
+	}
+};
+
+::testing::Environment *const require_avx2 =
+		::testing::AddGlobalTestEnvironment(new Require_AVX2());
+
+}
@@ -0,0 +1,146 @@
+/*
+ * router_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/Router.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+typedef std::map<std::string, int> topic_counts_t;
+
+void count_topic(void *context, const char *topic, const void *data, size_t length) {
+	auto counts = reinterpret_cast<topic_counts_t*>(context);
+	(void)data;
+	(void)length;
+
+	(*counts)[topic]++;
+}
+
+//! Run several buses in lockstep.
+void run_buses(std::initializer_list<Bus_Sim*> buses, uint64_t steps) {
+	while(steps--) {
+		for(auto bus : buses)
+			bus->step();
+	}
+}
+
+} /* namespace */
+
+class RouterTest : public ::testing::TestWithParam<bool> {
+};
+
+TEST_P(RouterTest, ForwardsByRoute) {
+	bool crc = GetParam();
+
+	Bus_Sim a, b, c;
+	Sim_Node<> port_a(a, 100, true, true);
+	Sim_Node<> port_b(b, 100, false, true);
+	Sim_Node<> port_c(c, 100, true, true);
+	Sim_Node<> node_a(a, 1);
+	Sim_Node<> node_b(b, 2, true, true);
+	Sim_Node<> node_c(c, 3);
+
+	Router router(100);
+	int pa = router.add_port(port_a);
+	int pb = router.add_port(port_b);
+	int pc = router.add_port(port_c);
+	ASSERT_TRUE(router.add_route("sensor/*", 1 << pa, (1 << pb) | (1 << pc)));
+	ASSERT_TRUE(router.add_route("cmd/b", (1 << pa) | (1 << pc), 1 << pb, PRIO_HIGH));
+	ASSERT_TRUE(router.add_route("*", 1 << pc, 1 << pa));
+
+	topic_counts_t received[3];
+	Sim_Node<> *nodes[3] = { &node_a, &node_b, &node_c };
+	for(int i = 0; i < 3; i++) {
+		nodes[i]->set_crc(crc);
+		ASSERT_TRUE(nodes[i]->subscribe("*", count_topic, &received[i]));
+		ASSERT_TRUE(nodes[i]->add_topic_id(5, "sensor/id"));
+	}
+	ASSERT_TRUE(port_a.add_topic_id(5, "sensor/id"));
+	node_a.set_topic_ids(true);
+	node_c.set_batching(true);
+
+	uint8_t payload[20] = { 0, 0xDB, 1, 2, 3 };
+	for(int i = 0; i < 50; i++) {
+		ASSERT_TRUE(node_a.send_packet("sensor/temp", payload, 10));
+		ASSERT_TRUE(node_a.send_packet("sensor/id", payload, 3));
+		ASSERT_TRUE(node_a.send_packet("cmd/b", payload, 2));
+		ASSERT_TRUE(node_a.send_packet("local/a", payload, 2));
+		ASSERT_TRUE(node_c.send_packet("cmd/b", payload, 2));
+		ASSERT_TRUE(node_c.send_packet("c/x", payload, 5));
+		ASSERT_TRUE(node_b.send_packet("b/x", payload, 5));
+		run_buses({ &a, &b, &c }, 3000);
+	}
+	run_buses({ &a, &b, &c }, 100000);
+
+	// Exact, prefix and topic ID routes from A, local/a stays on A.
+	EXPECT_EQ(received[1], (topic_counts_t{ { "cmd/b", 100 }, { "sensor/id", 50 }, { "sensor/temp", 50 } }));
+	EXPECT_EQ(received[2], (topic_counts_t{ { "sensor/id", 50 }, { "sensor/temp", 50 } }));
+	// Everything from C, the records of its batches forwarded one by one.
+	EXPECT_EQ(received[0], (topic_counts_t{ { "c/x", 50 }, { "cmd/b", 50 } }));
+
+	router_stats_t stats;
+	router.get_stats(stats);
+	// Counted once per destination bus.
+	EXPECT_EQ(stats.forwarded, 50u * (2 + 2 + 1 + 2 + 1));
+	EXPECT_EQ(stats.dropped_loop, 0u);
+	EXPECT_EQ(stats.dropped_queue, 0u);
+
+	for(auto node : nodes)
+		EXPECT_EQ(node->get_stats().rx_crc_errors, 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(CRC, RouterTest, ::testing::Bool());
+
+TEST(Router, RouterLoopStaysFinite) {
+	Bus_Sim a, b;
+	Sim_Node<> r1_a(a, 101), r1_b(b, 101);
+	Sim_Node<> r2_a(a, 102), r2_b(b, 102);
+	Sim_Node<> node_a(a, 1), node_b(b, 2);
+
+	// Two routers both forwarding everything between the same buses.
+	Router r1(101), r2(102);
+	r1.add_port(r1_a);
+	r1.add_port(r1_b);
+	r2.add_port(r2_a);
+	r2.add_port(r2_b);
+	ASSERT_TRUE(r1.add_route("*", 3, 3));
+	ASSERT_TRUE(r2.add_route("*", 3, 3));
+
+	topic_counts_t received_a, received_b;
+	ASSERT_TRUE(node_a.subscribe("*", count_topic, &received_a));
+	ASSERT_TRUE(node_b.subscribe("*", count_topic, &received_b));
+
+	uint8_t payload[4] = { 1, 2, 3, 4 };
+	for(int i = 0; i < 10; i++) {
+		ASSERT_TRUE(node_a.send_packet("x/a", payload, 4));
+		ASSERT_TRUE(node_b.send_packet("x/b", payload, 4));
+		run_buses({ &a, &b }, 5000);
+	}
+	run_buses({ &a, &b }, 100000);
+
+	// Both buses went quiet again.
+	uint64_t busy_a = a.busy_steps, busy_b = b.busy_steps;
+	run_buses({ &a, &b }, 10000);
+	EXPECT_EQ(a.busy_steps, busy_a);
+	EXPECT_EQ(b.busy_steps, busy_b);
+
+	// Every packet made it across, copies that came back were dropped.
+	EXPECT_GE(received_b["x/a"], 10);
+	EXPECT_GE(received_a["x/b"], 10);
+
+	router_stats_t stats_1, stats_2;
+	r1.get_stats(stats_1);
+	r2.get_stats(stats_2);
+	EXPECT_GT(stats_1.dropped_loop + stats_2.dropped_loop, 0u);
+	EXPECT_EQ(stats_1.dropped_queue + stats_2.dropped_queue, 0u);
+}
@@ -0,0 +1,98 @@
+/*
+ * rpc_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/RPC.h>
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+uint8_t echo(void *context, const void *args, size_t length, rpc_reply_t &reply) {
+	(void)context;
+
+	memcpy(reply.data, args, length);
+	reply.length = length;
+	return RPC_OK;
+}
+
+struct results_t {
+	int replies;
+	int timeouts;
+	int bad;
+};
+
+void check_done(void *context, uint8_t status, const void *data, size_t length) {
+	auto results = reinterpret_cast<results_t*>(context);
+	(void)data;
+
+	if(status == RPC_TIMEOUT) {
+		results->timeouts++;
+		return;
+	}
+
+	uint32_t value;
+	if(status != RPC_OK || length != sizeof(value))
+		results->bad++;
+	else
+		results->replies++;
+}
+
+} /* namespace */
+
+TEST(RPC, CallsComplete) {
+	Bus_Sim bus;
+	Sim_Node<> caller(bus, 1);
+	Sim_Node<> server(bus, 2);
+
+	RPC_Client client(caller, 0x101);
+	ASSERT_TRUE(client.attach());
+	RPC_Method method("svc/echo", echo);
+	ASSERT_TRUE(method.attach(server));
+	bus.run(300);
+
+	results_t results = {};
+	for(uint32_t i = 0; i < 4; i++)
+		ASSERT_TRUE(client.call("svc/echo", &i, sizeof(i), check_done, &results, 100));
+	EXPECT_EQ(client.get_pending(), 4);
+
+	for(int i = 0; i < 100000 && results.replies < 4; i++)
+		bus.run(1);
+
+	EXPECT_EQ(results.replies, 4);
+	EXPECT_EQ(results.timeouts, 0);
+	EXPECT_EQ(results.bad, 0);
+	EXPECT_EQ(client.get_pending(), 0);
+	EXPECT_EQ(method.get_served(), 4u);
+}
+
+TEST(RPC, ServiceTimesOutCalls) {
+	Bus_Sim bus;
+	Sim_Node<> caller(bus, 1);
+	Sim_Node<> idle(bus, 2);
+
+	RPC_Client client(caller, 7);
+	ASSERT_TRUE(client.attach());
+	bus.run(300);
+
+	results_t results = {};
+	uint32_t value = 0;
+	uint32_t start = bus.get_tick();
+	ASSERT_TRUE(client.call("svc/none", &value, sizeof(value), check_done, &results, 20));
+
+	for(int i = 0; i < 100000 && results.timeouts == 0; i++)
+		bus.run(1);
+
+	// Timed out from process_tx(), not before the deadline.
+	EXPECT_EQ(results.timeouts, 1);
+	EXPECT_GE(bus.get_tick() - start, 20u);
+	EXPECT_EQ(client.get_timeouts(), 1u);
+	EXPECT_EQ(client.get_pending(), 0);
+}
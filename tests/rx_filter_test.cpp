@@ -0,0 +1,129 @@
+/*
+ * rx_filter_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+void record_packet(void *context, const char *topic, const void *data, size_t length) {
+	auto packets = reinterpret_cast<std::vector<std::string>*>(context);
+
+	packets->push_back(std::string(topic) + "=" +
+			std::string(reinterpret_cast<const char*>(data), length));
+}
+
+struct filter_result_t {
+	std::vector<std::string> packets;
+	bus_stats_t stats;
+	uint64_t dma_bytes;
+};
+
+/*! Send frames on ten topics to a filtering receiver, which subscribed
+ *  to one exact topic and one prefix. */
+filter_result_t run_filtered(bool dma_rx, bool crc) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2, false, false, dma_rx);
+
+	filter_result_t result;
+	receiver.set_rx_counting(false);
+	EXPECT_TRUE(receiver.subscribe("topic/3", record_packet, &result.packets));
+	EXPECT_TRUE(receiver.subscribe("group/*", record_packet, &result.packets));
+	receiver.set_rx_filter(true);
+
+	sender.set_crc(crc);
+	for(int i = 0; i < 200; i++) {
+		std::string topic = ((i % 10 < 7) ? "topic/" : "group/") + std::to_string(i % 10);
+		std::string payload(i % 90, char(i));
+		EXPECT_TRUE(sender.send_packet_wait(topic.c_str(), payload.data(), payload.size(), 100));
+		if(i % 5 == 4) {
+			EXPECT_TRUE(bus.run_until_idle(100000));
+		}
+	}
+	EXPECT_TRUE(bus.run_until_idle(100000));
+
+	receiver.get_stats(result.stats);
+	result.dma_bytes = receiver.rx_dma_bytes;
+
+	return result;
+}
+
+} /* namespace */
+
+TEST(RXFilter, DMAReceptionFiltersLikeByteReception) {
+	for(bool crc : {false, true}) {
+		filter_result_t bytewise = run_filtered(false, crc);
+		filter_result_t dma = run_filtered(true, crc);
+
+		// topic/3 and group/7..9, 20 frames each.
+		EXPECT_EQ(bytewise.packets.size(), 80u) << crc;
+		EXPECT_EQ(bytewise.stats.frames_received, 80u) << crc;
+		EXPECT_EQ(bytewise.stats.rx_filtered, 120u) << crc;
+
+		EXPECT_GT(dma.dma_bytes, 0u);
+		EXPECT_EQ(dma.packets, bytewise.packets) << crc;
+		EXPECT_EQ(dma.stats.frames_received, bytewise.stats.frames_received) << crc;
+		EXPECT_EQ(dma.stats.rx_filtered, bytewise.stats.rx_filtered) << crc;
+	}
+}
+
+namespace {
+
+/*! Send a burst of back-to-back frames on ten topics to a receiver with
+ *  only two RX buffers and a receiver thread that runs late, subscribed
+ *  to topic/3 only. */
+filter_result_t run_burst(bool filter) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<2> receiver(bus, 2);
+
+	filter_result_t result;
+	receiver.set_rx_counting(false);
+	receiver.set_rx_delay(100);
+	EXPECT_TRUE(receiver.subscribe("topic/3", record_packet, &result.packets));
+	receiver.set_rx_filter(filter);
+
+	for(int i = 0; i < 200; i++) {
+		std::string topic = "topic/" + std::to_string(i % 10);
+		std::string payload(8 + i % 8, char(i));
+		EXPECT_TRUE(sender.send_packet_wait(topic.c_str(), payload.data(), payload.size(), 100));
+	}
+	EXPECT_TRUE(bus.run_until_idle(100000));
+	bus.run(200);
+
+	receiver.get_stats(result.stats);
+	result.dma_bytes = receiver.rx_dma_bytes;
+
+	return result;
+}
+
+} /* namespace */
+
+TEST(RXFilter, FilterRelievesRXBuffersDuringBurst) {
+	filter_result_t unfiltered = run_burst(false);
+	filter_result_t filtered = run_burst(true);
+
+	// Without the filter, every frame takes a buffer until the late
+	// thread frees it, so most are dropped, wanted ones included.
+	EXPECT_GE(unfiltered.stats.rx_overruns, 100u);
+	EXPECT_LT(unfiltered.packets.size(), 20u);
+
+	EXPECT_LT(filtered.stats.frames_received, unfiltered.stats.frames_received);
+	EXPECT_LT(filtered.stats.rx_overruns, unfiltered.stats.rx_overruns);
+	EXPECT_EQ(filtered.stats.rx_overruns, 0u);
+	EXPECT_EQ(filtered.stats.rx_filtered, 180u);
+	EXPECT_EQ(filtered.stats.frames_received, 20u);
+	ASSERT_EQ(filtered.packets.size(), 20u);
+	for(auto &packet : filtered.packets)
+		EXPECT_EQ(packet.substr(0, 8), "topic/3=");
+}
@@ -0,0 +1,166 @@
+/*
+ * rx_pool_stress_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/RXPool.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr int BUFFERS = 4;
+constexpr size_t FRAME_LENGTH = 64;
+constexpr int FRAMES = 20000;
+constexpr int WORKERS = 3;
+
+size_t frame_length(int frame) {
+	return 8 + frame % (FRAME_LENGTH - 8);
+}
+
+//! Frame number, followed by data derived from it.
+bool check_frame(const rx_buffer_t &buffer, int &frame) {
+	memcpy(&frame, buffer.raw_data, sizeof(frame));
+
+	size_t length = buffer.data_end - buffer.raw_data;
+	if(length != frame_length(frame))
+		return false;
+
+	for(size_t k = sizeof(frame); k < length; k++)
+		if(buffer.raw_data[k] != char(frame * 31 + k))
+			return false;
+
+	return true;
+}
+
+//! Loans handed from the receiver thread to the workers, -1 to stop.
+class Loan_Queue {
+private:
+	std::mutex mutex;
+	std::deque<int> loans;
+
+public:
+	void push(int index) {
+		std::lock_guard<std::mutex> lock(mutex);
+		loans.push_back(index);
+	}
+
+	int pop() {
+		while(true) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if(!loans.empty()) {
+					int index = loans.front();
+					if(index >= 0)
+						loans.pop_front();
+					return index;
+				}
+			}
+			std::this_thread::yield();
+		}
+	}
+};
+
+} /* namespace */
+
+TEST(RXPoolStress, LoansAcrossThreads) {
+	static rx_buffer_t buffers[BUFFERS];
+	static uint16_t ready[BUFFERS];
+	static char data[BUFFERS * (FRAME_LENGTH + 1)];
+
+	RX_Pool pool;
+	pool.set_storage(buffers, ready, BUFFERS, data, FRAME_LENGTH);
+
+	std::atomic<bool> isr_done(false);
+	std::atomic<int> bad_frames(0);
+	std::atomic<int> worker_frames(0);
+	Loan_Queue loans;
+
+	// Stands in for the ISR, waits for buffers instead of dropping frames.
+	std::thread isr([&] {
+		for(int frame = 0; frame < FRAMES;) {
+			int index = pool.claim();
+			if(index < 0) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			rx_buffer_t &buffer = pool[index];
+			memcpy(buffer.raw_data, &frame, sizeof(frame));
+			buffer.data_end = buffer.raw_data + frame_length(frame);
+			for(size_t k = sizeof(frame); k < frame_length(frame); k++)
+				buffer.raw_data[k] = char(frame * 31 + k);
+
+			pool.push_ready(index);
+			frame++;
+		}
+		isr_done = true;
+	});
+
+	std::thread receiver([&] {
+		int next = 0;
+
+		while(next < FRAMES) {
+			int index = pool.pop_ready();
+			if(index < 0) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			int frame;
+			if(!check_frame(pool[index], frame) || frame != next)
+				bad_frames++;
+			next++;
+
+			// Every other frame goes to two workers at once.
+			int loan_count = 1 + (frame & 1);
+			for(int i = 0; i < loan_count; i++) {
+				pool.retain(index, true);
+				loans.push(index);
+			}
+			pool.release(index);
+		}
+
+		loans.push(-1);
+	});
+
+	std::vector<std::thread> workers;
+	for(int w = 0; w < WORKERS; w++) {
+		workers.emplace_back([&] {
+			for(int index; (index = loans.pop()) >= 0;) {
+				int frame;
+				if(!check_frame(pool[index], frame))
+					bad_frames++;
+				worker_frames++;
+
+				pool.release(index, true);
+			}
+		});
+	}
+
+	isr.join();
+	receiver.join();
+	for(auto &worker : workers)
+		worker.join();
+
+	EXPECT_TRUE(isr_done);
+	EXPECT_EQ(bad_frames.load(), 0);
+	EXPECT_EQ(worker_frames.load(), FRAMES + FRAMES / 2);
+	EXPECT_EQ(pool.get_loans(), 0);
+
+	// Every buffer made it back into the free list.
+	int free_count = 0;
+	while(pool.claim() >= 0)
+		free_count++;
+	EXPECT_EQ(free_count, BUFFERS);
+}
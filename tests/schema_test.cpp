@@ -0,0 +1,187 @@
+/*
+ * schema_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/Schema.h>
+#include <FurComs/SchemaRuby.h>
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+struct Telemetry {
+	static constexpr const char *TOPIC = "motor/telemetry";
+
+	FURCOM_SCHEMA_FIELD(position, int32_t);
+	FURCOM_SCHEMA_FIELD(velocity, int16_t);
+	FURCOM_SCHEMA_FIELD(current_ma, uint16_t);
+	FURCOM_SCHEMA_FIELD(temperature, float);
+	FURCOM_SCHEMA_FIELD(enabled, bool);
+	FURCOM_SCHEMA_FIELD(name, char[8]);
+	FURCOM_SCHEMA_FIELD(serial, uint8_t[4]);
+	FURCOM_SCHEMA_FIELD(uptime, uint64_t);
+	FURCOM_SCHEMA_FIELD(gain, double);
+
+	typedef Schema_Fields<position, velocity, current_ma, temperature, enabled,
+			name, serial, uptime, gain> fields;
+};
+
+//! First version of Telemetry, before fields were appended.
+struct Old_Telemetry {
+	static constexpr const char *TOPIC = "motor/telemetry";
+
+	typedef Schema_Fields<Telemetry::position, Telemetry::velocity> fields;
+};
+
+static_assert(Schema_View<Telemetry>::LENGTH == 4 + 2 + 2 + 4 + 1 + 8 + 4 + 8 + 8,
+		"Fields must be packed without padding!");
+
+Schema_Message<Telemetry> make_message(int i) {
+	Schema_Message<Telemetry> message;
+
+	message.set<Telemetry::position>(-100000 * i);
+	message.set<Telemetry::velocity>(-i);
+	message.set<Telemetry::current_ma>(65000);
+	message.set<Telemetry::temperature>(36.5f);
+	message.set<Telemetry::enabled>(i & 1);
+	message.set<Telemetry::name>("motor");
+	const uint8_t serial[4] = {1, 2, FURCOM_END, FURCOM_ESCAPE};
+	message.set<Telemetry::serial>(serial);
+	message.set<Telemetry::uptime>(0x123456789ABCull * i);
+	message.set<Telemetry::gain>(-0.25);
+
+	return message;
+}
+
+void record_view(void *context, const char *topic, const void *data, size_t length) {
+	(void)topic;
+
+	auto received = reinterpret_cast<std::vector<std::string>*>(context);
+	received->push_back(std::string(reinterpret_cast<const char*>(data), length));
+}
+
+} /* namespace */
+
+TEST(Schema, WireFormatIsLittleEndian) {
+	Schema_Message<Telemetry> message = make_message(1);
+	message.set<Telemetry::name>("motorABCDEFG");
+
+	const uint8_t expected[] = {
+		0x60, 0x79, 0xFE, 0xFF,		// position, -100000
+		0xFF, 0xFF,					// velocity, -1
+		0xE8, 0xFD,					// current_ma, 65000
+		0x00, 0x00, 0x12, 0x42,		// temperature, 36.5
+		0x01,						// enabled
+		'm', 'o', 't', 'o', 'r', 'A', 'B', 'C',	// name, cut off without NUL
+		0x01, 0x02, 0x00, 0xDB,		// serial
+		0xBC, 0x9A, 0x78, 0x56, 0x34, 0x12, 0x00, 0x00,	// uptime
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xD0, 0xBF,	// gain, -0.25
+	};
+	ASSERT_EQ(message.get_length(), sizeof(expected));
+	EXPECT_EQ(memcmp(message.get_data(), expected, sizeof(expected)), 0);
+
+	EXPECT_EQ(message.get<Telemetry::position>(), -100000);
+	EXPECT_EQ(message.get<Telemetry::current_ma>(), 65000);
+	EXPECT_EQ(message.get<Telemetry::temperature>(), 36.5f);
+	EXPECT_EQ(strnlen(message.get<Telemetry::name>(), 8), 8u);
+	EXPECT_EQ(message.get<Telemetry::gain>(), -0.25);
+
+	// Shorter strings are padded with NULs.
+	message.set<Telemetry::name>("ab");
+	EXPECT_STREQ(message.get<Telemetry::name>(), "ab");
+	EXPECT_EQ(memcmp(message.get<Telemetry::name>(), "ab\0\0\0\0\0\0", 8), 0);
+}
+
+TEST(Schema, VersionsUnderstandEachOther) {
+	Schema_Message<Telemetry> message = make_message(2);
+
+	// An old node reads the fields it knows from a newer message.
+	Schema_View<Old_Telemetry> old_view(message.get_data(), message.get_length());
+	EXPECT_TRUE(old_view.valid());
+	EXPECT_EQ(old_view.get<Telemetry::position>(), -200000);
+	EXPECT_EQ(old_view.get<Telemetry::velocity>(), -2);
+
+	// A new node reads the fields an old message lacks as 0.
+	Schema_View<Telemetry> new_view(message.get_data(), Schema_View<Old_Telemetry>::LENGTH);
+	EXPECT_FALSE(new_view.valid());
+	EXPECT_TRUE(new_view.has<Telemetry::velocity>());
+	EXPECT_FALSE(new_view.has<Telemetry::current_ma>());
+	EXPECT_EQ(new_view.get<Telemetry::position>(), -200000);
+	EXPECT_EQ(new_view.get<Telemetry::current_ma>(), 0);
+	EXPECT_EQ(new_view.get<Telemetry::temperature>(), 0.0f);
+	EXPECT_FALSE(new_view.get<Telemetry::enabled>());
+	EXPECT_EQ(new_view.get<Telemetry::name>(), nullptr);
+
+	// Fields cut in half are missing, too.
+	Schema_View<Telemetry> torn(message.get_data(), 5);
+	EXPECT_TRUE(torn.has<Telemetry::position>());
+	EXPECT_FALSE(torn.has<Telemetry::velocity>());
+	EXPECT_EQ(torn.get<Telemetry::velocity>(), 0);
+}
+
+TEST(Schema, RoundTripOverBus) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+
+	std::vector<std::string> received;
+	ASSERT_TRUE(receiver.subscribe(Telemetry::TOPIC, record_view, &received));
+
+	for(int i = 0; i < 50; i++) {
+		while(!make_message(i).send(sender))
+			bus.step();
+		bus.run(50);
+	}
+	EXPECT_TRUE(bus.run_until_idle(100000));
+
+	ASSERT_EQ(received.size(), 50u);
+	for(int i = 0; i < 50; i++) {
+		Schema_View<Telemetry> view(received[i].data(), received[i].size());
+		ASSERT_TRUE(view.valid()) << i;
+
+		EXPECT_EQ(view.get<Telemetry::position>(), -100000 * i);
+		EXPECT_EQ(view.get<Telemetry::velocity>(), -i);
+		EXPECT_EQ(view.get<Telemetry::current_ma>(), 65000);
+		EXPECT_EQ(view.get<Telemetry::temperature>(), 36.5f);
+		EXPECT_EQ(view.get<Telemetry::enabled>(), bool(i & 1));
+		EXPECT_STREQ(view.get<Telemetry::name>(), "motor");
+		EXPECT_EQ(memcmp(view.get<Telemetry::serial>(), "\x01\x02\x00\xDB", 4), 0);
+		EXPECT_EQ(view.get<Telemetry::uptime>(), 0x123456789ABCull * i);
+		EXPECT_EQ(view.get<Telemetry::gain>(), -0.25);
+	}
+}
+
+TEST(Schema, WritesRubyDecoder) {
+	char *text = nullptr;
+	size_t size = 0;
+	FILE *out = open_memstream(&text, &size);
+	ASSERT_NE(out, nullptr);
+
+	schema_write_ruby<Telemetry>(out, "Telemetry", "\t");
+	fclose(out);
+
+	EXPECT_STREQ(text,
+		"\tTelemetry = TEF::FurComs::Schema.new('motor/telemetry',\n"
+		"\t\t[:position, 'l<', :int],\n"
+		"\t\t[:velocity, 's<', :int],\n"
+		"\t\t[:current_ma, 'S<', :int],\n"
+		"\t\t[:temperature, 'e', :float],\n"
+		"\t\t[:enabled, 'C', :bool],\n"
+		"\t\t[:name, 'Z8', :string],\n"
+		"\t\t[:serial, 'a4', :bytes],\n"
+		"\t\t[:uptime, 'Q<', :int],\n"
+		"\t\t[:gain, 'E', :float],\n"
+		"\t)\n");
+	free(text);
+}
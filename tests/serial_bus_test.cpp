@@ -0,0 +1,199 @@
+/*
+ * serial_bus_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/SerialBus.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+//! Pseudo-terminal standing in for a USB-to-UART adapter, the test holds the wire end.
+class Pty {
+public:
+	int master;
+	std::string slave_name;
+
+	Pty() : master(posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK)), slave_name() {
+		if(master >= 0 && grantpt(master) == 0 && unlockpt(master) == 0)
+			slave_name = ptsname(master);
+	}
+
+	~Pty() {
+		close_master();
+	}
+
+	void close_master() {
+		if(master >= 0)
+			::close(master);
+		master = -1;
+	}
+
+	//! Read everything the bus wrote so far.
+	std::vector<uint8_t> read_all() {
+		std::vector<uint8_t> out;
+		uint8_t buffer[4096];
+
+		ssize_t result;
+		while((result = ::read(master, buffer, sizeof(buffer))) > 0)
+			out.insert(out.end(), buffer, buffer + result);
+
+		return out;
+	}
+
+	//! Write as much as the line discipline takes, return the number of bytes.
+	size_t write_some(const uint8_t *data, size_t length) {
+		ssize_t result = ::write(master, data, length);
+		return (result > 0) ? result : 0;
+	}
+};
+
+struct received_t {
+	std::vector<std::string> packets;
+};
+
+void record_packet(void *context, const char *topic, const void *data, size_t length) {
+	auto received = reinterpret_cast<received_t*>(context);
+
+	received->packets.push_back(std::string(topic) + "=" +
+			std::string(reinterpret_cast<const char*>(data), length));
+}
+
+std::string make_payload(int i) {
+	std::string payload;
+	for(int k = 0; k < 100 + i % 100; k++)
+		payload.push_back(char(i * 7 + k));
+
+	return payload;
+}
+
+} /* namespace */
+
+TEST(SerialBus, OpenAndClose) {
+	Pty pty;
+	ASSERT_GE(pty.master, 0);
+
+	Serial_Bus bus;
+	EXPECT_FALSE(bus.is_open());
+	EXPECT_FALSE(bus.read_available());
+
+	EXPECT_FALSE(bus.open("/dev/furcoms-does-not-exist"));
+	EXPECT_FALSE(bus.is_open());
+
+	ASSERT_TRUE(bus.open(pty.slave_name.c_str(), 1000000));
+	EXPECT_TRUE(bus.is_open());
+	EXPECT_GE(bus.get_fd(), 0);
+	// Nothing there yet, but the port is fine.
+	EXPECT_TRUE(bus.read_available());
+
+	bus.close();
+	EXPECT_FALSE(bus.is_open());
+	EXPECT_EQ(bus.get_fd(), -1);
+
+	// Reopening starts from scratch.
+	ASSERT_TRUE(bus.open(pty.slave_name.c_str()));
+	EXPECT_TRUE(bus.is_open());
+
+	// The other end going away is reported, and the poller drops the bus.
+	Serial_Poller poller;
+	ASSERT_TRUE(poller.add(bus));
+	pty.close_master();
+
+	for(int i = 0; i < 10 && bus.is_open(); i++)
+		poller.poll(100);
+	EXPECT_FALSE(bus.is_open());
+}
+
+TEST(SerialBus, PartialWritesAreCompleted) {
+	Pty tx_pty, rx_pty;
+	ASSERT_GE(tx_pty.master, 0);
+	ASSERT_GE(rx_pty.master, 0);
+
+	Serial_Bus sender, receiver;
+	ASSERT_TRUE(sender.open(tx_pty.slave_name.c_str(), 1000000));
+	ASSERT_TRUE(receiver.open(rx_pty.slave_name.c_str(), 1000000));
+
+	received_t received;
+	ASSERT_TRUE(receiver.subscribe("test/*", record_packet, &received));
+
+	// Far more than the pty takes while nobody reads the wire end.
+	std::vector<std::string> sent;
+	for(int i = 0; i < 400; i++) {
+		std::string payload = make_payload(i);
+		ASSERT_TRUE(sender.send_message("test/partial", payload.data(), payload.size()));
+		sent.push_back("test/partial=" + payload);
+	}
+	EXPECT_TRUE(sender.has_tx_pending());
+	EXPECT_FALSE(sender.flush());
+
+	// Carry the data over while flushing the rest, a little at a time.
+	std::vector<uint8_t> wire;
+	for(int round = 0; round < 100000 && received.packets.size() < sent.size(); round++) {
+		sender.flush();
+
+		std::vector<uint8_t> data = tx_pty.read_all();
+		wire.insert(wire.end(), data.begin(), data.end());
+
+		size_t written = rx_pty.write_some(wire.data(), wire.size());
+		wire.erase(wire.begin(), wire.begin() + written);
+
+		ASSERT_TRUE(receiver.read_available());
+	}
+
+	EXPECT_FALSE(sender.has_tx_pending());
+	EXPECT_EQ(received.packets, sent);
+}
+
+TEST(SerialBus, FramesSurviveReadTimeouts) {
+	Pty tx_pty, rx_pty;
+	ASSERT_GE(tx_pty.master, 0);
+	ASSERT_GE(rx_pty.master, 0);
+
+	Serial_Bus sender, receiver;
+	ASSERT_TRUE(sender.open(tx_pty.slave_name.c_str(), 1000000));
+	ASSERT_TRUE(receiver.open(rx_pty.slave_name.c_str(), 1000000));
+
+	received_t received;
+	ASSERT_TRUE(receiver.subscribe("test/*", record_packet, &received));
+
+	Serial_Poller poller;
+	ASSERT_TRUE(poller.add(receiver));
+
+	// A quiet line times out without events.
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_EQ(poller.poll(50), 0);
+	EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(40));
+
+	std::string payload = make_payload(3);
+	ASSERT_TRUE(sender.send_message("test/split", payload.data(), payload.size()));
+	ASSERT_TRUE(sender.flush());
+	std::vector<uint8_t> frame = tx_pty.read_all();
+	ASSERT_GT(frame.size(), payload.size());
+
+	// The first half arrives, then the line goes quiet for a while.
+	size_t half = frame.size() / 2;
+	ASSERT_EQ(rx_pty.write_some(frame.data(), half), half);
+	for(int i = 0; i < 3; i++)
+		poller.poll(20);
+	EXPECT_TRUE(received.packets.empty());
+
+	ASSERT_EQ(rx_pty.write_some(frame.data() + half, frame.size() - half), frame.size() - half);
+	for(int i = 0; i < 10 && received.packets.empty(); i++)
+		poller.poll(100);
+
+	ASSERT_EQ(received.packets.size(), 1u);
+	EXPECT_EQ(received.packets[0], "test/split=" + payload);
+	EXPECT_TRUE(receiver.is_open());
+}
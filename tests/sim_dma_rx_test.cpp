@@ -0,0 +1,110 @@
+/*
+ * sim_dma_rx_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+//! Topic and payload of every packet a node received, in order.
+void record_packet(void *context, const char *topic, const void *data, size_t length) {
+	auto packets = reinterpret_cast<std::vector<std::string>*>(context);
+
+	packets->push_back(std::string(topic) + "=" +
+			std::string(reinterpret_cast<const char*>(data), length));
+}
+
+//! Packets of the given sender, whose topics start with its name.
+std::vector<std::string> from(const std::vector<std::string> &packets, char sender) {
+	std::vector<std::string> out;
+	for(auto &packet : packets) {
+		if(packet[0] == sender)
+			out.push_back(packet);
+	}
+
+	return out;
+}
+
+//! Payload full of bytes SLIP has to escape, of a length that wraps the DMA buffer.
+std::string make_payload(int i) {
+	std::string payload;
+	for(int k = 0; k < (i * 37) % 120; k++)
+		payload.push_back(char((k % 3 == 0) ? FURCOM_END : (k % 3 == 1) ? FURCOM_ESCAPE : k + i));
+
+	return payload;
+}
+
+void run_streams(bool crc) {
+	Bus_Sim bus;
+	Sim_Node<> a(bus, 1, false, false, true);
+	Sim_Node<> byte_node(bus, 2);
+	Sim_Node<> dma_node(bus, 3, false, false, true);
+
+	std::vector<std::string> received[3];
+	Sim_Node_Base *nodes[3] = { &a, &byte_node, &dma_node };
+	for(int n = 0; n < 3; n++) {
+		nodes[n]->set_crc(crc);
+		ASSERT_TRUE(nodes[n]->subscribe("*", record_packet, &received[n]));
+	}
+
+	std::vector<std::string> sent_b, sent_c;
+	for(int i = 0; i < 40; i++) {
+		std::string payload = make_payload(i);
+		std::string topic = "a/" + std::to_string(i % 5);
+		ASSERT_TRUE(a.send_packet_wait(topic.c_str(), payload.data(), payload.size(), 100));
+
+		// The receivers send now and then, so DMA reception is switched off and on.
+		if(i % 8 == 0) {
+			ASSERT_TRUE(byte_node.send_packet_wait("b/x", payload.data(), payload.size(), 100));
+			sent_b.push_back("b/x=" + payload);
+			ASSERT_TRUE(dma_node.send_packet_wait("c/x", payload.data(), payload.size(), 100));
+			sent_c.push_back("c/x=" + payload);
+		}
+
+		// Bursts, so that the receivers go idle and back to DMA reception in between.
+		if(i % 4 == 3)
+			ASSERT_TRUE(bus.run_until_idle(1000000));
+		else
+			bus.run(i % 7);
+	}
+	ASSERT_TRUE(bus.run_until_idle(1000000));
+
+	EXPECT_EQ(from(received[1], 'a').size(), 40u);
+	EXPECT_EQ(from(received[2], 'a'), from(received[1], 'a'));
+
+	EXPECT_EQ(from(received[0], 'b'), sent_b);
+	EXPECT_EQ(from(received[0], 'c'), sent_c);
+	EXPECT_EQ(from(received[2], 'b'), sent_b);
+	EXPECT_EQ(from(received[1], 'c'), sent_c);
+
+	bus_stats_t byte_stats, dma_stats;
+	byte_node.get_stats(byte_stats);
+	dma_node.get_stats(dma_stats);
+	EXPECT_EQ(dma_stats.rx_crc_errors, 0u);
+	EXPECT_EQ(dma_stats.rx_overruns, 0u);
+	EXPECT_EQ(dma_stats.rx_encoded_bytes, byte_stats.rx_encoded_bytes);
+	EXPECT_EQ(dma_stats.rx_decoded_bytes, byte_stats.rx_decoded_bytes);
+
+	EXPECT_EQ(byte_node.rx_dma_bytes, 0u);
+	EXPECT_GT(dma_node.rx_dma_bytes, 0u);
+	EXPECT_GT(a.rx_dma_bytes, 0u);
+}
+
+} /* namespace */
+
+TEST(SimDMARX, SameFramesAsByteReception) {
+	run_streams(false);
+}
+
+TEST(SimDMARX, SameFramesAsByteReceptionWithCRC) {
+	run_streams(true);
+}
@@ -0,0 +1,175 @@
+/*
+ * state_topics_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/StateTopics.h>
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <thread>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+//! Hands messages to state caches without a bus.
+class Test_Dispatcher : public Packet_Dispatcher {
+public:
+	using Packet_Dispatcher::dispatch_message;
+};
+
+struct burst_result_t {
+	uint32_t frames_sent;
+	uint64_t busy_steps;
+	uint32_t last_value;
+	uint32_t updates;
+};
+
+/*! Publish 50 updates of one state topic while a competitor keeps the
+ *  bus busy with higher priority bulk data, either through a
+ *  State_Publisher or with plain send_packet(). */
+burst_result_t run_burst(bool conflate) {
+	Bus_Sim bus;
+	// Queues large enough to hold the burst without conflation.
+	Sim_Node<4, 256, 4096> publisher(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+	Sim_Node<4, 256, 4096> competitor(bus, 3);
+
+	State_Cache<sizeof(uint32_t)> cache("state/value");
+	receiver.add_state_cache(cache);
+	State_Publisher state(publisher, "state/value");
+
+	char bulk[200];
+	memset(bulk, 'b', sizeof(bulk));
+	for(int i = 0; i < 4; i++)
+		EXPECT_TRUE(competitor.send_packet("bulk", bulk, sizeof(bulk), PRIO_HIGH));
+
+	for(uint32_t value = 0; value < 50; value++) {
+		if(conflate) {
+			EXPECT_TRUE(state.publish(value));
+		}
+		else {
+			EXPECT_TRUE(publisher.send_packet("state/value", &value, sizeof(value)));
+		}
+		bus.run(10);
+	}
+	EXPECT_TRUE(bus.run_until_idle(100000));
+
+	burst_result_t result = {};
+	result.frames_sent = publisher.get_stats().frames_sent;
+	result.busy_steps = bus.busy_steps;
+	EXPECT_TRUE(cache.read(result.last_value));
+	result.updates = cache.get_updates();
+
+	return result;
+}
+
+} /* namespace */
+
+TEST(StatePublisher, ReplacesValueAfterLostArbitration) {
+	Bus_Sim bus;
+	Sim_Node<> publisher(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+	Sim_Node<> competitor(bus, 3);
+
+	State_Cache<sizeof(uint32_t)> cache("state/value");
+	receiver.add_state_cache(cache);
+	State_Publisher state(publisher, "state/value");
+
+	// Higher priority traffic wins the next arbitrations.
+	char bulk[32];
+	memset(bulk, 'b', sizeof(bulk));
+	for(int i = 0; i < 4; i++)
+		ASSERT_TRUE(competitor.send_packet("bulk", bulk, sizeof(bulk), PRIO_HIGH));
+
+	ASSERT_TRUE(state.publish(uint32_t(1)));
+
+	for(int i = 0; i < 10000 && publisher.get_stats().arbitration_losses == 0; i++)
+		bus.run(1);
+	ASSERT_GT(publisher.get_stats().arbitration_losses, 0u);
+	ASSERT_EQ(publisher.get_stats().frames_sent, 0u);
+
+	// The frame lost arbitration, but was never sent, so it is replaced.
+	ASSERT_TRUE(state.publish(uint32_t(2)));
+	EXPECT_EQ(state.get_replaced(), 1u);
+
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	uint32_t value = 0;
+	ASSERT_TRUE(cache.read(value));
+	EXPECT_EQ(value, 2u);
+	EXPECT_EQ(cache.get_updates(), 1u);
+	EXPECT_EQ(publisher.get_stats().frames_sent, 1u);
+}
+
+TEST(StatePublisher, ConflatesBurstWhileBusIsBusy) {
+	burst_result_t plain = run_burst(false);
+	burst_result_t conflated = run_burst(true);
+
+	EXPECT_EQ(plain.frames_sent, 50u);
+	EXPECT_EQ(plain.updates, 50u);
+
+	// Updates queued behind the bulk data replace each other.
+	EXPECT_LT(conflated.frames_sent, plain.frames_sent / 4);
+	EXPECT_LT(conflated.busy_steps, plain.busy_steps);
+	EXPECT_EQ(conflated.updates, conflated.frames_sent);
+
+	// Either way, the receiver ends up with the latest value.
+	EXPECT_EQ(plain.last_value, 49u);
+	EXPECT_EQ(conflated.last_value, 49u);
+
+	RecordProperty("plain_frames", int(plain.frames_sent));
+	RecordProperty("conflated_frames", int(conflated.frames_sent));
+	RecordProperty("saved_chars", int(plain.busy_steps - conflated.busy_steps));
+}
+
+TEST(StateCache, ReaderFollowsWriter) {
+	constexpr uint32_t UPDATES = 200000;
+
+	Test_Dispatcher dispatcher;
+	State_Cache<5 * sizeof(uint32_t)> cache("state/vector");
+	ASSERT_TRUE(dispatcher.add_state_cache(cache));
+
+	// Stands in for the receiver thread. Every word of value i is i, and
+	// the length alternates, so that torn values show up either way.
+	std::thread writer([&] {
+		for(uint32_t i = 1; i <= UPDATES; i++) {
+			uint32_t value[5] = { i, i, i, i, i };
+			dispatcher.dispatch_message("state/vector", value, (i & 1) ? sizeof(value) : 4 * sizeof(uint32_t));
+		}
+	});
+
+	uint32_t last = 0;
+	int errors = 0;
+	int reads = 0;
+	while(last < UPDATES) {
+		uint32_t value[5] = {};
+		uint32_t update = 0;
+		size_t length = cache.read(value, sizeof(value), &update);
+		reads++;
+
+		if(update == 0) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		size_t expected_length = (update & 1) ? sizeof(value) : 4 * sizeof(uint32_t);
+		if(update < last || length != expected_length)
+			errors++;
+		for(size_t i = 0; i < length / sizeof(uint32_t); i++) {
+			if(value[i] != update)
+				errors++;
+		}
+
+		last = update;
+	}
+	writer.join();
+
+	EXPECT_EQ(errors, 0);
+	EXPECT_EQ(last, UPDATES);
+	EXPECT_GT(reads, 1);
+}
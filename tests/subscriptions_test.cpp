@@ -0,0 +1,102 @@
+/*
+ * subscriptions_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/Subscriptions.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+void count_call(void *context, const char *topic, const void *data, size_t length) {
+	(void)topic;
+	(void)data;
+	(void)length;
+
+	(*reinterpret_cast<int*>(context))++;
+}
+
+topic_filter_result_t filter(const Subscription_Table &table, const char *topic) {
+	topic_filter_t state;
+	Subscription_Table::filter_start(state);
+
+	for(const char *c = topic;; c++) {
+		topic_filter_result_t result = table.filter_step(state, *c);
+		if(result != TOPIC_FILTER_PENDING)
+			return result;
+	}
+}
+
+} /* namespace */
+
+TEST(Subscriptions, ChurnReusesEntries) {
+	Subscription_Table table;
+	int calls = 0;
+
+	ASSERT_TRUE(table.subscribe("keep", count_call, &calls));
+
+	// Far more subscriptions than the table holds, one at a time.
+	std::vector<std::string> patterns;
+	for(int i = 0; i < 10 * FURCOM_SUBSCRIPTION_NUM; i++)
+		patterns.push_back("topic/" + std::to_string(i));
+
+	for(auto &pattern : patterns) {
+		ASSERT_TRUE(table.subscribe(pattern.c_str(), count_call, &calls)) << pattern;
+		EXPECT_EQ(table.dispatch(pattern.c_str(), nullptr, 0), 1);
+		ASSERT_TRUE(table.unsubscribe(pattern.c_str(), count_call, &calls));
+		EXPECT_EQ(table.dispatch(pattern.c_str(), nullptr, 0), 0);
+	}
+
+	EXPECT_EQ(table.dispatch("keep", nullptr, 0), 1);
+}
+
+TEST(Subscriptions, FillsUpAgainAfterRemoval) {
+	Subscription_Table table;
+	int calls = 0;
+
+	std::vector<std::string> patterns;
+	for(int i = 0; i < FURCOM_SUBSCRIPTION_NUM; i++)
+		patterns.push_back("topic/" + std::to_string(i));
+
+	for(int round = 0; round < 3; round++) {
+		for(int i = 0; i < FURCOM_SUBSCRIPTION_NUM - 1; i++)
+			ASSERT_TRUE(table.subscribe(patterns[i].c_str(), count_call, &calls)) << round;
+		EXPECT_FALSE(table.subscribe(patterns.back().c_str(), count_call, &calls));
+
+		for(int i = 0; i < FURCOM_SUBSCRIPTION_NUM - 1; i++)
+			EXPECT_EQ(table.dispatch(patterns[i].c_str(), nullptr, 0), 1);
+
+		for(int i = 0; i < FURCOM_SUBSCRIPTION_NUM - 1; i++)
+			ASSERT_TRUE(table.unsubscribe(patterns[i].c_str(), count_call, &calls));
+	}
+}
+
+TEST(Subscriptions, PrefixRemovalKeepsOtherPrefixes) {
+	Subscription_Table table;
+	int short_calls = 0, long_calls = 0;
+
+	ASSERT_TRUE(table.subscribe("a/*", count_call, &short_calls));
+	ASSERT_TRUE(table.subscribe("a/b/*", count_call, &long_calls));
+	ASSERT_TRUE(table.subscribe("a/b/*", count_call, &short_calls));
+
+	ASSERT_TRUE(table.unsubscribe("a/b/*", count_call, &short_calls));
+	EXPECT_EQ(table.dispatch("a/b/c", nullptr, 0), 2);
+	EXPECT_EQ(filter(table, "a/b/c"), TOPIC_FILTER_PASS);
+
+	ASSERT_TRUE(table.unsubscribe("a/*", count_call, &short_calls));
+	EXPECT_EQ(table.dispatch("a/x", nullptr, 0), 0);
+	EXPECT_EQ(filter(table, "a/x"), TOPIC_FILTER_REJECT);
+	EXPECT_EQ(filter(table, "a/b/c"), TOPIC_FILTER_PASS);
+
+	ASSERT_TRUE(table.unsubscribe("a/b/*", count_call, &long_calls));
+	EXPECT_EQ(filter(table, "a/b/c"), TOPIC_FILTER_REJECT);
+	EXPECT_EQ(short_calls, 1);
+	EXPECT_EQ(long_calls, 1);
+}
@@ -0,0 +1,144 @@
+/*
+ * topic_dictionary_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/BusSim.h>
+#include <FurComs/TopicDictionary.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+void record_packet(void *context, const char *topic, const void *data, size_t length) {
+	auto packets = reinterpret_cast<std::vector<std::string>*>(context);
+
+	packets->push_back(std::string(topic) + "=" +
+			std::string(reinterpret_cast<const char*>(data), length));
+}
+
+//! on_rx_id has no context pointer.
+std::vector<topic_id_t> received_ids;
+
+void record_id(topic_id_t id, const void *data, size_t length) {
+	(void)data; (void)length;
+	received_ids.push_back(id);
+}
+
+}
+
+TEST(TopicDictionary, FindsIDsByTopic) {
+	Topic_Dictionary dictionary;
+
+	std::string long_topic(200, 'x');
+	ASSERT_TRUE(dictionary.add(1, "led/brightness", 14, false));
+	ASSERT_TRUE(dictionary.add(2, "led/mode", 8, false));
+	ASSERT_TRUE(dictionary.add(3, long_topic.c_str(), long_topic.size(), true));
+
+	topic_id_t id = 0;
+	ASSERT_TRUE(dictionary.find_id("led/mode", id));
+	EXPECT_EQ(id, 2u);
+	ASSERT_TRUE(dictionary.find_id("led/brightness", id));
+	EXPECT_EQ(id, 1u);
+	ASSERT_TRUE(dictionary.find_id(long_topic.c_str(), id));
+	EXPECT_EQ(id, 3u);
+
+	EXPECT_FALSE(dictionary.find_id("led", id));
+	EXPECT_FALSE(dictionary.find_id("led/mode/x", id));
+	EXPECT_FALSE(dictionary.find_id("", id));
+}
+
+TEST(TopicDictionary, EncodesVarintIDs) {
+	struct {
+		topic_id_t id;
+		size_t length;
+	} cases[] = {
+		{ 0, 1 }, { 127, 1 }, { 128, 2 }, { 300, 2 },
+		{ (1 << 14) - 1, 2 }, { 1 << 14, 3 }, { FURCOM_TOPIC_ID_MAX, 3 },
+	};
+
+	for(auto &c : cases) {
+		uint8_t encoded[4] = {};
+		ASSERT_EQ(Topic_Dictionary::encode_id(c.id, encoded), c.length) << c.id;
+
+		topic_id_t decoded = 0;
+		EXPECT_EQ(Topic_Dictionary::decode_id(encoded, sizeof(encoded), decoded), c.length) << c.id;
+		EXPECT_EQ(decoded, c.id);
+
+		// Every byte but the last announces another one.
+		if(c.length > 1) {
+			EXPECT_EQ(Topic_Dictionary::decode_id(encoded, c.length - 1, decoded), 0u) << c.id;
+		}
+	}
+
+	// IDs take at most three bytes.
+	const uint8_t too_long[] = { 0x80, 0x80, 0x80, 0x01 };
+	topic_id_t decoded = 0;
+	EXPECT_EQ(Topic_Dictionary::decode_id(too_long, sizeof(too_long), decoded), 0u);
+
+	Topic_Dictionary dictionary;
+	EXPECT_TRUE(dictionary.add(FURCOM_TOPIC_ID_MAX, "led/max", 7, false));
+	EXPECT_FALSE(dictionary.add(FURCOM_TOPIC_ID_MAX + 1, "led/over", 8, false));
+}
+
+TEST(TopicDictionary, RejectsReassignment) {
+	Topic_Dictionary dictionary;
+
+	ASSERT_TRUE(dictionary.add(1, "led/mode", 8, false));
+	// The same pair may be announced again.
+	EXPECT_TRUE(dictionary.add(1, "led/mode", 8, true));
+
+	EXPECT_FALSE(dictionary.add(1, "led/brightness", 14, false));
+	EXPECT_FALSE(dictionary.add(2, "led/mode", 8, false));
+	// Only the length given counts, "led/mode" is not "led".
+	EXPECT_TRUE(dictionary.add(2, "led/mode", 3, true));
+
+	EXPECT_STREQ(dictionary.find_topic(1), "led/mode");
+	EXPECT_STREQ(dictionary.find_topic(2), "led");
+	EXPECT_EQ(dictionary.find_topic(3), nullptr);
+}
+
+TEST(TopicDictionary, LearnsAnnouncedIDs) {
+	Bus_Sim bus;
+	Sim_Node<> sender(bus, 1);
+	Sim_Node<> receiver(bus, 2);
+
+	std::vector<std::string> packets;
+	ASSERT_TRUE(receiver.subscribe("led/mode", record_packet, &packets));
+	received_ids.clear();
+	receiver.on_rx_id = record_id;
+
+	// Takes two varint bytes.
+	const char *topic = "led/mode";
+	ASSERT_TRUE(sender.add_topic_id(200, topic));
+	sender.set_topic_ids(true);
+
+	// Unknown IDs still reach on_rx_id, but no subscription.
+	ASSERT_TRUE(sender.send_packet("led/mode", "a", 1));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	EXPECT_TRUE(packets.empty());
+	EXPECT_EQ(received_ids, std::vector<topic_id_t>({ 200 }));
+	EXPECT_EQ(receiver.find_topic(200), nullptr);
+
+	ASSERT_TRUE(sender.announce_topic_id(200));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	// Copied out of the RX buffer, which is reused right after.
+	ASSERT_STREQ(receiver.find_topic(200), topic);
+	EXPECT_NE(receiver.find_topic(200), topic);
+
+	ASSERT_TRUE(sender.send_packet("led/mode", "b", 1));
+	ASSERT_TRUE(bus.run_until_idle(100000));
+
+	EXPECT_EQ(packets, std::vector<std::string>({ "led/mode=b" }));
+	EXPECT_EQ(received_ids, std::vector<topic_id_t>({ 200, 200 }));
+
+	receiver.on_rx_id = nullptr;
+}
@@ -0,0 +1,180 @@
+/*
+ * tx_queue_stress_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/SLIP.h>
+#include <FurComs/TXQueue.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+constexpr int PRODUCERS = 4;
+constexpr uint32_t FRAMES = 20000;
+constexpr size_t MAX_DATA = 60;
+constexpr size_t HEADER = 6;
+
+struct producer_t {
+	int id;
+	//! Completions so far, checked against the frame the consumer released.
+	std::atomic<uint32_t> done_count;
+	std::atomic<uint32_t> expected_done;
+	std::atomic<int> order_errors;
+};
+
+void handle_done(void *context, bool sent) {
+	auto producer = reinterpret_cast<producer_t*>(context);
+
+	uint32_t count = producer->done_count.load(std::memory_order_relaxed);
+	if(!sent || count != producer->expected_done.load(std::memory_order_relaxed))
+		producer->order_errors++;
+	producer->done_count.store(count + 1, std::memory_order_release);
+}
+
+size_t data_length(int producer, uint32_t sequence) {
+	return 1 + (sequence * 7 + producer * 13) % MAX_DATA;
+}
+
+//! Producer ID, sequence and rewrite count, followed by data derived from all three.
+size_t make_frame(uint8_t *out, int producer, uint32_t sequence, uint8_t version) {
+	size_t length = data_length(producer, sequence);
+
+	out[0] = producer;
+	memcpy(out + 1, &sequence, 4);
+	out[5] = version;
+	for(size_t k = 0; k < length; k++)
+		out[HEADER + k] = uint8_t(sequence * 31 + version * 7 + k);
+
+	return HEADER + length;
+}
+
+void produce(TX_Queue &queue, producer_t &producer, bool rewrite) {
+	uint8_t frame[HEADER + MAX_DATA];
+
+	for(uint32_t sequence = 0; sequence < FRAMES;) {
+		size_t length = make_frame(frame, producer.id, sequence, 0);
+
+		tx_reservation_t reservation;
+		if(!queue.reserve(reservation, 2*length, 2*length, handle_done, &producer)) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		uint32_t position = reservation.start;
+		TX_Queue::add_data(reservation, frame, length);
+		queue.commit(reservation);
+
+		// Rewrite the frame while the consumer may be looking at it.
+		for(uint8_t version = 1; rewrite && version < 4; version++) {
+			if(producer.done_count.load(std::memory_order_acquire) > sequence)
+				break;
+
+			length = make_frame(frame, producer.id, sequence, version);
+			if(!queue.reopen(reservation, position, slip_encoded_length(frame, length)))
+				break;
+
+			TX_Queue::add_data(reservation, frame, length);
+			queue.commit(reservation);
+		}
+
+		sequence++;
+	}
+}
+
+} /* namespace */
+
+TEST(TXQueueStress, ProducersAndConsumer) {
+	alignas(8) static uint8_t storage[512];
+	TX_Queue queue;
+	queue.set_storage(storage, sizeof(storage));
+
+	producer_t producers[PRODUCERS];
+	for(int p = 0; p < PRODUCERS; p++) {
+		producers[p].id = p;
+		producers[p].done_count = 0;
+		producers[p].expected_done = 0;
+		producers[p].order_errors = 0;
+	}
+
+	std::vector<std::thread> threads;
+	for(int p = 0; p < PRODUCERS; p++)
+		threads.emplace_back(produce, std::ref(queue), std::ref(producers[p]), p == 0);
+
+	uint32_t next[PRODUCERS] = {};
+	uint32_t rewritten = 0;
+	int errors = 0;
+
+	for(uint32_t received = 0; received < PRODUCERS * FRAMES && errors == 0;) {
+		const uint8_t *ptr;
+		size_t length;
+		if(!queue.peek_frame(ptr, length)) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		uint8_t decoded[HEADER + MAX_DATA + 1];
+		char *out = reinterpret_cast<char*>(decoded);
+		bool escaped = false;
+		size_t consumed = slip_decode_span(ptr, length, out,
+				reinterpret_cast<char*>(decoded) + sizeof(decoded), escaped);
+
+		if(consumed != length - 1 || ptr[length - 1] != FURCOM_END) {
+			ADD_FAILURE() << "Frame not terminated";
+			errors++;
+			break;
+		}
+
+		int producer = decoded[0];
+		uint32_t sequence;
+		memcpy(&sequence, decoded + 1, 4);
+		uint8_t frame[HEADER + MAX_DATA];
+
+		if(producer >= PRODUCERS || sequence != next[producer]) {
+			ADD_FAILURE() << "Frame out of order";
+			errors++;
+			break;
+		}
+
+		size_t expected = make_frame(frame, producer, sequence, decoded[5]);
+		if(size_t(out - reinterpret_cast<char*>(decoded)) != expected
+				|| memcmp(decoded, frame, expected) != 0) {
+			ADD_FAILURE() << "Frame torn by a rewrite";
+			errors++;
+			break;
+		}
+		if(decoded[5] != 0)
+			rewritten++;
+
+		producers[producer].expected_done.store(sequence, std::memory_order_relaxed);
+		queue.release_frame();
+
+		next[producer]++;
+		received++;
+	}
+
+	for(auto &thread : threads)
+		thread.join();
+
+	ASSERT_EQ(errors, 0);
+	for(auto &producer : producers) {
+		EXPECT_EQ(producer.done_count.load(), FRAMES);
+		EXPECT_EQ(producer.order_errors.load(), 0);
+	}
+
+	// Only padding may be left.
+	EXPECT_EQ(queue.get_packet_count(), 0);
+	EXPECT_FALSE(queue.has_frame());
+	queue.release_dropped();
+	EXPECT_GE(queue.get_free_space(), queue.max_safe_reservation());
+
+	RecordProperty("rewritten", int(rewritten));
+}
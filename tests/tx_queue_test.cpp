@@ -0,0 +1,166 @@
+/*
+ * tx_queue_test.cpp
+ *
+ *  Created on: 16 Oct 2026
+ */
+
+#include <FurComs/TXQueue.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace TEF::FurComs;
+
+namespace {
+
+//! Queue a frame, returning its position.
+uint32_t queue_frame(TX_Queue &queue, const std::string &data) {
+	tx_reservation_t reservation;
+	EXPECT_TRUE(queue.reserve(reservation, data.size(), data.size()));
+
+	uint32_t position = reservation.start;
+	TX_Queue::add_data(reservation, data.data(), data.size());
+	queue.commit(reservation);
+
+	return position;
+}
+
+//! Rewrite a queued frame, returning false if it could not be reopened.
+bool rewrite_frame(TX_Queue &queue, uint32_t position, const std::string &data) {
+	tx_reservation_t reservation;
+	if(!queue.reopen(reservation, position, data.size()))
+		return false;
+
+	TX_Queue::add_data(reservation, data.data(), data.size());
+	queue.commit(reservation);
+
+	return true;
+}
+
+void count_done(void *context, bool sent) {
+	auto counts = reinterpret_cast<int*>(context);
+	counts[sent ? 1 : 0]++;
+}
+
+//! Frame data without its FURCOM_END.
+std::string frame_data(const uint8_t *ptr, size_t length) {
+	return std::string(reinterpret_cast<const char*>(ptr), length - 1);
+}
+
+class TXQueueTest : public ::testing::Test {
+protected:
+	alignas(8) uint8_t storage[256];
+	TX_Queue queue;
+
+	void SetUp() override {
+		queue.set_storage(storage, sizeof(storage));
+	}
+};
+
+} /* namespace */
+
+TEST_F(TXQueueTest, UnpeekedFrameCanBeReopened) {
+	queue_frame(queue, "head");
+	uint32_t second = queue_frame(queue, "second");
+
+	const uint8_t *ptr;
+	size_t length;
+	ASSERT_TRUE(queue.peek_frame(ptr, length));
+
+	ASSERT_TRUE(queue.peek_next(ptr, length));
+	EXPECT_EQ(frame_data(ptr, length), "second");
+	// Claimed while looked at.
+	EXPECT_FALSE(rewrite_frame(queue, second, "nope"));
+
+	queue.unpeek_next();
+	EXPECT_TRUE(rewrite_frame(queue, second, "again"));
+
+	ASSERT_TRUE(queue.peek_next(ptr, length));
+	EXPECT_EQ(frame_data(ptr, length), "again");
+}
+
+TEST_F(TXQueueTest, DropSkipsFramesBeingWritten) {
+	int counts[2] = {};
+
+	tx_reservation_t writing;
+	ASSERT_TRUE(queue.reserve(writing, 4, 32, count_done, counts));
+	for(int i = 0; i < 3; i++) {
+		tx_reservation_t reservation;
+		ASSERT_TRUE(queue.reserve(reservation, 4, 4, count_done, counts));
+		TX_Queue::add_data(reservation, "drop", 4);
+		queue.commit(reservation);
+	}
+	ASSERT_EQ(queue.get_packet_count(), 3);
+
+	// Frames behind the open reservation are dropped, and uncounted right away.
+	EXPECT_EQ(queue.drop_frames(0), 3);
+	EXPECT_EQ(queue.get_packet_count(), 0);
+
+	// The skipped block keeps its size, even though it could shrink.
+	TX_Queue::add_data(writing, "keep", 4);
+	queue.commit(writing);
+	EXPECT_EQ(queue.get_packet_count(), 1);
+	uint32_t next = queue_frame(queue, "next");
+
+	const uint8_t *ptr;
+	size_t length;
+	ASSERT_TRUE(queue.peek_frame(ptr, length));
+	EXPECT_EQ(frame_data(ptr, length), "keep");
+	queue.release_frame();
+
+	// The dropped frames are released on the way to the next one.
+	ASSERT_TRUE(queue.peek_frame(ptr, length));
+	EXPECT_EQ(frame_data(ptr, length), "next");
+	EXPECT_EQ(counts[0], 3);
+	EXPECT_EQ(counts[1], 1);
+	EXPECT_EQ(queue.get_packet_count(), 1);
+	EXPECT_FALSE(rewrite_frame(queue, next, "late"));
+
+	queue.release_frame();
+	EXPECT_EQ(queue.get_packet_count(), 0);
+	EXPECT_FALSE(queue.has_frame());
+}
+
+TEST_F(TXQueueTest, HasFrameDoesNotReleaseDroppedFrames) {
+	int counts[2] = {};
+
+	// Enough to leave less space at the end than the dropped frames free.
+	std::string data(40, 'x');
+	for(int i = 0; i < 2; i++) {
+		tx_reservation_t reservation;
+		ASSERT_TRUE(queue.reserve(reservation, data.size(), data.size(), count_done, counts));
+		TX_Queue::add_data(reservation, data.data(), data.size());
+		queue.commit(reservation);
+	}
+	uint32_t last = queue_frame(queue, data);
+	ASSERT_EQ(queue.drop_frames(0), 3);
+	size_t free_space = queue.get_free_space();
+
+	// Looked past, but still holding their space.
+	EXPECT_FALSE(queue.has_frame());
+	EXPECT_EQ(counts[0], 0);
+	EXPECT_EQ(queue.get_free_space(), free_space);
+
+	queue.release_dropped();
+	EXPECT_EQ(counts[0], 2);
+	EXPECT_GT(queue.get_free_space(), free_space);
+	EXPECT_FALSE(rewrite_frame(queue, last, "late"));
+}
+
+TEST_F(TXQueueTest, LongestFrameFitsOnceEmpty) {
+	const uint8_t *ptr;
+	size_t length;
+
+	// Leaves the queue standing in the middle of the ring.
+	queue_frame(queue, std::string(100, 'a'));
+	ASSERT_TRUE(queue.peek_frame(ptr, length));
+	queue.release_frame();
+
+	std::string longest(queue.max_reservation(), 'b');
+	queue_frame(queue, longest);
+	ASSERT_TRUE(queue.peek_frame(ptr, length));
+	EXPECT_EQ(frame_data(ptr, length), longest);
+	queue.release_frame();
+	EXPECT_EQ(queue.get_packet_count(), 0);
+}